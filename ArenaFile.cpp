@@ -0,0 +1,362 @@
+#include "ArenaFile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+namespace ArenaFile {
+
+namespace {
+
+const char magic[8] = {'R', 'C', 'A', 'R', 'E', 'N', 'A', '\0'};
+constexpr quint32 byteOrderMark = 0x01020304;
+constexpr int headerSize = 64;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 nodeCount;
+    quint32 edgeCount;
+    quint32 sectionCount;
+    qint32 neighbours;
+    quint32 costModel;
+    char reserved[headerSize - 36];
+};
+static_assert(sizeof(Header) == headerSize, "arena header layout");
+
+struct SectionEntry {
+    quint32 id;
+    quint32 elementSize;
+    quint64 offset;
+    quint64 count;
+};
+static_assert(sizeof(SectionEntry) == 24, "arena section table layout");
+
+quint64 alignUp(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+// Collects the arrays of a file before anything is written
+class Writer
+{
+public:
+    template<typename T>
+    void add(Section id, const T* data, size_t count)
+    {
+        sections.push_back({id, sizeof(T), reinterpret_cast<const char*>(data), count});
+    }
+
+    template<typename T>
+    void add(Section id, const std::vector<T>& data)
+    {
+        add(id, data.data(), data.size());
+    }
+
+    QByteArray layout(const Header& header) const
+    {
+        quint64 offset = alignUp(headerSize + sections.size() * sizeof(SectionEntry));
+        QByteArray out(headerSize, '\0');
+        Header h = header;
+        h.sectionCount = static_cast<quint32>(sections.size());
+        memcpy(out.data(), &h, sizeof(h));
+
+        for (const Pending& section : sections) {
+            const SectionEntry entry = {section.id, section.elementSize, offset, section.count};
+            out.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            offset = alignUp(offset + section.count * section.elementSize);
+        }
+        for (const Pending& section : sections) {
+            out.append(QByteArray(alignUp(out.size()) - out.size(), '\0'));
+            out.append(section.data, static_cast<qsizetype>(section.count * section.elementSize));
+        }
+        // Empty sections at the end point at the aligned end of the file
+        out.append(QByteArray(alignUp(out.size()) - out.size(), '\0'));
+        return out;
+    }
+
+private:
+    struct Pending {
+        Section id;
+        quint32 elementSize;
+        const char* data;
+        quint64 count;
+    };
+    std::vector<Pending> sections;
+};
+
+void packStrings(const std::vector<QString>& strings, std::vector<quint32>& offsets, QByteArray& chars)
+{
+    offsets.assign(1, 0);
+    offsets.reserve(strings.size() + 1);
+    for (const QString& string : strings) {
+        chars.append(string.toUtf8());
+        offsets.push_back(static_cast<quint32>(chars.size()));
+    }
+}
+
+// A section of a mapped file, bounds-checked against it
+struct View {
+    const char* data = nullptr;
+    quint64 count = 0;
+    quint32 elementSize = 0;
+
+    template<typename T>
+    const T* as(quint64 expectedCount) const
+    {
+        return data && elementSize == sizeof(T) && count == expectedCount
+            ? reinterpret_cast<const T*>(data) : nullptr;
+    }
+};
+
+bool fail(QString* error, const QString& message)
+{
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+bool unpackStrings(const View& offsetView, const View& charView, quint64 count, std::vector<QString>& strings)
+{
+    const quint32* offsets = offsetView.as<quint32>(count + 1);
+    const char* chars = charView.as<char>(charView.count);
+    if (!offsets || (!chars && charView.count > 0) || offsets[0] != 0 || offsets[count] != charView.count) {
+        return false;
+    }
+
+    strings.clear();
+    strings.reserve(count);
+    for (quint64 i = 0; i < count; ++i) {
+        if (offsets[i + 1] < offsets[i]) {
+            return false;
+        }
+        strings.push_back(QString::fromUtf8(chars + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    return true;
+}
+
+} // namespace
+
+bool save(const QString& path, const PlannerGraph& graph, const Info& info,
+          bool withTables, QString* error)
+{
+    const NavGraph& nav = graph.graph;
+    const quint64 nodeCount = nav.nodeCount();
+
+    Writer writer;
+    writer.add(NodeX, nav.x);
+    writer.add(NodeY, nav.y);
+    writer.add(NodeElevation, nav.elevation);
+    writer.add(NodePoints, nav.points);
+    writer.add(NodeKinds, nav.kind);
+
+    std::vector<quint32> idOffsets;
+    std::vector<quint32> typeOffsets;
+    QByteArray idChars;
+    QByteArray typeChars;
+    packStrings(graph.nodeIds, idOffsets, idChars);
+    packStrings(graph.nodeTypes, typeOffsets, typeChars);
+    writer.add(NodeIdOffsets, idOffsets);
+    writer.add(NodeIdChars, idChars.constData(), idChars.size());
+    writer.add(NodeTypeOffsets, typeOffsets);
+    writer.add(NodeTypeChars, typeChars.constData(), typeChars.size());
+
+    std::vector<int> edgeOffsets = nav.edgeOffsets;
+    if (edgeOffsets.empty()) {
+        edgeOffsets.assign(nodeCount + 1, 0);
+    }
+    writer.add(EdgeOffsets, edgeOffsets);
+    writer.add(EdgeTargets, nav.edgeTargets);
+    writer.add(EdgeCosts, nav.edgeCosts);
+    writer.add(EdgeDistances, nav.edgeDistances);
+
+    // Slots of a live table can be spaced wider than keyCount(); store them packed
+    std::shared_ptr<const DistanceTable> table;
+    std::vector<double> keyCosts;
+    std::shared_ptr<const Landmarks> landmarks;
+    if (withTables && nodeCount > 0) {
+        table = graph.keyDistances();
+        const int keys = table->keyCount();
+        keyCosts.reserve(static_cast<size_t>(keys) * keys);
+        for (int from = 0; from < keys; ++from) {
+            for (int to = 0; to < keys; ++to) {
+                keyCosts.push_back(table->costBySlot(from, to));
+            }
+        }
+        writer.add(KeyNodes, table->keyNodes());
+        writer.add(KeyCosts, keyCosts);
+        writer.add(KeyNextEdges, table->nextEdges());
+
+        landmarks = graph.landmarks();
+        writer.add(LandmarkNodes, landmarks->landmarkNodes());
+        writer.add(LandmarkCostsFrom, landmarks->costsFromLandmarks());
+        writer.add(LandmarkCostsTo, landmarks->costsToLandmarks());
+    }
+
+    Header header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = Version;
+    header.byteOrder = byteOrderMark;
+    header.nodeCount = static_cast<quint32>(nodeCount);
+    header.edgeCount = static_cast<quint32>(nav.edgeCount());
+    header.neighbours = info.neighbours;
+    header.costModel = static_cast<quint32>(info.costModel);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(error, file.errorString());
+    }
+    file.write(writer.layout(header));
+    if (!file.commit()) {
+        return fail(error, file.errorString());
+    }
+    return true;
+}
+
+bool load(const QString& path, PlannerGraph& graph, Info& info, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(error, file.errorString());
+    }
+
+    const qint64 size = file.size();
+    if (size < headerSize) {
+        return fail(error, QStringLiteral("Not an arena file"));
+    }
+    const uchar* mapped = file.map(0, size);
+    if (!mapped) {
+        return fail(error, file.errorString());
+    }
+    const char* base = reinterpret_cast<const char*>(mapped);
+
+    Header header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        return fail(error, QStringLiteral("Not an arena file"));
+    }
+    if (header.byteOrder != byteOrderMark || header.version != Version) {
+        return fail(error, QStringLiteral("Arena file version %1 is not supported").arg(header.version));
+    }
+    if (headerSize + quint64(header.sectionCount) * sizeof(SectionEntry) > quint64(size)) {
+        return fail(error, QStringLiteral("Arena file is truncated"));
+    }
+
+    std::map<quint32, View> sections;
+    for (quint32 i = 0; i < header.sectionCount; ++i) {
+        SectionEntry entry;
+        memcpy(&entry, base + headerSize + i * sizeof(SectionEntry), sizeof(entry));
+        if (entry.offset % 8 != 0 || entry.elementSize == 0 || entry.offset > quint64(size)
+            || entry.count > (quint64(size) - entry.offset) / entry.elementSize) {
+            return fail(error, QStringLiteral("Arena file is truncated"));
+        }
+        sections[entry.id] = {base + entry.offset, entry.count, entry.elementSize};
+    }
+
+    const quint64 nodeCount = header.nodeCount;
+    const quint64 edgeCount = header.edgeCount;
+    const double* x = sections[NodeX].as<double>(nodeCount);
+    const double* y = sections[NodeY].as<double>(nodeCount);
+    const double* elevation = sections[NodeElevation].as<double>(nodeCount);
+    const int* points = sections[NodePoints].as<int>(nodeCount);
+    const NodeKind* kinds = sections[NodeKinds].as<NodeKind>(nodeCount);
+    const int* edgeOffsets = sections[EdgeOffsets].as<int>(nodeCount + 1);
+    const int* edgeTargets = sections[EdgeTargets].as<int>(edgeCount);
+    const double* edgeCosts = sections[EdgeCosts].as<double>(edgeCount);
+    const double* edgeDistances = sections[EdgeDistances].as<double>(edgeCount);
+    const bool hasEdges = edgeCount == 0 || (edgeTargets && edgeCosts && edgeDistances);
+    if ((nodeCount > 0 && (!x || !y || !elevation || !points || !kinds)) || !edgeOffsets || !hasEdges) {
+        return fail(error, QStringLiteral("Arena file is missing node or edge data"));
+    }
+
+    // Everything the planners index with is checked once here
+    if (edgeOffsets[0] != 0 || quint64(edgeOffsets[nodeCount]) != edgeCount) {
+        return fail(error, QStringLiteral("Arena file has inconsistent edges"));
+    }
+    for (quint64 i = 0; i < nodeCount; ++i) {
+        if (edgeOffsets[i + 1] < edgeOffsets[i] || static_cast<quint8>(kinds[i]) > quint8(NodeKind::CommTower)
+            || !std::isfinite(x[i]) || !std::isfinite(y[i]) || !std::isfinite(elevation[i])) {
+            return fail(error, QStringLiteral("Arena file has inconsistent nodes"));
+        }
+    }
+    for (quint64 e = 0; e < edgeCount; ++e) {
+        // Blocked edges are stored as infinity; NaN or negative costs would
+        // break every search's ordering
+        if (edgeTargets[e] < 0 || quint64(edgeTargets[e]) >= nodeCount
+            || !(edgeCosts[e] >= 0.0) || !(edgeDistances[e] >= 0.0)) {
+            return fail(error, QStringLiteral("Arena file has inconsistent edges"));
+        }
+    }
+
+    std::vector<QString> nodeIds;
+    std::vector<QString> nodeTypes;
+    if (!unpackStrings(sections[NodeIdOffsets], sections[NodeIdChars], nodeCount, nodeIds)
+        || !unpackStrings(sections[NodeTypeOffsets], sections[NodeTypeChars], nodeCount, nodeTypes)) {
+        return fail(error, QStringLiteral("Arena file has inconsistent node names"));
+    }
+
+    NavGraph& nav = graph.graph;
+    nav.x.assign(x, x + nodeCount);
+    nav.y.assign(y, y + nodeCount);
+    nav.elevation.assign(elevation, elevation + nodeCount);
+    nav.points.assign(points, points + nodeCount);
+    nav.kind.assign(kinds, kinds + nodeCount);
+    nav.edgeOffsets.assign(edgeOffsets, edgeOffsets + nodeCount + 1);
+    nav.edgeTargets.assign(edgeTargets, edgeTargets + edgeCount);
+    nav.edgeCosts.assign(edgeCosts, edgeCosts + edgeCount);
+    nav.edgeDistances.assign(edgeDistances, edgeDistances + edgeCount);
+
+    graph.nodeIds = std::move(nodeIds);
+    graph.nodeTypes = std::move(nodeTypes);
+    graph.nodeIndex.clear();
+    graph.nodeIndex.reserve(nodeCount);
+    for (quint64 i = 0; i < nodeCount; ++i) {
+        graph.nodeIndex.emplace(graph.nodeIds[i], static_cast<int>(i));
+    }
+    graph.spatialIndex.build(nav.x, nav.y);
+
+    // A stored table that does not fit the graph is dropped and built on
+    // first use
+    std::shared_ptr<DistanceTable> table;
+    const View& keyView = sections[KeyNodes];
+    const int* keyNodes = keyView.as<int>(keyView.count);
+    if (keyNodes) {
+        const quint64 keys = keyView.count;
+        const double* keyCosts = sections[KeyCosts].as<double>(keys * keys);
+        const int* nextEdges = sections[KeyNextEdges].as<int>(keys * nodeCount);
+        if (keyCosts && nextEdges) {
+            table = std::make_shared<DistanceTable>();
+            if (!table->restore(nav, std::vector<int>(keyNodes, keyNodes + keys), keyCosts, nextEdges)) {
+                table.reset();
+            }
+        }
+    }
+    graph.setKeyDistances(table);
+
+    std::shared_ptr<Landmarks> landmarks;
+    const View& landmarkView = sections[LandmarkNodes];
+    const int* landmarkNodes = landmarkView.as<int>(landmarkView.count);
+    if (landmarkNodes) {
+        const quint64 landmarkCount = landmarkView.count;
+        const double* costsFrom = sections[LandmarkCostsFrom].as<double>(landmarkCount * nodeCount);
+        const double* costsTo = sections[LandmarkCostsTo].as<double>(landmarkCount * nodeCount);
+        if (costsFrom && costsTo) {
+            landmarks = std::make_shared<Landmarks>();
+            if (!landmarks->restore(nav, std::vector<int>(landmarkNodes, landmarkNodes + landmarkCount),
+                                    costsFrom, costsTo)) {
+                landmarks.reset();
+            }
+        }
+    }
+    graph.setLandmarks(landmarks);
+
+    info.neighbours = header.neighbours;
+    info.costModel = header.costModel == quint32(EdgeCostModel::Distance)
+        ? EdgeCostModel::Distance : EdgeCostModel::Elevation;
+    return true;
+}
+
+} // namespace ArenaFile
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include "PlannerGraph.h"
+
+// Binary arena: a PlannerGraph as flat arrays, so loading is one mapping
+// and one copy per array instead of parsing a QVariantMap per node.
+//
+//   header    64 bytes: "RCARENA\0", u32 version, u32 byte order mark
+//             0x01020304, u32 node count, u32 edge count, u32 section
+//             count, i32 neighbours (0: explicit connections), u32 cost
+//             model, zero padding
+//   table     per section: u32 id, u32 element size, u64 offset, u64 count
+//   sections  arrays in host byte order at 8-byte aligned offsets
+//
+// Node and edge sections are always present and mirror NavGraph; strings
+// are stored as u32 offsets (count + 1) into a UTF-8 blob. The key distance
+// table (see DistanceTable) and the landmark costs (see Landmarks) are
+// optional. Readers skip sections they do not know, so later versions can
+// add tables without breaking old files.
+namespace ArenaFile {
+
+constexpr quint32 Version = 1;
+
+enum Section : quint32 {
+    NodeX = 1,
+    NodeY,
+    NodeElevation,
+    NodePoints,
+    NodeKinds,
+    NodeIdOffsets,
+    NodeIdChars,
+    NodeTypeOffsets,
+    NodeTypeChars,
+    EdgeOffsets,
+    EdgeTargets,
+    EdgeCosts,
+    EdgeDistances,
+    KeyNodes,           // Optional key distance table
+    KeyCosts,
+    KeyNextEdges,
+    LandmarkNodes,      // Optional landmark costs
+    LandmarkCostsFrom,
+    LandmarkCostsTo
+};
+
+// How the edges were made, so the engine can rebuild them the same way
+// when the nodes change
+struct Info {
+    int neighbours = 0;     // k of buildGraph(), 0 for explicit connections
+    EdgeCostModel costModel = EdgeCostModel::Elevation;
+};
+
+// Writes through a temporary file and renames it, so a reader (or the hot
+// reload watching the file) never sees half an arena
+bool save(const QString& path, const PlannerGraph& graph, const Info& info,
+          bool withTables, QString* error = nullptr);
+
+// Replaces graph with the file's contents. On failure graph is unchanged.
+bool load(const QString& path, PlannerGraph& graph, Info& info, QString* error = nullptr);
+
+} // namespace ArenaFile
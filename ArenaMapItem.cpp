@@ -0,0 +1,730 @@
+#include "ArenaMapItem.h"
+#include <QMatrix4x4>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGRendererInterface>
+#include <QSGTextNode>
+#include <QSGTransformNode>
+#include <QSGVertexColorMaterial>
+#include <QTextLayout>
+#include <QWheelEvent>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Sizes in item pixels at zoom 1, taken from the old Canvas map
+constexpr qreal kRouteWidth = 4.0;
+constexpr qreal kRobotRadius = 9.0;
+constexpr qreal kLabelRadius = 8.0;
+constexpr qreal kLabelOffset = 10.0;
+constexpr int kLabelPixelSize = 12;
+constexpr int kDiscSegments = 12;
+
+// The arena of the competition, maps always show at least this much
+const QRectF kArenaRect(0, 0, 500, 420);
+
+struct NodeStyle {
+    QColor fill;
+    QColor stroke;
+    qreal lineWidth;
+    QColor pathFill;    // Used while the node is on the route
+    QColor pathStroke;
+    qreal pathLineWidth;
+    qreal radius;
+};
+
+const NodeStyle& styleForType(const QString& type)
+{
+    static const NodeStyle keystone{"#7B3F00", "#CDC1FF", 1, "#FF6B35", "#FF0000", 3, 7};
+    static const NodeStyle startA{"blue", "black", 1, "#0066FF", "#FFFFFF", 3, 6};
+    static const NodeStyle startB{"red", "black", 1, "#FF3366", "#FFFFFF", 3, 6};
+    static const NodeStyle release{"#89A8B2", "#C1BAA1", 2, "#66D9EF", "#FFFFFF", 3, 6};
+    static const NodeStyle greenBall{"#41ab5d", "#238b45", 1, "#66FF66", "#FFFFFF", 3, 6};
+    static const NodeStyle blackBall{"black", "#74c476", 1, "#666666", "#FFFFFF", 3, 6};
+    static const NodeStyle starBall{"gold", "black", 1, "#FFD700", "#FFFFFF", 3, 8};
+    static const NodeStyle commTower{"yellow", "black", 1, "#FFFF66", "#FFFFFF", 3, 8};
+    static const NodeStyle other{"black", "black", 1, "#666666", "#FFFFFF", 3, 6};
+
+    if (type == "keystone") return keystone;
+    if (type == "start_a") return startA;
+    if (type == "start_b") return startB;
+    if (type == "release") return release;
+    if (type == "green_ball") return greenBall;
+    if (type == "black_striped_ball") return blackBall;
+    if (type == "star_ball") return starBall;
+    if (type == "comm_tow") return commTower;
+    return other;
+}
+
+// Indexed triangle list with per-vertex colour. Static layers use 16-bit
+// indices and are split into batches below the 16-bit vertex limit.
+template <typename Index>
+struct ColoredMesh {
+    std::vector<QSGGeometry::ColoredPoint2D> vertices;
+    std::vector<Index> indices;
+
+    void clear()
+    {
+        vertices.clear();
+        indices.clear();
+    }
+
+    void addVertex(QPointF point, const QColor& color)
+    {
+        // The vertex colour material expects premultiplied alpha
+        const int alpha = color.alpha();
+        QSGGeometry::ColoredPoint2D vertex;
+        vertex.set(float(point.x()), float(point.y()),
+                   uchar(color.red() * alpha / 255), uchar(color.green() * alpha / 255),
+                   uchar(color.blue() * alpha / 255), uchar(alpha));
+        vertices.push_back(vertex);
+    }
+
+    void addDisc(QPointF center, qreal radius, const QColor& color)
+    {
+        const Index first = Index(vertices.size());
+        addVertex(center, color);
+        for (int i = 0; i < kDiscSegments; ++i) {
+            const qreal angle = 2 * M_PI * i / kDiscSegments;
+            addVertex(center + QPointF(radius * qCos(angle), radius * qSin(angle)), color);
+        }
+        for (int i = 0; i < kDiscSegments; ++i) {
+            indices.push_back(first);
+            indices.push_back(Index(first + 1 + i));
+            indices.push_back(Index(first + 1 + (i + 1) % kDiscSegments));
+        }
+    }
+
+    // Filled circle with an outline centred on its edge, like a Canvas arc
+    // that is filled and then stroked
+    void addMarker(QPointF center, qreal radius, qreal lineWidth, const QColor& fill, const QColor& stroke)
+    {
+        addDisc(center, radius + lineWidth / 2, stroke);
+        addDisc(center, std::max<qreal>(0, radius - lineWidth / 2), fill);
+    }
+
+    void addTriangle(QPointF a, QPointF b, QPointF c, const QColor& color)
+    {
+        const Index first = Index(vertices.size());
+        addVertex(a, color);
+        addVertex(b, color);
+        addVertex(c, color);
+        indices.insert(indices.end(), {first, Index(first + 1), Index(first + 2)});
+    }
+
+    // Butt-capped band of the given width, like a Canvas line segment
+    void addSegment(QPointF from, QPointF to, qreal width, const QColor& color)
+    {
+        const QPointF direction = to - from;
+        const qreal length = std::hypot(direction.x(), direction.y());
+        if (length <= 0) {
+            return;
+        }
+        const QPointF normal = QPointF(-direction.y(), direction.x()) * (width / 2 / length);
+
+        const Index first = Index(vertices.size());
+        addVertex(from + normal, color);
+        addVertex(from - normal, color);
+        addVertex(to + normal, color);
+        addVertex(to - normal, color);
+        indices.insert(indices.end(), {first, Index(first + 1), Index(first + 2),
+                                       Index(first + 1), Index(first + 3), Index(first + 2)});
+    }
+
+    void addArrow(QPointF from, QPointF to, qreal unit, const QColor& color)
+    {
+        // Triangle pointing along the segment at its midpoint
+        const QPointF direction = to - from;
+        const qreal length = std::hypot(direction.x(), direction.y());
+        if (length <= 0) {
+            return;
+        }
+        const QPointF along = direction / length * unit;
+        const QPointF across(-along.y(), along.x());
+        const QPointF middle = (from + to) / 2;
+        addTriangle(middle + along * 8, middle - along * 4 - across * 3, middle - along * 4 + across * 3, color);
+    }
+
+    void upload(QSGGeometryNode* node) const
+    {
+        QSGGeometry* geometry = node->geometry();
+        geometry->allocate(int(vertices.size()), int(indices.size()));
+        if (!vertices.empty()) {
+            std::memcpy(geometry->vertexDataAsColoredPoint2D(), vertices.data(),
+                        vertices.size() * sizeof(QSGGeometry::ColoredPoint2D));
+            std::memcpy(geometry->indexData(), indices.data(), indices.size() * sizeof(Index));
+        }
+        node->markDirty(QSGNode::DirtyGeometry);
+    }
+};
+
+QSGGeometryNode* createColoredNode(QSGGeometry::Type indexType)
+{
+    auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0, indexType);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+
+    auto* node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setMaterial(new QSGVertexColorMaterial);
+    node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    return node;
+}
+
+void removeAllChildren(QSGNode* node)
+{
+    while (QSGNode* child = node->firstChild()) {
+        node->removeChildNode(child);
+        delete child;
+    }
+}
+
+// Scene graph layout of the map, built once per window
+class MapRootNode : public QSGNode
+{
+public:
+    QSGTransformNode* view;          // Arena to item coordinates
+    QSGNode* edgeLayer;              // Static, one line batch
+    QSGGeometryNode* routeLines;     // Dynamic, below the nodes
+    QSGNode* nodeLayer;              // Static, marker batches
+    QSGGeometryNode* routeMarkers;   // Dynamic, highlighted route nodes
+    QSGGeometryNode* robot;          // Dynamic
+    QSGGeometryNode* labelMarkers;   // Item coordinates, route numbers
+    QSGTextNode* labelText;
+
+    explicit MapRootNode(QQuickWindow* window)
+        : view(new QSGTransformNode)
+        , edgeLayer(new QSGNode)
+        , routeLines(createColoredNode(QSGGeometry::UnsignedIntType))
+        , nodeLayer(new QSGNode)
+        , routeMarkers(createColoredNode(QSGGeometry::UnsignedIntType))
+        , robot(createColoredNode(QSGGeometry::UnsignedShortType))
+        , labelMarkers(createColoredNode(QSGGeometry::UnsignedIntType))
+        , labelText(window->createTextNode())
+    {
+        appendChildNode(view);
+        view->appendChildNode(edgeLayer);
+        view->appendChildNode(routeLines);
+        view->appendChildNode(nodeLayer);
+        view->appendChildNode(routeMarkers);
+        view->appendChildNode(robot);
+        appendChildNode(labelMarkers);
+        appendChildNode(labelText);
+    }
+};
+
+} // namespace
+
+ArenaMapItem::ArenaMapItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_showConnections(true)
+    , m_showOptimalPath(true)
+    , m_showRobot(false)
+    , m_robotPosition(50, 50)
+    , m_zoom(1.0)
+    , m_center(kArenaRect.center())
+    , m_interactive(true)
+    , arenaBounds(kArenaRect)
+    , viewMoved(false)
+    , dirty(0)
+{
+    setFlag(ItemHasContents, true);
+    setAcceptedMouseButtons(Qt::LeftButton);
+}
+
+void ArenaMapItem::setEngine(PathfindingEngine* engine)
+{
+    if (m_engine == engine) {
+        return;
+    }
+    if (m_engine) {
+        disconnect(m_engine, nullptr, this, nullptr);
+    }
+    m_engine = engine;
+    if (m_engine) {
+        connect(m_engine, &PathfindingEngine::graphChanged, this, &ArenaMapItem::reloadGraph);
+    }
+    reloadGraph();
+    emit engineChanged();
+}
+
+void ArenaMapItem::setRoute(RouteModel* route)
+{
+    if (m_route == route) {
+        return;
+    }
+    if (m_route) {
+        disconnect(m_route, nullptr, this, nullptr);
+    }
+    m_route = route;
+    if (m_route) {
+        connect(m_route, &RouteModel::routeChanged, this, &ArenaMapItem::reloadRoute);
+    }
+    reloadRoute();
+    emit routeChanged();
+}
+
+void ArenaMapItem::setShowConnections(bool show)
+{
+    if (m_showConnections != show) {
+        m_showConnections = show;
+        markDirty(GraphDirty);
+        emit showConnectionsChanged();
+    }
+}
+
+void ArenaMapItem::setShowOptimalPath(bool show)
+{
+    if (m_showOptimalPath != show) {
+        m_showOptimalPath = show;
+        markDirty(RouteDirty);
+        emit showOptimalPathChanged();
+    }
+}
+
+void ArenaMapItem::setShowRobot(bool show)
+{
+    if (m_showRobot != show) {
+        m_showRobot = show;
+        markDirty(RobotDirty);
+        emit showRobotChanged();
+    }
+}
+
+void ArenaMapItem::setRobotPosition(const QPointF& position)
+{
+    if (m_robotPosition != position) {
+        m_robotPosition = position;
+        markDirty(RobotDirty);
+        emit robotPositionChanged();
+    }
+}
+
+void ArenaMapItem::setZoom(qreal zoom)
+{
+    zoom = std::clamp<qreal>(zoom, 0.5, 200.0);
+    if (!qFuzzyCompare(m_zoom, zoom)) {
+        m_zoom = zoom;
+        viewMoved = true;
+        markDirty(ViewDirty);
+        emit viewChanged();
+    }
+}
+
+void ArenaMapItem::setCenter(const QPointF& center)
+{
+    if (m_center != center) {
+        m_center = center;
+        viewMoved = true;
+        markDirty(ViewDirty);
+        emit viewChanged();
+    }
+}
+
+void ArenaMapItem::setInteractive(bool interactive)
+{
+    if (m_interactive != interactive) {
+        m_interactive = interactive;
+        setAcceptedMouseButtons(interactive ? Qt::LeftButton : Qt::NoButton);
+        emit interactiveChanged();
+    }
+}
+
+void ArenaMapItem::resetView()
+{
+    m_zoom = 1.0;
+    m_center = arenaBounds.center();
+    viewMoved = false;
+    markDirty(ViewDirty);
+    emit viewChanged();
+}
+
+QPointF ArenaMapItem::mapToArena(const QPointF& point) const
+{
+    return viewTransform().inverted().map(point);
+}
+
+QPointF ArenaMapItem::mapFromArena(const QPointF& point) const
+{
+    return viewTransform().map(point);
+}
+
+qreal ArenaMapItem::baseScale() const
+{
+    if (arenaBounds.isEmpty() || width() <= 0 || height() <= 0) {
+        return 1.0;
+    }
+    return std::min(width() / arenaBounds.width(), height() / arenaBounds.height());
+}
+
+QTransform ArenaMapItem::viewTransform() const
+{
+    const qreal scale = baseScale() * m_zoom;
+    QTransform transform;
+    transform.translate(width() / 2, height() / 2);
+    transform.scale(scale, scale);
+    transform.translate(-m_center.x(), -m_center.y());
+    return transform;
+}
+
+void ArenaMapItem::reloadGraph()
+{
+    graph = m_engine ? m_engine->graphSnapshot() : nullptr;
+
+    arenaBounds = kArenaRect;
+    if (graph && graph->graph.nodeCount() > 0) {
+        const NavGraph& nav = graph->graph;
+        auto [minX, maxX] = std::minmax_element(nav.x.begin(), nav.x.end());
+        auto [minY, maxY] = std::minmax_element(nav.y.begin(), nav.y.end());
+        arenaBounds = arenaBounds.united(QRectF(QPointF(*minX, *minY), QPointF(*maxX, *maxY)));
+    }
+    markDirty(GraphDirty | MarkerDirty | RouteDirty | RobotDirty | ViewDirty);
+    if (!viewMoved && m_center != arenaBounds.center()) {
+        m_center = arenaBounds.center();
+        emit viewChanged();
+    }
+}
+
+void ArenaMapItem::reloadRoute()
+{
+    if (m_route) {
+        routeGraph = m_route->snapshot();
+        routeNodes = m_route->nodes();
+    } else {
+        routeGraph.reset();
+        routeNodes.clear();
+    }
+    markDirty(RouteDirty);
+}
+
+void ArenaMapItem::markDirty(int flags)
+{
+    dirty |= flags;
+    update();
+}
+
+void ArenaMapItem::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        markDirty(MarkerDirty | RouteDirty | RobotDirty | ViewDirty);
+        emit viewChanged();
+    }
+}
+
+void ArenaMapItem::wheelEvent(QWheelEvent* event)
+{
+    if (!m_interactive) {
+        event->ignore();
+        return;
+    }
+
+    // Zoom around the cursor: the arena point under it stays put
+    const QPointF cursor = event->position();
+    const QPointF anchor = mapToArena(cursor);
+    setZoom(m_zoom * qPow(1.0015, event->angleDelta().y()));
+    const qreal scale = baseScale() * m_zoom;
+    setCenter(anchor - (cursor - QPointF(width() / 2, height() / 2)) / scale);
+    event->accept();
+}
+
+void ArenaMapItem::mousePressEvent(QMouseEvent* event)
+{
+    dragOrigin = event->position();
+    dragCenter = m_center;
+    event->accept();
+}
+
+void ArenaMapItem::mouseMoveEvent(QMouseEvent* event)
+{
+    setCenter(dragCenter - (event->position() - dragOrigin) / (baseScale() * m_zoom));
+    event->accept();
+}
+
+void ArenaMapItem::mouseReleaseEvent(QMouseEvent* event)
+{
+    event->accept();
+}
+
+QSGNode* ArenaMapItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
+{
+    Q_UNUSED(data);
+
+    if (!graph || width() <= 0 || height() <= 0) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    const bool software = window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software;
+    QSGNode* node = software ? updateSoftware(oldNode) : updateSceneGraph(oldNode);
+    dirty = 0;
+    return node;
+}
+
+QSGNode* ArenaMapItem::updateSceneGraph(QSGNode* oldNode)
+{
+    auto* root = static_cast<MapRootNode*>(oldNode);
+    if (!root) {
+        root = new MapRootNode(window());
+        dirty = GraphDirty | MarkerDirty | RouteDirty | RobotDirty | ViewDirty;
+    }
+
+    const NavGraph& nav = graph->graph;
+    const qreal unit = 1.0 / baseScale(); // One item pixel at zoom 1, in arena units
+
+    if (dirty & ViewDirty) {
+        root->view->setMatrix(QMatrix4x4(viewTransform()));
+    }
+
+    if (dirty & GraphDirty) {
+        removeAllChildren(root->edgeLayer);
+
+        const std::vector<int> links = m_showConnections ? nav.passableLinks() : std::vector<int>();
+        if (!links.empty()) {
+            auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), int(links.size() * 2));
+            geometry->setDrawingMode(QSGGeometry::DrawLines);
+            geometry->setLineWidth(1);
+
+            QSGGeometry::Point2D* vertex = geometry->vertexDataAsPoint2D();
+            int source = 0;
+            for (int e : links) {
+                while (e >= nav.edgeEnd(source)) {
+                    ++source;
+                }
+                const int target = nav.edgeTargets[e];
+                (vertex++)->set(float(nav.x[source]), float(nav.y[source]));
+                (vertex++)->set(float(nav.x[target]), float(nav.y[target]));
+            }
+
+            auto* material = new QSGFlatColorMaterial;
+            material->setColor(QColor(0, 0, 0, 77));
+
+            auto* edges = new QSGGeometryNode;
+            edges->setGeometry(geometry);
+            edges->setMaterial(material);
+            edges->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+            root->edgeLayer->appendChildNode(edges);
+        }
+    }
+
+    if (dirty & (GraphDirty | MarkerDirty)) {
+        removeAllChildren(root->nodeLayer);
+
+        // Two discs of kDiscSegments + 1 vertices per node
+        const size_t verticesPerNode = 2 * (kDiscSegments + 1);
+        const size_t nodesPerBatch = 65536 / verticesPerNode;
+
+        ColoredMesh<quint16> batch;
+        for (int node = 0; node < nav.nodeCount(); ++node) {
+            const NodeStyle& style = styleForType(graph->nodeTypes[node]);
+            batch.addMarker(QPointF(nav.x[node], nav.y[node]), style.radius * unit, style.lineWidth * unit,
+                            style.fill, style.stroke);
+
+            if (batch.vertices.size() == nodesPerBatch * verticesPerNode || node + 1 == nav.nodeCount()) {
+                QSGGeometryNode* batchNode = createColoredNode(QSGGeometry::UnsignedShortType);
+                batch.upload(batchNode);
+                root->nodeLayer->appendChildNode(batchNode);
+                batch.clear();
+            }
+        }
+    }
+
+    if (dirty & (GraphDirty | MarkerDirty | RouteDirty | ViewDirty)) {
+        ColoredMesh<quint32> lines;
+        ColoredMesh<quint32> markers;
+        ColoredMesh<quint32> labels;
+        root->labelText->clear();
+
+        if (m_showOptimalPath && routeGraph) {
+            const NavGraph& routeNav = routeGraph->graph;
+            const QTransform transform = viewTransform();
+
+            QFont font;
+            font.setPixelSize(kLabelPixelSize);
+            root->labelText->setColor(Qt::white);
+
+            for (size_t i = 0; i < routeNodes.size(); ++i) {
+                const int node = routeNodes[i];
+                const QPointF point(routeNav.x[node], routeNav.y[node]);
+
+                if (i + 1 < routeNodes.size()) {
+                    const QPointF next(routeNav.x[routeNodes[i + 1]], routeNav.y[routeNodes[i + 1]]);
+                    lines.addSegment(point, next, kRouteWidth * unit, QColor(255, 0, 0, 204));
+                    lines.addArrow(point, next, unit, Qt::black);
+                }
+
+                const NodeStyle& style = styleForType(routeGraph->nodeTypes[node]);
+                markers.addMarker(point, style.radius * unit, style.pathLineWidth * unit,
+                                  style.pathFill, style.pathStroke);
+
+                // Sequence numbers stay the same size at any zoom
+                const QPointF label = transform.map(point) + QPointF(kLabelOffset, -kLabelOffset);
+                labels.addDisc(label, kLabelRadius, Qt::black);
+
+                QTextLayout layout(QString::number(i + 1), font);
+                layout.beginLayout();
+                QTextLine line = layout.createLine();
+                layout.endLayout();
+                root->labelText->addTextLayout(label - QPointF(line.naturalTextWidth() / 2, line.height() / 2), &layout);
+            }
+        }
+
+        lines.upload(root->routeLines);
+        markers.upload(root->routeMarkers);
+        labels.upload(root->labelMarkers);
+    }
+
+    if (dirty & (RobotDirty | MarkerDirty)) {
+        ColoredMesh<quint16> robot;
+        if (m_showRobot) {
+            robot.addMarker(m_robotPosition, kRobotRadius * unit, 2 * unit, QColor("#1E88E5"), Qt::white);
+        }
+        robot.upload(root->robot);
+    }
+
+    return root;
+}
+
+QSGNode* ArenaMapItem::updateSoftware(QSGNode* oldNode)
+{
+    auto* node = static_cast<QSGImageNode*>(oldNode);
+    if (!node) {
+        node = window()->createImageNode();
+        node->setOwnsTexture(true);
+        dirty = GraphDirty | MarkerDirty | RouteDirty | RobotDirty | ViewDirty;
+    }
+
+    const qreal devicePixelRatio = window()->effectiveDevicePixelRatio();
+    const QSize pixelSize = (size() * devicePixelRatio).toSize();
+
+    if ((dirty & (GraphDirty | MarkerDirty | ViewDirty)) || staticImage.size() != pixelSize) {
+        staticImage = QImage(pixelSize, QImage::Format_ARGB32_Premultiplied);
+        staticImage.setDevicePixelRatio(devicePixelRatio);
+        staticImage.fill(Qt::transparent);
+        paintStatic(staticImage);
+    }
+
+    QImage image = staticImage;
+    paintDynamic(image);
+
+    node->setTexture(window()->createTextureFromImage(image));
+    node->setRect(boundingRect());
+    return node;
+}
+
+void ArenaMapItem::paintStatic(QImage& image) const
+{
+    const NavGraph& nav = graph->graph;
+    const qreal unit = 1.0 / baseScale();
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(viewTransform());
+
+    if (m_showConnections) {
+        QVector<QLineF> lines;
+        const std::vector<int> links = nav.passableLinks();
+        lines.reserve(links.size());
+
+        int source = 0;
+        for (int e : links) {
+            while (e >= nav.edgeEnd(source)) {
+                ++source;
+            }
+            const int target = nav.edgeTargets[e];
+            lines.append(QLineF(nav.x[source], nav.y[source], nav.x[target], nav.y[target]));
+        }
+
+        QPen pen(QColor(0, 0, 0, 77), 1);
+        pen.setCosmetic(true);
+        painter.setPen(pen);
+        painter.drawLines(lines);
+    }
+
+    for (int node = 0; node < nav.nodeCount(); ++node) {
+        const NodeStyle& style = styleForType(graph->nodeTypes[node]);
+        painter.setPen(QPen(style.stroke, style.lineWidth * unit));
+        painter.setBrush(style.fill);
+        painter.drawEllipse(QPointF(nav.x[node], nav.y[node]), style.radius * unit, style.radius * unit);
+    }
+}
+
+void ArenaMapItem::paintDynamic(QImage& image) const
+{
+    const qreal unit = 1.0 / baseScale();
+    const QTransform transform = viewTransform();
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(transform);
+
+    if (m_showOptimalPath && routeGraph && !routeNodes.empty()) {
+        const NavGraph& routeNav = routeGraph->graph;
+
+        QPolygonF polyline;
+        for (int node : routeNodes) {
+            polyline.append(QPointF(routeNav.x[node], routeNav.y[node]));
+        }
+
+        painter.setPen(QPen(QColor(255, 0, 0, 204), kRouteWidth * unit, Qt::SolidLine, Qt::FlatCap));
+        for (int i = 0; i + 1 < polyline.size(); ++i) {
+            painter.drawLine(polyline[i], polyline[i + 1]);
+        }
+
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::black);
+        for (int i = 0; i + 1 < polyline.size(); ++i) {
+            const QPointF direction = polyline[i + 1] - polyline[i];
+            const qreal length = std::hypot(direction.x(), direction.y());
+            if (length <= 0) {
+                continue;
+            }
+            const QPointF along = direction / length * unit;
+            const QPointF across(-along.y(), along.x());
+            const QPointF middle = (polyline[i] + polyline[i + 1]) / 2;
+            const QPointF arrow[] = {middle + along * 8, middle - along * 4 - across * 3, middle - along * 4 + across * 3};
+            painter.drawPolygon(arrow, 3);
+        }
+
+        for (size_t i = 0; i < routeNodes.size(); ++i) {
+            const NodeStyle& style = styleForType(routeGraph->nodeTypes[routeNodes[i]]);
+            painter.setPen(QPen(style.pathStroke, style.pathLineWidth * unit));
+            painter.setBrush(style.pathFill);
+            painter.drawEllipse(polyline[int(i)], style.radius * unit, style.radius * unit);
+        }
+    }
+
+    if (m_showRobot) {
+        painter.setPen(QPen(Qt::white, 2 * unit));
+        painter.setBrush(QColor("#1E88E5"));
+        painter.drawEllipse(m_robotPosition, kRobotRadius * unit, kRobotRadius * unit);
+    }
+
+    // Sequence numbers in item coordinates, the same size at any zoom
+    if (m_showOptimalPath && routeGraph) {
+        const NavGraph& routeNav = routeGraph->graph;
+        painter.resetTransform();
+
+        QFont font = painter.font();
+        font.setPixelSize(kLabelPixelSize);
+        painter.setFont(font);
+
+        for (size_t i = 0; i < routeNodes.size(); ++i) {
+            const QPointF label = transform.map(QPointF(routeNav.x[routeNodes[i]], routeNav.y[routeNodes[i]]))
+                                  + QPointF(kLabelOffset, -kLabelOffset);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(Qt::black);
+            painter.drawEllipse(label, kLabelRadius, kLabelRadius);
+
+            painter.setPen(Qt::white);
+            painter.drawText(QRectF(label.x() - kLabelRadius, label.y() - kLabelRadius, 2 * kLabelRadius, 2 * kLabelRadius),
+                             Qt::AlignCenter, QString::number(i + 1));
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include <QTransform>
+#include <memory>
+#include <vector>
+#include "PathfindingEngine.h"
+#include "RouteModel.h"
+
+class QSGNode;
+
+// Arena map rendered straight into the Qt Quick scene graph.
+// Connections and nodes are static layers: their geometry is built in arena
+// coordinates once per graph change and placed under a transform node, so
+// panning and zooming only changes a matrix. The route and the robot are
+// small dynamic layers on top. With the software backend, which cannot draw
+// custom geometry, the same layers are painted into an image instead.
+class ArenaMapItem : public QQuickItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(PathfindingEngine* engine READ engine WRITE setEngine NOTIFY engineChanged)
+    Q_PROPERTY(RouteModel* route READ route WRITE setRoute NOTIFY routeChanged)
+    Q_PROPERTY(bool showConnections READ showConnections WRITE setShowConnections NOTIFY showConnectionsChanged)
+    Q_PROPERTY(bool showOptimalPath READ showOptimalPath WRITE setShowOptimalPath NOTIFY showOptimalPathChanged)
+    Q_PROPERTY(bool showRobot READ showRobot WRITE setShowRobot NOTIFY showRobotChanged)
+    Q_PROPERTY(QPointF robotPosition READ robotPosition WRITE setRobotPosition NOTIFY robotPositionChanged)
+    // 1 fits the whole arena into the item
+    Q_PROPERTY(qreal zoom READ zoom WRITE setZoom NOTIFY viewChanged)
+    // Arena point shown in the middle of the item
+    Q_PROPERTY(QPointF center READ center WRITE setCenter NOTIFY viewChanged)
+    // Item pixels per arena unit at the current zoom
+    Q_PROPERTY(qreal viewScale READ viewScale NOTIFY viewChanged)
+    // Wheel zoom and drag to pan
+    Q_PROPERTY(bool interactive READ interactive WRITE setInteractive NOTIFY interactiveChanged)
+
+public:
+    explicit ArenaMapItem(QQuickItem *parent = nullptr);
+
+    PathfindingEngine* engine() const { return m_engine; }
+    RouteModel* route() const { return m_route; }
+    bool showConnections() const { return m_showConnections; }
+    bool showOptimalPath() const { return m_showOptimalPath; }
+    bool showRobot() const { return m_showRobot; }
+    QPointF robotPosition() const { return m_robotPosition; }
+    qreal zoom() const { return m_zoom; }
+    QPointF center() const { return m_center; }
+    qreal viewScale() const { return baseScale() * m_zoom; }
+    bool interactive() const { return m_interactive; }
+
+    void setEngine(PathfindingEngine* engine);
+    void setRoute(RouteModel* route);
+    void setShowConnections(bool show);
+    void setShowOptimalPath(bool show);
+    void setShowRobot(bool show);
+    void setRobotPosition(const QPointF& position);
+    void setZoom(qreal zoom);
+    void setCenter(const QPointF& center);
+    void setInteractive(bool interactive);
+
+    Q_INVOKABLE QPointF mapToArena(const QPointF& point) const;
+    Q_INVOKABLE QPointF mapFromArena(const QPointF& point) const;
+    Q_INVOKABLE void resetView();
+
+signals:
+    void engineChanged();
+    void routeChanged();
+    void showConnectionsChanged();
+    void showOptimalPathChanged();
+    void showRobotChanged();
+    void robotPositionChanged();
+    void viewChanged();
+    void interactiveChanged();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+private:
+    enum DirtyFlag {
+        GraphDirty = 0x1,   // Static layers need new geometry
+        MarkerDirty = 0x2,  // Marker sizes follow the item size
+        RouteDirty = 0x4,
+        RobotDirty = 0x8,
+        ViewDirty = 0x10    // Pan or zoom, only the transform changes
+    };
+
+    QPointer<PathfindingEngine> m_engine;
+    QPointer<RouteModel> m_route;
+    bool m_showConnections;
+    bool m_showOptimalPath;
+    bool m_showRobot;
+    QPointF m_robotPosition;
+    qreal m_zoom;
+    QPointF m_center;
+    bool m_interactive;
+
+    // Copied on the GUI thread and read while rendering, when the GUI
+    // thread is blocked
+    std::shared_ptr<const PlannerGraph> graph;
+    std::shared_ptr<const PlannerGraph> routeGraph;
+    std::vector<int> routeNodes;
+    QRectF arenaBounds;
+    bool viewMoved;
+    int dirty;
+
+    QPointF dragOrigin;
+    QPointF dragCenter;
+
+    // Software backend: connections and nodes at the current view
+    QImage staticImage;
+
+    void reloadGraph();
+    void reloadRoute();
+    void markDirty(int flags);
+
+    // Item pixels per arena unit at zoom 1, markers are sized with it so they
+    // look the same as in the old Canvas map whatever the zoom
+    qreal baseScale() const;
+    QTransform viewTransform() const;
+
+    QSGNode* updateSceneGraph(QSGNode* oldNode);
+    QSGNode* updateSoftware(QSGNode* oldNode);
+    void paintStatic(QImage& image) const;
+    void paintDynamic(QImage& image) const;
+};
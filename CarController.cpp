@@ -1,22 +1,88 @@
 #include "CarController.h"
-#include <QDebug>
+#include "Logging.h"
 
 CarController::CarController(QObject *parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
+    , m_scheduler(new CommandScheduler(m_networkManager, this))
+    , m_latency(new LatencyMonitor(this))
+    , m_carUrl("http://192.168.4.1")
+    , m_channel(new ControlChannel(this))
+    , m_lowLatency(false)
+    , m_channelPort(5005)
+    , m_lastRoundTripMs(0.0)
     , m_isConnected(false)
     , m_currentDirection("stop")
     , m_speed(255)
     , m_backAndForthTimer(new QTimer(this))
     , m_backAndForthForward(true)
 {
-    // Connect network manager signals
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &CarController::onRequestFinished);
+    // Commands go through the scheduler, over the channel when it is up
+    m_scheduler->setBaseUrl(m_carUrl);
+    m_scheduler->setChannel(m_channel);
+    m_scheduler->setLatencyMonitor(m_latency);
+    connect(m_scheduler, &CommandScheduler::commandSent, this,
+            [this](const QString&, const QString& direction, int) { emit requestSent(direction); });
+    connect(m_scheduler, &CommandScheduler::commandFinished,
+            this, &CarController::onCommandFinished);
+    connect(m_scheduler, &CommandScheduler::commandFailed,
+            this, &CarController::onCommandFailed);
     // Setup back and forth timer
     m_backAndForthTimer->setInterval(1000); // 1 second intervals
     connect(m_backAndForthTimer, &QTimer::timeout,
             this, &CarController::onBackAndForthTimer);
+
+    // Low-latency channel
+    connect(m_channel, &ControlChannel::readyChanged, this, [this]() {
+        if (m_channel->isReady() && !m_isConnected) {
+            m_isConnected = true;
+            emit connectionChanged();
+        }
+        emit transportChanged();
+    });
+}
+
+QString CarController::transport() const
+{
+    return m_channel->isReady() ? QStringLiteral("tcp") : QStringLiteral("http");
+}
+
+void CarController::setCarUrl(const QString& url)
+{
+    if (m_carUrl != url) {
+        m_carUrl = url;
+        m_scheduler->setBaseUrl(url);
+        emit carUrlChanged();
+        updateChannel();
+    }
+}
+
+void CarController::setLowLatency(bool enabled)
+{
+    if (m_lowLatency != enabled) {
+        m_lowLatency = enabled;
+        emit lowLatencyChanged();
+        updateChannel();
+    }
+}
+
+void CarController::setChannelPort(int port)
+{
+    if (m_channelPort != port) {
+        m_channelPort = port;
+        emit channelPortChanged();
+        updateChannel();
+    }
+}
+
+void CarController::updateChannel()
+{
+    const QString host = QUrl(m_carUrl).host();
+    if (m_lowLatency && !host.isEmpty() && m_channelPort > 0 && m_channelPort < 65536) {
+        m_channel->open(host, quint16(m_channelPort));
+    } else {
+        m_channel->close();
+    }
 }
 
 void CarController::setSpeed(int speed)
@@ -30,7 +96,7 @@ void CarController::setSpeed(int speed)
         // Resend the last command with the new speed
         // Only if we're not stopped and not in back-and-forth mode
         if (m_currentDirection != "stop" && !m_backAndForthTimer->isActive()) {
-            qDebug() << "Speed changed, resending command:" << m_currentDirection << "with new speed:" << m_speed;
+            qCDebug(lcCarCommand) << "Speed changed, resending command:" << m_currentDirection << "with new speed:" << m_speed;
             sendControlRequest(m_currentDirection, m_speed);
         }
         // If back-and-forth is active, the new speed will automatically be used
@@ -40,49 +106,50 @@ void CarController::setSpeed(int speed)
 
 void CarController::moveForward()
 {
-    qDebug() << "Moving forward";
+    qCDebug(lcCarCommand) << "Moving forward";
     m_backAndForthTimer->stop(); // Stop any ongoing back and forth
     sendControlRequest("forward", m_speed);
 }
 
 void CarController::moveBackward()
 {
-    qDebug() << "Moving backward";
+    qCDebug(lcCarCommand) << "Moving backward";
     m_backAndForthTimer->stop(); // Stop any ongoing back and forth
     sendControlRequest("backward", m_speed);
 }
 
 void CarController::turnLeft()
 {
-    qDebug() << "Turning left";
+    qCDebug(lcCarCommand) << "Turning left";
     m_backAndForthTimer->stop(); // Stop any ongoing back and forth
     sendControlRequest("left", m_speed);
 }
 
 void CarController::turnRight()
 {
-    qDebug() << "Turning right";
+    qCDebug(lcCarCommand) << "Turning right";
     m_backAndForthTimer->stop(); // Stop any ongoing back and forth
     sendControlRequest("right", m_speed);
 }
 
 void CarController::stopCar()
 {
-    qDebug() << "Stopping car";
+    qCDebug(lcCarCommand) << "Stopping car";
     m_backAndForthTimer->stop(); // Stop any ongoing back and forth
     sendControlRequest("stop", 0);
 }
 
 void CarController::emergencyStop()
 {
-    qDebug() << "EMERGENCY STOP";
+    qCInfo(lcCar) << "EMERGENCY STOP";
     m_backAndForthTimer->stop();
+    m_scheduler->cancelAll();
     sendControlRequest("stop", 0);
 }
 
 void CarController::backAndForth()
 {
-    qDebug() << "Starting back and forth movement";
+    qCInfo(lcCar) << "Starting back and forth movement";
     m_backAndForthForward = true;
     m_backAndForthTimer->start();
     sendControlRequest("forward", m_speed);
@@ -100,38 +167,29 @@ void CarController::onBackAndForthTimer()
 
 void CarController::sendControlRequest(const QString& direction, int speed)
 {
-    QJsonObject jsonData;
-    jsonData["direction"] = direction;
-    jsonData["speed"] = speed;
-    QJsonDocument doc(jsonData);
-    QByteArray data = doc.toJson();
-
-    QNetworkRequest request{QUrl(m_carUrl)};
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QNetworkReply* reply = m_networkManager->post(request, data);
-
     m_currentDirection = direction;
     emit directionChanged();
-    emit requestSent(direction);
 
-    qDebug() << "Sent request:" << data;
+    m_scheduler->submit("/control", direction, speed);
+    qCDebug(lcCarCommand) << "Queued command:" << direction << speed;
 }
 
-void CarController::onRequestFinished(QNetworkReply* reply)
+void CarController::onCommandFinished(const QString& endpoint, const QString& direction, double roundTripMs)
 {
-    // Check if request was successful
-    qDebug() << reply->error();
-    if (reply->error() == QNetworkReply::NoError) {
-        qDebug() << "Request successful";
-        m_isConnected = true;
-        emit connectionChanged();
-    } else {
-        qDebug() << "Request failed:" << reply->errorString();
-        m_isConnected = false;
-        emit connectionChanged();
-        emit requestFailed(reply->errorString());
-    }
+    Q_UNUSED(endpoint)
+    qCDebug(lcCarCommand) << "Request successful for" << direction << "in" << roundTripMs << "ms";
+    m_isConnected = true;
+    emit connectionChanged();
 
-    // Clean up
-    reply->deleteLater();
+    m_lastRoundTripMs = roundTripMs;
+    emit roundTripMeasured(direction, roundTripMs);
+}
+
+void CarController::onCommandFailed(const QString& endpoint, const QString& error)
+{
+    Q_UNUSED(endpoint)
+    qCWarning(lcCar) << "Request failed:" << error;
+    m_isConnected = false;
+    emit connectionChanged();
+    emit requestFailed(error);
 }
@@ -2,11 +2,9 @@
 
 #include <QObject>
 #include <QNetworkAccessManager>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QTimer>
+#include "CommandScheduler.h"
+#include "ControlChannel.h"
 
 class CarController : public QObject
 {
@@ -16,6 +14,16 @@ class CarController : public QObject
     Q_PROPERTY(bool isConnected READ isConnected NOTIFY connectionChanged)
     Q_PROPERTY(QString currentDirection READ currentDirection NOTIFY directionChanged)
     Q_PROPERTY(int speed READ speed WRITE setSpeed NOTIFY speedChanged)
+    Q_PROPERTY(QString carUrl READ carUrl WRITE setCarUrl NOTIFY carUrlChanged)
+
+    // Binary commands over a persistent TCP connection, HTTP whenever that
+    // connection is down
+    Q_PROPERTY(bool lowLatency READ lowLatency WRITE setLowLatency NOTIFY lowLatencyChanged)
+    Q_PROPERTY(int channelPort READ channelPort WRITE setChannelPort NOTIFY channelPortChanged)
+    Q_PROPERTY(QString transport READ transport NOTIFY transportChanged)
+    Q_PROPERTY(double lastRoundTripMs READ lastRoundTripMs NOTIFY roundTripMeasured)
+    Q_PROPERTY(CommandScheduler* scheduler READ scheduler CONSTANT)
+    Q_PROPERTY(LatencyMonitor* latency READ latency CONSTANT)
 
 public:
     explicit CarController(QObject *parent = nullptr);
@@ -24,9 +32,19 @@ public:
     bool isConnected() const { return m_isConnected; }
     QString currentDirection() const { return m_currentDirection; }
     int speed() const { return m_speed; }
+    QString carUrl() const { return m_carUrl; }
+    bool lowLatency() const { return m_lowLatency; }
+    int channelPort() const { return m_channelPort; }
+    QString transport() const;
+    double lastRoundTripMs() const { return m_lastRoundTripMs; }
+    CommandScheduler* scheduler() const { return m_scheduler; }
+    LatencyMonitor* latency() const { return m_latency; }
 
     // Setter methods
     void setSpeed(int speed);
+    void setCarUrl(const QString& url);
+    void setLowLatency(bool enabled);
+    void setChannelPort(int port);
 
 public slots:
     // These slots can be called from QML
@@ -45,19 +63,35 @@ signals:
     void speedChanged();
     void requestSent(const QString& direction);
     void requestFailed(const QString& error);
+    void carUrlChanged();
+    void lowLatencyChanged();
+    void channelPortChanged();
+    void transportChanged();
+    // Time from sending a command to the car's reply, over either transport
+    void roundTripMeasured(const QString& direction, double roundTripMs);
 
 private slots:
-    void onRequestFinished(QNetworkReply* reply);
+    void onCommandFinished(const QString& endpoint, const QString& direction, double roundTripMs);
+    void onCommandFailed(const QString& endpoint, const QString& error);
     void onBackAndForthTimer();
 
 private:
     void sendControlRequest(const QString& direction, int speed);
+    void updateChannel();
 
     // Network manager for HTTP requests
     QNetworkAccessManager* m_networkManager;
+    CommandScheduler* m_scheduler;
+    LatencyMonitor* m_latency;
+
+    // Car base URL, commands go to /control
+    QString m_carUrl;
 
-    // Car control endpoint URL
-    const QString m_carUrl = "http://192.168.4.1/control";
+    // Low-latency channel
+    ControlChannel* m_channel;
+    bool m_lowLatency;
+    int m_channelPort;
+    double m_lastRoundTripMs;
 
     // State variables
     bool m_isConnected;
@@ -0,0 +1,274 @@
+#include "CommandScheduler.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+
+namespace {
+
+// An HTTP request that takes longer than this frees its endpoint
+constexpr int requestTimeout = 2000;
+
+bool isStop(const QString& direction)
+{
+    return direction == QLatin1String("stop");
+}
+
+}
+
+CommandScheduler::CommandScheduler(QNetworkAccessManager* networkManager, QObject *parent)
+    : QObject(parent)
+    , m_networkManager(networkManager)
+    , m_maxRate(20)
+    , m_sentCount(0)
+    , m_coalescedCount(0)
+    , m_droppedCount(0)
+    , m_latency(nullptr)
+{
+}
+
+void CommandScheduler::setMaxRate(int rate)
+{
+    rate = qMax(0, rate);
+    if (m_maxRate != rate) {
+        m_maxRate = rate;
+        emit maxRateChanged();
+    }
+}
+
+void CommandScheduler::setChannel(ControlChannel* channel)
+{
+    if (m_channel) {
+        disconnect(m_channel.data(), nullptr, this, nullptr);
+    }
+
+    m_channel = channel;
+    if (channel) {
+        connect(channel, &ControlChannel::acknowledged, this, &CommandScheduler::onChannelAcknowledged);
+        connect(channel, &ControlChannel::rejected, this, &CommandScheduler::onChannelRejected);
+        connect(channel, &ControlChannel::readyChanged, this, &CommandScheduler::onChannelReadyChanged);
+    }
+}
+
+void CommandScheduler::recordReply(const Lane& target, qint64 repliedAt)
+{
+    if (m_latency) {
+        m_latency->record(target.endpointCode, LatencyMonitor::Reply, repliedAt - target.sentAt);
+        m_latency->record(target.endpointCode, LatencyMonitor::Total, repliedAt - target.inFlight.origin);
+    }
+}
+
+qint64 CommandScheduler::minInterval() const
+{
+    return m_maxRate > 0 ? 1000000000LL / m_maxRate : 0;
+}
+
+CommandScheduler::Lane& CommandScheduler::lane(const QString& endpoint)
+{
+    for (Lane& existing : m_lanes) {
+        if (existing.endpoint == endpoint) {
+            return existing;
+        }
+    }
+
+    Lane added;
+    added.endpoint = endpoint;
+    added.endpointCode = ControlFrame::endpointCode(endpoint);
+    added.rateTimer = new QTimer(this);
+    added.rateTimer->setSingleShot(true);
+    connect(added.rateTimer, &QTimer::timeout, this, [this, endpoint]() {
+        dispatch(lane(endpoint));
+    });
+    m_lanes.push_back(added);
+    return m_lanes.back();
+}
+
+void CommandScheduler::submit(const QString& endpoint, const QString& direction, int speed, qint64 origin)
+{
+    Lane& target = lane(endpoint);
+    const qint64 now = LatencyMonitor::now();
+    const Command command{direction, speed, origin > 0 ? origin : now, now};
+
+    if (isStop(direction)) {
+        // Nothing queued may run after a stop, and the stop must not wait
+        // behind a request stuck on a congested link
+        if (target.hasPending) {
+            target.hasPending = false;
+            ++m_droppedCount;
+        }
+        abortInFlight(target);
+        target.rateTimer->stop();
+        send(target, command);
+        emit statsChanged();
+        return;
+    }
+
+    if (target.hasPending) {
+        ++m_coalescedCount;
+    }
+    target.pending = command;
+    target.hasPending = true;
+    dispatch(target);
+    emit statsChanged();
+}
+
+void CommandScheduler::cancelAll()
+{
+    for (Lane& each : m_lanes) {
+        if (each.hasPending) {
+            each.hasPending = false;
+            ++m_droppedCount;
+        }
+        each.rateTimer->stop();
+        abortInFlight(each);
+    }
+    emit statsChanged();
+}
+
+void CommandScheduler::resetStats()
+{
+    m_sentCount = 0;
+    m_coalescedCount = 0;
+    m_droppedCount = 0;
+    emit statsChanged();
+}
+
+void CommandScheduler::dispatch(Lane& target)
+{
+    if (target.busy || !target.hasPending || target.rateTimer->isActive()) {
+        return;
+    }
+
+    if (target.lastSentAt >= 0) {
+        const qint64 wait = target.lastSentAt + minInterval() - LatencyMonitor::now();
+        if (wait > 0) {
+            target.rateTimer->start(int((wait + 999999) / 1000000));
+            return;
+        }
+    }
+
+    target.hasPending = false;
+    send(target, target.pending);
+    emit statsChanged();
+}
+
+void CommandScheduler::send(Lane& target, const Command& command)
+{
+    target.busy = true;
+    target.inFlight = command;
+    target.sentAt = LatencyMonitor::now();
+    target.lastSentAt = target.sentAt;
+    target.reply = nullptr;
+    target.sequence = 0;
+    ++m_sentCount;
+
+    if (m_latency) {
+        m_latency->record(target.endpointCode, LatencyMonitor::Input, command.decidedAt - command.origin);
+        m_latency->record(target.endpointCode, LatencyMonitor::Queue, target.sentAt - command.decidedAt);
+    }
+
+    if (m_channel && m_channel->isReady()) {
+        target.sequence = m_channel->send(target.endpoint, command.direction, command.speed);
+    }
+
+    if (target.sequence == 0) {
+        QJsonObject jsonData;
+        jsonData["direction"] = command.direction;
+        jsonData["speed"] = command.speed;
+
+        QNetworkRequest request{QUrl(m_baseUrl + target.endpoint)};
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request.setTransferTimeout(requestTimeout);
+        QNetworkReply* reply = m_networkManager->post(request, QJsonDocument(jsonData).toJson(QJsonDocument::Compact));
+        target.reply = reply;
+
+        const QString endpoint = target.endpoint;
+        connect(reply, &QNetworkReply::finished, this, [this, reply, endpoint]() {
+            reply->deleteLater();
+            Lane& owner = lane(endpoint);
+            if (owner.reply != reply) {
+                return; // Aborted by a stop, already accounted for
+            }
+
+            const QString direction = owner.inFlight.direction;
+            const qint64 repliedAt = LatencyMonitor::now();
+            const bool succeeded = reply->error() == QNetworkReply::NoError;
+            if (succeeded) {
+                recordReply(owner, repliedAt);
+            }
+            release(owner);
+            if (succeeded) {
+                emit commandFinished(endpoint, direction, (repliedAt - owner.sentAt) / 1e6);
+            } else {
+                emit commandFailed(endpoint, reply->errorString());
+            }
+            dispatch(owner);
+        });
+    }
+
+    emit commandSent(target.endpoint, command.direction, command.speed);
+}
+
+void CommandScheduler::release(Lane& target)
+{
+    target.busy = false;
+    target.reply = nullptr;
+    target.sequence = 0;
+}
+
+void CommandScheduler::abortInFlight(Lane& target)
+{
+    if (!target.busy) {
+        return;
+    }
+
+    // A frame already written cannot be recalled, it is simply not waited for
+    QNetworkReply* reply = target.reply;
+    release(target);
+    if (reply) {
+        ++m_droppedCount;
+        reply->abort();
+    }
+}
+
+void CommandScheduler::onChannelAcknowledged(quint32 sequence, const QString& direction, double roundTripMs)
+{
+    for (Lane& each : m_lanes) {
+        if (each.busy && each.sequence == sequence) {
+            recordReply(each, LatencyMonitor::now());
+            release(each);
+            emit commandFinished(each.endpoint, direction, roundTripMs);
+            dispatch(each);
+            return;
+        }
+    }
+}
+
+void CommandScheduler::onChannelRejected(quint32 sequence, const QString& direction)
+{
+    for (Lane& each : m_lanes) {
+        if (each.busy && each.sequence == sequence) {
+            release(each);
+            emit commandFailed(each.endpoint, "Car rejected command: " + direction);
+            dispatch(each);
+            return;
+        }
+    }
+}
+
+void CommandScheduler::onChannelReadyChanged()
+{
+    if (m_channel && m_channel->isReady()) {
+        return;
+    }
+
+    // Frames in flight on a dropped connection will never be acked. Slots
+    // may add lanes while this runs, so no iterators are held.
+    for (size_t i = 0; i < m_lanes.size(); ++i) {
+        Lane& each = m_lanes[i];
+        if (each.busy && each.sequence != 0) {
+            release(each);
+            emit commandFailed(each.endpoint, QStringLiteral("Control channel closed"));
+            dispatch(each);
+        }
+    }
+}
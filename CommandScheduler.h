@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include <deque>
+#include "ControlChannel.h"
+#include "LatencyMonitor.h"
+
+// Latest-value-wins dispatch of car commands.
+// Each endpoint (/control, /arm, /dumper) has at most one command in flight
+// and at most one waiting; a newer command replaces the waiting one, so a
+// slow link never replays stale moves. "stop" skips the queue: it cancels
+// what is waiting, aborts an HTTP request in flight and goes out at once.
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+
+    // Commands per second per endpoint, 0 for no limit
+    Q_PROPERTY(int maxRate READ maxRate WRITE setMaxRate NOTIFY maxRateChanged)
+    Q_PROPERTY(int sentCount READ sentCount NOTIFY statsChanged)
+    // Replaced by a newer command before they were sent
+    Q_PROPERTY(int coalescedCount READ coalescedCount NOTIFY statsChanged)
+    // Cancelled or aborted by a stop
+    Q_PROPERTY(int droppedCount READ droppedCount NOTIFY statsChanged)
+
+public:
+    explicit CommandScheduler(QNetworkAccessManager* networkManager, QObject *parent = nullptr);
+
+    int maxRate() const { return m_maxRate; }
+    void setMaxRate(int rate);
+
+    int sentCount() const { return m_sentCount; }
+    int coalescedCount() const { return m_coalescedCount; }
+    int droppedCount() const { return m_droppedCount; }
+
+    // Base URL the endpoints are appended to for HTTP
+    void setBaseUrl(const QString& url) { m_baseUrl = url; }
+    // Commands go over the channel while it is ready, HTTP otherwise
+    void setChannel(ControlChannel* channel);
+    // Stage latencies of every command are recorded here when set
+    void setLatencyMonitor(LatencyMonitor* monitor) { m_latency = monitor; }
+
+    // origin is when the input behind the command arrived, on the
+    // LatencyMonitor::now() clock; 0 means it starts here
+    void submit(const QString& endpoint, const QString& direction, int speed, qint64 origin = 0);
+    // Drops everything waiting and aborts HTTP requests in flight
+    void cancelAll();
+
+    Q_INVOKABLE void resetStats();
+
+signals:
+    void maxRateChanged();
+    void statsChanged();
+    void commandSent(const QString& endpoint, const QString& direction, int speed);
+    void commandFinished(const QString& endpoint, const QString& direction, double roundTripMs);
+    void commandFailed(const QString& endpoint, const QString& error);
+
+private:
+    struct Command {
+        QString direction;
+        int speed = 0;
+        qint64 origin = 0;      // LatencyMonitor::now() nanoseconds
+        qint64 decidedAt = 0;
+    };
+
+    struct Lane {
+        QString endpoint;
+        int endpointCode = -1;          // ControlFrame::Endpoint
+        bool busy = false;
+        Command inFlight;
+        QPointer<QNetworkReply> reply;  // Null when in flight on the channel
+        quint32 sequence = 0;           // Channel frame in flight
+        qint64 sentAt = 0;              // LatencyMonitor::now() nanoseconds
+        bool hasPending = false;
+        Command pending;
+        qint64 lastSentAt = -1;
+        QTimer* rateTimer = nullptr;
+    };
+
+    Lane& lane(const QString& endpoint);
+    void dispatch(Lane& target);
+    void send(Lane& target, const Command& command);
+    // Frees the lane before its command's outcome is emitted, so a slot
+    // reacting to it can submit again; dispatch() afterwards
+    void release(Lane& target);
+    void abortInFlight(Lane& target);
+    qint64 minInterval() const;
+    void recordReply(const Lane& target, qint64 repliedAt);
+
+    void onChannelAcknowledged(quint32 sequence, const QString& direction, double roundTripMs);
+    void onChannelRejected(quint32 sequence, const QString& direction);
+    void onChannelReadyChanged();
+
+    QNetworkAccessManager* m_networkManager;
+    QPointer<ControlChannel> m_channel;
+    QString m_baseUrl;
+    int m_maxRate;
+
+    int m_sentCount;
+    int m_coalescedCount;
+    int m_droppedCount;
+
+    // A deque, so a Lane& stays valid when a slot connected to one of our
+    // signals submits to a new endpoint
+    std::deque<Lane> m_lanes;
+    LatencyMonitor* m_latency;
+};
@@ -0,0 +1,372 @@
+#include "ContractionHierarchy.h"
+#include "SearchScratch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct DynamicArc {
+    int node;
+    double cost;
+    int middle;
+};
+
+// Keeps the cheaper of two parallel arcs
+void addArc(std::vector<DynamicArc>& arcs, int node, double cost, int middle)
+{
+    for (DynamicArc& arc : arcs) {
+        if (arc.node == node) {
+            if (cost < arc.cost) {
+                arc.cost = cost;
+                arc.middle = middle;
+            }
+            return;
+        }
+    }
+    arcs.push_back({node, cost, middle});
+}
+
+void removeArc(std::vector<DynamicArc>& arcs, int node)
+{
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (arcs[i].node == node) {
+            arcs[i] = arcs.back();
+            arcs.pop_back();
+            return;
+        }
+    }
+}
+
+// The graph as it shrinks during preprocessing: arcs between the nodes
+// not contracted yet, shortcuts included
+class Contraction
+{
+public:
+    explicit Contraction(const NavGraph& graph)
+        : out(graph.nodeCount())
+        , in(graph.nodeCount())
+        , changed(graph.nodeCount(), 0)
+        , contractedNeighbours(graph.nodeCount(), 0)
+        , depth(graph.nodeCount(), 0)
+        , targetOf(graph.nodeCount(), 0)
+    {
+        for (int source = 0; source < graph.nodeCount(); ++source) {
+            for (int e = graph.edgeBegin(source); e < graph.edgeEnd(source); ++e) {
+                const int target = graph.edgeTargets[e];
+                const double cost = graph.edgeCosts[e];
+                if (target != source && std::isfinite(cost)) {
+                    addArc(out[source], target, cost, -1);
+                    addArc(in[target], source, cost, -1);
+                }
+            }
+        }
+    }
+
+    // Lower is contracted earlier: nodes whose removal adds few arcs, with
+    // a push away from areas that have already lost many nodes or stand on
+    // deep stacks of contracted ones, so the order spreads evenly over the
+    // arena and the hierarchy stays shallow
+    double priority(int node)
+    {
+        const int added = contract(node, false);
+        const int removed = static_cast<int>(in[node].size() + out[node].size());
+        return 2.0 * (added - removed) + contractedNeighbours[node] + depth[node];
+    }
+
+    // Adds the shortcuts that keep distances between the remaining nodes
+    // when node goes, or only counts them; returns their number
+    int contract(int node, bool apply)
+    {
+        // Searches for another way round stop early; a missed one costs
+        // a needless shortcut, never a wrong distance
+        const int settleLimit = apply ? 500 : 50;
+        int added = 0;
+
+        for (const DynamicArc& incoming : in[node]) {
+            double maxCost = -1.0;
+            for (const DynamicArc& outgoing : out[node]) {
+                if (outgoing.node != incoming.node) {
+                    maxCost = std::max(maxCost, incoming.cost + outgoing.cost);
+                }
+            }
+            if (maxCost < 0.0) {
+                continue;
+            }
+
+            ++searchId;
+            int targets = 0;
+            for (const DynamicArc& outgoing : out[node]) {
+                if (outgoing.node != incoming.node && targetOf[outgoing.node] != searchId) {
+                    targetOf[outgoing.node] = searchId;
+                    ++targets;
+                }
+            }
+            witnessSearch(incoming.node, node, maxCost, settleLimit, targets);
+            for (const DynamicArc& outgoing : out[node]) {
+                const double viaNode = incoming.cost + outgoing.cost;
+                if (outgoing.node == incoming.node || witness.gScore(outgoing.node) <= viaNode) {
+                    continue;
+                }
+                ++added;
+                if (apply) {
+                    addArc(out[incoming.node], outgoing.node, viaNode, node);
+                    addArc(in[outgoing.node], incoming.node, viaNode, node);
+                }
+            }
+        }
+
+        if (apply) {
+            for (const DynamicArc& incoming : in[node]) {
+                removeArc(out[incoming.node], node);
+                ++contractedNeighbours[incoming.node];
+                changed[incoming.node] = 1;
+                depth[incoming.node] = std::max(depth[incoming.node], depth[node] + 1);
+            }
+            for (const DynamicArc& outgoing : out[node]) {
+                removeArc(in[outgoing.node], node);
+                ++contractedNeighbours[outgoing.node];
+                changed[outgoing.node] = 1;
+                depth[outgoing.node] = std::max(depth[outgoing.node], depth[node] + 1);
+            }
+        }
+        return added;
+    }
+
+    std::vector<std::vector<DynamicArc>> out;
+    std::vector<std::vector<DynamicArc>> in;
+    std::vector<char> changed;      // Neighbourhood changed since the last priority()
+
+private:
+    std::vector<int> contractedNeighbours;
+    std::vector<int> depth;
+    std::vector<int> targetOf;      // Search that wants the node's cost
+    int searchId = 0;
+    SearchScratch witness;
+
+    // Costs from source avoiding skipped, up to maxCost or until the
+    // targets of this search are settled
+    void witnessSearch(int source, int skipped, double maxCost, int settleLimit, int targets)
+    {
+        witness.begin(static_cast<int>(out.size()));
+        witness.setScore(source, 0.0, -1);
+        witness.open.pushOrDecrease(source, 0.0);
+
+        for (int settled = 0; settled < settleLimit && !witness.open.isEmpty(); ++settled) {
+            if (witness.open.topKey() > maxCost) {
+                break;
+            }
+            const int current = witness.open.pop();
+            if (targetOf[current] == searchId && --targets == 0) {
+                break;
+            }
+            const double currentCost = witness.gScore(current);
+            for (const DynamicArc& arc : out[current]) {
+                const double cost = currentCost + arc.cost;
+                if (arc.node != skipped && cost < witness.gScore(arc.node)) {
+                    witness.setScore(arc.node, cost, current);
+                    witness.open.pushOrDecrease(arc.node, cost);
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+bool ContractionHierarchy::build(const NavGraph& graph, const std::atomic<bool>* cancelled)
+{
+    const int nodeCount = graph.nodeCount();
+    *this = ContractionHierarchy();
+
+    Contraction contraction(graph);
+    std::vector<std::vector<Arc>> upArcs(nodeCount);
+    std::vector<std::vector<Arc>> downArcs(nodeCount);
+    std::vector<int> order(nodeCount, -1);
+
+    IndexedHeap queue;
+    queue.reset(nodeCount);
+    for (int node = 0; node < nodeCount; ++node) {
+        queue.pushOrDecrease(node, contraction.priority(node));
+    }
+
+    int nextRank = 0;
+    while (!queue.isEmpty()) {
+        if (cancelled && *cancelled) {
+            return false;
+        }
+
+        // Priorities go stale as neighbours are contracted; a node whose
+        // neighbourhood changed gets a fresh one and goes back in the
+        // queue if that no longer wins
+        const int node = queue.pop();
+        if (contraction.changed[node]) {
+            const double priority = contraction.priority(node);
+            contraction.changed[node] = 0;
+            if (!queue.isEmpty() && priority > queue.topKey()) {
+                queue.pushOrDecrease(node, priority);
+                continue;
+            }
+        }
+
+        // Arcs still attached all lead to nodes contracted later
+        for (const DynamicArc& arc : contraction.out[node]) {
+            upArcs[node].push_back({arc.node, arc.cost, arc.middle});
+        }
+        for (const DynamicArc& arc : contraction.in[node]) {
+            downArcs[node].push_back({arc.node, arc.cost, arc.middle});
+        }
+        shortcuts += contraction.contract(node, true);
+        contraction.out[node] = std::vector<DynamicArc>();
+        contraction.in[node] = std::vector<DynamicArc>();
+        order[node] = nextRank++;
+    }
+
+    auto flatten = [nodeCount](std::vector<std::vector<Arc>>& arcs, std::vector<int>& offsets, std::vector<Arc>& flat) {
+        offsets.assign(nodeCount + 1, 0);
+        for (int node = 0; node < nodeCount; ++node) {
+            offsets[node + 1] = offsets[node] + static_cast<int>(arcs[node].size());
+        }
+        flat.reserve(offsets[nodeCount]);
+        for (std::vector<Arc>& nodeArcs : arcs) {
+            flat.insert(flat.end(), nodeArcs.begin(), nodeArcs.end());
+            nodeArcs = std::vector<Arc>();
+        }
+    };
+    flatten(upArcs, upOffsets, up);
+    flatten(downArcs, downOffsets, down);
+    rank = std::move(order);
+    return true;
+}
+
+std::vector<int> ContractionHierarchy::findPath(int startNode, int endNode,
+                                                SearchScratch& forward, SearchScratch& backward, int& expansions) const
+{
+    const int nodeCount = static_cast<int>(rank.size());
+    forward.begin(nodeCount);
+    backward.begin(nodeCount);
+    expansions = 0;
+    if (startNode == endNode) {
+        return std::vector<int>(1, startNode);
+    }
+
+    forward.setScore(startNode, 0.0, -1);
+    forward.open.pushOrDecrease(startNode, 0.0);
+    backward.setScore(endNode, 0.0, -1);
+    backward.open.pushOrDecrease(endNode, 0.0);
+
+    // Both searches climb until neither can still beat the best meeting
+    // node; unlike a flat bidirectional search they may not stop at the
+    // first one, as the top of the shortest path is usually further up
+    double best = std::numeric_limits<double>::infinity();
+    int meeting = -1;
+    while (true) {
+        const bool forwardOpen = !forward.open.isEmpty() && forward.open.topKey() < best;
+        const bool backwardOpen = !backward.open.isEmpty() && backward.open.topKey() < best;
+        if (!forwardOpen && !backwardOpen) {
+            break;
+        }
+
+        const bool forwardStep = forwardOpen && (!backwardOpen || forward.open.topKey() <= backward.open.topKey());
+        SearchScratch& side = forwardStep ? forward : backward;
+        const SearchScratch& other = forwardStep ? backward : forward;
+        const std::vector<int>& offsets = forwardStep ? upOffsets : downOffsets;
+        const std::vector<Arc>& arcs = forwardStep ? up : down;
+        const std::vector<int>& oppositeOffsets = forwardStep ? downOffsets : upOffsets;
+        const std::vector<Arc>& oppositeArcs = forwardStep ? down : up;
+
+        const int current = side.open.pop();
+        const double currentCost = side.gScore(current);
+        ++expansions;
+
+        const double through = currentCost + other.gScore(current);
+        if (through < best) {
+            best = through;
+            meeting = current;
+        }
+
+        // A cheaper way in from a higher node means the search reached
+        // current the long way round; it cannot be on a shortest path,
+        // so its arcs would only widen the search
+        bool stalled = false;
+        for (int i = oppositeOffsets[current]; i < oppositeOffsets[current + 1]; ++i) {
+            if (side.gScore(oppositeArcs[i].node) + oppositeArcs[i].cost < currentCost) {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled) {
+            continue;
+        }
+
+        for (int i = offsets[current]; i < offsets[current + 1]; ++i) {
+            const Arc& arc = arcs[i];
+            const double cost = currentCost + arc.cost;
+            if (cost < side.gScore(arc.node)) {
+                side.setScore(arc.node, cost, current);
+                side.open.pushOrDecrease(arc.node, cost);
+            }
+        }
+    }
+
+    if (meeting < 0) {
+        return std::vector<int>();
+    }
+
+    // Climb from the start to the meeting node, then down to the end, and
+    // expand each shortcut on the way into the edges it stands for
+    std::vector<int> climb;
+    for (int node = meeting; node >= 0; node = forward.parent(node)) {
+        climb.push_back(node);
+    }
+    std::reverse(climb.begin(), climb.end());
+    for (int node = backward.parent(meeting); node >= 0; node = backward.parent(node)) {
+        climb.push_back(node);
+    }
+
+    std::vector<int> path;
+    path.reserve(climb.size() * 4);
+    path.push_back(startNode);
+    std::vector<std::pair<int, int>> pending;
+    for (size_t i = 0; i + 1 < climb.size(); ++i) {
+        unpack(climb[i], climb[i + 1], path, pending);
+    }
+    return path;
+}
+
+const ContractionHierarchy::Arc& ContractionHierarchy::findArc(int from, int to) const
+{
+    // Parallel arcs were merged while contracting, so the first match is
+    // the only one
+    if (rank[from] < rank[to]) {
+        for (int i = upOffsets[from]; i < upOffsets[from + 1]; ++i) {
+            if (up[i].node == to) {
+                return up[i];
+            }
+        }
+    }
+    int i = downOffsets[to];
+    while (down[i].node != from) {
+        ++i;
+    }
+    return down[i];
+}
+
+void ContractionHierarchy::unpack(int from, int to, std::vector<int>& path,
+                                  std::vector<std::pair<int, int>>& pending) const
+{
+    pending.emplace_back(from, to);
+    while (!pending.empty()) {
+        const std::pair<int, int> arcEnds = pending.back();
+        pending.pop_back();
+
+        const int middle = findArc(arcEnds.first, arcEnds.second).middle;
+        if (middle < 0) {
+            path.push_back(arcEnds.second);
+        } else {
+            // The first half goes on top so it is expanded first
+            pending.emplace_back(middle, arcEnds.second);
+            pending.emplace_back(arcEnds.first, middle);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "NavGraph.h"
+
+class SearchScratch;
+
+// Contraction hierarchy over a NavGraph. Preprocessing removes the nodes
+// one at a time, least important first, and adds a shortcut u -> w
+// wherever u -> v -> w was the only shortest way between two remaining
+// nodes. A query then only ever climbs to more important nodes, forward
+// from the start and backward from the goal, and settles a few hundred
+// nodes where a flat search settles tens of thousands. Paths are exact.
+//
+// A hierarchy fits one set of edge costs; any cost change needs a new
+// build. Blocked (infinite) edges are left out.
+class ContractionHierarchy
+{
+public:
+    bool isEmpty() const { return rank.empty(); }
+    int shortcutCount() const { return shortcuts; }
+
+    // Contracts every node of graph. Returns false, leaving the hierarchy
+    // empty, as soon as cancelled is set.
+    bool build(const NavGraph& graph, const std::atomic<bool>* cancelled = nullptr);
+
+    // Shortest path from startNode to endNode on the graph the hierarchy
+    // was built from, empty if there is none. expansions receives the
+    // number of nodes settled by both searches.
+    std::vector<int> findPath(int startNode, int endNode,
+                              SearchScratch& forward, SearchScratch& backward, int& expansions) const;
+
+private:
+    struct Arc {
+        int node;       // Target of an upward arc, source of a downward one
+        double cost;
+        int middle;     // Node a shortcut bypasses, -1 for an edge of the graph
+    };
+
+    std::vector<int> rank;          // Contraction order, higher is more important
+    std::vector<int> upOffsets;     // Arcs to higher-ranked nodes, by source
+    std::vector<Arc> up;
+    std::vector<int> downOffsets;   // Arcs from higher-ranked nodes, by target
+    std::vector<Arc> down;
+    int shortcuts = 0;
+
+    const Arc& findArc(int from, int to) const;
+    // Appends the graph nodes after from on the arc from -> to; pending
+    // is working space
+    void unpack(int from, int to, std::vector<int>& path, std::vector<std::pair<int, int>>& pending) const;
+};
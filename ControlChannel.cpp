@@ -0,0 +1,216 @@
+#include "ControlChannel.h"
+#include "Logging.h"
+
+namespace {
+
+constexpr int keepAliveInterval = 250;      // ms between liveness checks
+constexpr qint64 pingAfterIdle = 1000;      // ms without traffic before a ping
+constexpr qint64 ackTimeout = 2000;         // ms an ack may be overdue
+constexpr int minReconnectDelay = 250;
+constexpr int maxReconnectDelay = 4000;
+
+}
+
+ControlChannel::ControlChannel(QObject *parent)
+    : QObject(parent)
+    , m_socket(new QTcpSocket(this))
+    , m_keepAliveTimer(new QTimer(this))
+    , m_reconnectTimer(new QTimer(this))
+    , m_port(0)
+    , m_ready(false)
+    , m_wanted(false)
+    , m_reconnectDelay(minReconnectDelay)
+    , m_nextSequence(1)
+    , m_lastSent(0)
+    , m_lastReceived(0)
+    , m_awaitingSince(-1)
+{
+    m_clock.start();
+
+    connect(m_socket, &QTcpSocket::connected, this, &ControlChannel::onConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &ControlChannel::onDisconnected);
+    connect(m_socket, &QTcpSocket::readyRead, this, &ControlChannel::onReadyRead);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, &ControlChannel::onErrorOccurred);
+
+    m_keepAliveTimer->setInterval(keepAliveInterval);
+    connect(m_keepAliveTimer, &QTimer::timeout, this, &ControlChannel::onKeepAlive);
+
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        if (m_wanted && m_socket->state() == QAbstractSocket::UnconnectedState) {
+            m_socket->connectToHost(m_host, m_port);
+        }
+    });
+}
+
+void ControlChannel::open(const QString& host, quint16 port)
+{
+    if (m_wanted && host == m_host && port == m_port) {
+        return;
+    }
+
+    close();
+    m_host = host;
+    m_port = port;
+    m_wanted = true;
+    m_reconnectDelay = minReconnectDelay;
+    qCInfo(lcChannel) << "Opening control channel to" << host << port;
+    m_socket->connectToHost(m_host, m_port);
+}
+
+void ControlChannel::close()
+{
+    m_wanted = false;
+    m_reconnectTimer->stop();
+    m_keepAliveTimer->stop();
+    m_socket->abort();
+    m_readBuffer.clear();
+    setReady(false);
+}
+
+quint32 ControlChannel::send(const QString& endpoint, const QString& command, int speed)
+{
+    ControlFrame frame;
+    frame.endpoint = ControlFrame::endpointCode(endpoint);
+    frame.command = ControlFrame::commandCode(command);
+    if (!m_ready || frame.endpoint == ControlFrame::NoCommand || frame.command == ControlFrame::NoCommand) {
+        return 0;
+    }
+
+    frame.type = ControlFrame::Command;
+    frame.speed = quint8(qBound(0, speed, 255));
+    return writeFrame(frame);
+}
+
+quint32 ControlChannel::writeFrame(ControlFrame frame)
+{
+    frame.sequence = m_nextSequence++;
+    if (m_nextSequence == 0) {
+        m_nextSequence = 1; // 0 means "not sent"
+    }
+
+    char bytes[ControlFrame::Size];
+    frame.encode(bytes);
+    if (m_socket->write(bytes, ControlFrame::Size) != ControlFrame::Size) {
+        return 0;
+    }
+
+    m_lastSent = m_clock.nsecsElapsed();
+    if (m_awaitingSince < 0) {
+        m_awaitingSince = m_lastSent;
+    }
+    PendingFrame& pending = m_pending[frame.sequence % m_pending.size()];
+    pending.sequence = frame.sequence;
+    pending.command = frame.type == ControlFrame::Command ? frame.command : ControlFrame::NoCommand;
+    pending.sentAt = m_lastSent;
+    return frame.sequence;
+}
+
+void ControlChannel::onConnected()
+{
+    // Small frames must not wait for Nagle coalescing
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+
+    qCInfo(lcChannel) << "Control channel connected";
+    m_reconnectDelay = minReconnectDelay;
+    m_lastReceived = m_lastSent = m_clock.nsecsElapsed();
+    m_awaitingSince = -1;
+    m_keepAliveTimer->start();
+    setReady(true);
+}
+
+void ControlChannel::onDisconnected()
+{
+    qCInfo(lcChannel) << "Control channel disconnected";
+    m_keepAliveTimer->stop();
+    m_readBuffer.clear();
+    setReady(false);
+    scheduleReconnect();
+}
+
+void ControlChannel::onErrorOccurred(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error)
+    emit channelError(m_socket->errorString());
+
+    // A failed connect never reaches disconnected()
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        setReady(false);
+        scheduleReconnect();
+    }
+}
+
+void ControlChannel::scheduleReconnect()
+{
+    if (!m_wanted || m_reconnectTimer->isActive()) {
+        return;
+    }
+
+    m_reconnectTimer->start(m_reconnectDelay);
+    m_reconnectDelay = qMin(m_reconnectDelay * 2, maxReconnectDelay);
+}
+
+void ControlChannel::onReadyRead()
+{
+    m_readBuffer.append(m_socket->readAll());
+    const qint64 now = m_clock.nsecsElapsed();
+
+    qsizetype offset = 0;
+    while (m_readBuffer.size() - offset >= ControlFrame::Size) {
+        ControlFrame frame;
+        if (!ControlFrame::decode(m_readBuffer.constData() + offset, frame)) {
+            ++offset; // Resynchronise on the next byte
+            continue;
+        }
+        offset += ControlFrame::Size;
+        m_lastReceived = now;
+        m_awaitingSince = -1;
+
+        if (frame.type != ControlFrame::Ack) {
+            continue;
+        }
+
+        PendingFrame& pending = m_pending[frame.sequence % m_pending.size()];
+        if (pending.sequence != frame.sequence || pending.command == ControlFrame::NoCommand) {
+            continue; // Ping, or evicted by newer frames
+        }
+
+        const QString command = ControlFrame::commandName(pending.command);
+        pending.sequence = 0;
+        if (frame.status == ControlFrame::Ok) {
+            emit acknowledged(frame.sequence, command, (now - pending.sentAt) / 1e6);
+        } else {
+            emit rejected(frame.sequence, command);
+        }
+    }
+    m_readBuffer.remove(0, offset);
+}
+
+void ControlChannel::onKeepAlive()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+
+    // Frames went out and nothing has come back in time; abort() emits
+    // disconnected(), which schedules the reconnect
+    if (m_awaitingSince >= 0 && now - m_awaitingSince > ackTimeout * 1000000) {
+        qCWarning(lcChannel) << "Control channel ack overdue, reconnecting";
+        emit channelError(QStringLiteral("Control channel timed out"));
+        m_socket->abort();
+        return;
+    }
+
+    if (now - qMax(m_lastSent, m_lastReceived) > pingAfterIdle * 1000000) {
+        ControlFrame ping;
+        ping.type = ControlFrame::Ping;
+        writeFrame(ping);
+    }
+}
+
+void ControlChannel::setReady(bool ready)
+{
+    if (m_ready != ready) {
+        m_ready = ready;
+        emit readyChanged();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <array>
+#include "ControlFrame.h"
+
+// Persistent TCP connection to the car carrying ControlFrames.
+// Commands are pipelined: send() writes the frame straight away and the acks
+// are matched back to it by sequence number to measure the round trip. An
+// idle connection is pinged so a dead link is noticed and reconnected before
+// the next command needs it.
+class ControlChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlChannel(QObject *parent = nullptr);
+
+    void open(const QString& host, quint16 port);
+    void close();
+
+    // Whether the socket is connected; an overdue ack aborts the socket,
+    // which clears it along with any other disconnect
+    bool isReady() const { return m_ready; }
+
+    // Writes a command frame and returns its sequence number, or 0 if the
+    // channel is not ready or the command has no binary code
+    quint32 send(const QString& endpoint, const QString& command, int speed);
+
+signals:
+    void readyChanged();
+    void acknowledged(quint32 sequence, const QString& command, double roundTripMs);
+    void rejected(quint32 sequence, const QString& command);
+    void channelError(const QString& error);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onReadyRead();
+    void onErrorOccurred(QAbstractSocket::SocketError error);
+    void onKeepAlive();
+
+private:
+    struct PendingFrame {
+        quint32 sequence = 0;
+        quint8 command = ControlFrame::NoCommand;
+        qint64 sentAt = 0;    // m_clock nanoseconds
+    };
+
+    void setReady(bool ready);
+    quint32 writeFrame(ControlFrame frame);
+    void scheduleReconnect();
+
+    QTcpSocket* m_socket;
+    QTimer* m_keepAliveTimer;
+    QTimer* m_reconnectTimer;
+    QString m_host;
+    quint16 m_port;
+    bool m_ready;
+    bool m_wanted;
+    int m_reconnectDelay;
+
+    quint32 m_nextSequence;
+    QByteArray m_readBuffer;
+    QElapsedTimer m_clock;
+    qint64 m_lastSent;
+    qint64 m_lastReceived;
+    qint64 m_awaitingSince;   // First frame sent since the last reply, -1 if none
+
+    // Frames in flight by sequence modulo size; an entry overwritten before
+    // its ack arrives simply gets no round-trip sample
+    std::array<PendingFrame, 64> m_pending;
+};
@@ -0,0 +1,82 @@
+#include "ControlFrame.h"
+#include <QByteArrayView>
+#include <QtEndian>
+#include <iterator>
+
+namespace {
+
+// Wire codes are the positions in these tables, only append to them
+const char* const commandNames[] = {
+    "stop", "forward", "backward", "left", "right",
+    "open", "close", "dumperOpen", "dumperClose"
+};
+
+const char* const endpointPaths[] = { "/control", "/arm", "/dumper" };
+
+constexpr int crcOffset = ControlFrame::Size - 2;
+
+}
+
+void ControlFrame::encode(char* out) const
+{
+    uchar* bytes = reinterpret_cast<uchar*>(out);
+    qToLittleEndian<quint16>(Magic, bytes);
+    bytes[2] = Version;
+    bytes[3] = type;
+    qToLittleEndian<quint32>(sequence, bytes + 4);
+    bytes[8] = endpoint;
+    bytes[9] = command;
+    bytes[10] = speed;
+    bytes[11] = status;
+    qToLittleEndian<quint16>(0, bytes + 12);
+    qToLittleEndian<quint16>(qChecksum(QByteArrayView(out, crcOffset)), bytes + crcOffset);
+}
+
+bool ControlFrame::decode(const char* in, ControlFrame& frame)
+{
+    const uchar* bytes = reinterpret_cast<const uchar*>(in);
+    if (qFromLittleEndian<quint16>(bytes) != Magic || bytes[2] != Version) {
+        return false;
+    }
+    if (qFromLittleEndian<quint16>(bytes + crcOffset) != qChecksum(QByteArrayView(in, crcOffset))) {
+        return false;
+    }
+
+    frame.type = bytes[3];
+    frame.sequence = qFromLittleEndian<quint32>(bytes + 4);
+    frame.endpoint = bytes[8];
+    frame.command = bytes[9];
+    frame.speed = bytes[10];
+    frame.status = bytes[11];
+    return true;
+}
+
+quint8 ControlFrame::commandCode(const QString& name)
+{
+    for (int i = 0; i < int(std::size(commandNames)); ++i) {
+        if (name == QLatin1String(commandNames[i])) {
+            return quint8(i);
+        }
+    }
+    return NoCommand;
+}
+
+QString ControlFrame::commandName(quint8 code)
+{
+    return code < std::size(commandNames) ? QString::fromLatin1(commandNames[code]) : QString();
+}
+
+quint8 ControlFrame::endpointCode(const QString& path)
+{
+    for (int i = 0; i < int(std::size(endpointPaths)); ++i) {
+        if (path == QLatin1String(endpointPaths[i])) {
+            return quint8(i);
+        }
+    }
+    return NoCommand;
+}
+
+QString ControlFrame::endpointPath(quint8 code)
+{
+    return code < std::size(endpointPaths) ? QString::fromLatin1(endpointPaths[code]) : QString();
+}
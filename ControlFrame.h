@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+// Fixed-size binary frame of the low-latency control channel, shared by the
+// app and tools/car_stub_server. All fields are little-endian:
+//
+//   0  magic     u16  0x4352 ("RC")
+//   2  version   u8
+//   3  type      u8   Command, Ack or Ping
+//   4  sequence  u32  echoed back in the ack
+//   8  endpoint  u8   /control, /arm or /dumper
+//   9  command   u8   index into the command table
+//  10  speed     u8
+//  11  status    u8   set by the car in acks
+//  12  reserved  u16
+//  14  crc       u16  qChecksum (CRC-16/X.25) over bytes 0..13
+struct ControlFrame
+{
+    static constexpr int Size = 16;
+    static constexpr quint16 Magic = 0x4352;
+    static constexpr quint8 Version = 1;
+
+    enum Type : quint8 {
+        Command = 1,
+        Ack = 2,
+        Ping = 3    // Keep-alive, acked like a command
+    };
+
+    enum Endpoint : quint8 {
+        Control = 0,
+        Arm = 1,
+        Dumper = 2
+    };
+
+    enum Status : quint8 {
+        Ok = 0,
+        UnknownCommand = 1
+    };
+
+    static constexpr quint8 NoCommand = 0xFF;
+
+    quint8 type = Command;
+    quint32 sequence = 0;
+    quint8 endpoint = Control;
+    quint8 command = 0;
+    quint8 speed = 0;
+    quint8 status = Ok;
+
+    void encode(char* out) const;
+    // False if the bytes are not a valid frame (magic, version or crc)
+    static bool decode(const char* in, ControlFrame& frame);
+
+    // Command names as used by the HTTP API; NoCommand if there is no code
+    static quint8 commandCode(const QString& name);
+    static QString commandName(quint8 code);
+    static quint8 endpointCode(const QString& path);
+    static QString endpointPath(quint8 code);
+};
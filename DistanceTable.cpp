@@ -0,0 +1,250 @@
+#include "DistanceTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+void DistanceTable::clear()
+{
+    nodeCount = 0;
+    stride = 0;
+    keys.clear();
+    slotOfNode.clear();
+    costs.clear();
+    nextEdge.clear();
+    incoming.clear();
+}
+
+void DistanceTable::build(const NavGraph& graph, const std::vector<int>& keyNodes)
+{
+    clear();
+    addKeys(graph, keyNodes);
+}
+
+void DistanceTable::indexIncomingEdges(const NavGraph& graph)
+{
+    nodeCount = graph.nodeCount();
+    slotOfNode.assign(nodeCount, -1);
+    incoming.build(graph);
+}
+
+bool DistanceTable::restore(const NavGraph& graph, const std::vector<int>& keyNodes,
+                            const double* keyCosts, const int* nextEdges)
+{
+    clear();
+    // Later addKeys() calls search backwards from the new keys
+    indexIncomingEdges(graph);
+
+    for (int node : keyNodes) {
+        if (node < 0 || node >= nodeCount || slotOfNode[node] >= 0) {
+            clear();
+            return false;
+        }
+        slotOfNode[node] = static_cast<int>(keys.size());
+        keys.push_back(node);
+    }
+
+    stride = keyCount();
+    costs.assign(static_cast<size_t>(stride) * stride, std::numeric_limits<double>::infinity());
+    nextEdge.assign(nextEdges, nextEdges + static_cast<size_t>(stride) * nodeCount);
+
+    std::vector<double> dist;
+    for (int slot = 0; slot < stride; ++slot) {
+        if (!checkColumn(graph, slot, dist)) {
+            clear();
+            return false;
+        }
+        for (int from = 0; from < stride; ++from) {
+            const double stored = keyCosts[from * stride + slot];
+            const double walked = dist[keys[from]];
+            if (stored != walked && !(std::abs(stored - walked) <= 1e-9 * std::max(1.0, walked))) {
+                clear();
+                return false;
+            }
+            costs[from * stride + slot] = walked;
+        }
+    }
+    return true;
+}
+
+bool DistanceTable::checkColumn(const NavGraph& graph, int slot, std::vector<double>& dist) const
+{
+    // The walks in appendPath() and walkCost() trust the next hops, so a
+    // stored column must be a shortest-path tree into its key: every hop
+    // leaves its node, every chain ends at the key, the hops are tight and
+    // no edge leads anywhere cheaper
+    const double infinity = std::numeric_limits<double>::infinity();
+    const int* next = nextEdge.data() + static_cast<size_t>(slot) * nodeCount;
+    const int target = keys[slot];
+    if (next[target] != -1) {
+        return false;
+    }
+
+    // NaN until known; chains are followed once and then read back
+    dist.assign(nodeCount, std::numeric_limits<double>::quiet_NaN());
+    dist[target] = 0.0;
+    std::vector<int> chain;
+    std::vector<char> onChain(nodeCount, 0);
+    for (int start = 0; start < nodeCount; ++start) {
+        int node = start;
+        while (std::isnan(dist[node])) {
+            const int e = next[node];
+            if (e == -1) {
+                dist[node] = infinity;
+                break;
+            }
+            if (e < graph.edgeBegin(node) || e >= graph.edgeEnd(node) || onChain[node]) {
+                return false;
+            }
+            onChain[node] = 1;
+            chain.push_back(node);
+            node = graph.edgeTargets[e];
+        }
+        if (!chain.empty() && dist[node] == infinity) {
+            return false; // A chain that never reaches the key
+        }
+        for (; !chain.empty(); chain.pop_back()) {
+            const int hop = chain.back();
+            dist[hop] = graph.edgeCosts[next[hop]] + dist[graph.edgeTargets[next[hop]]];
+            onChain[hop] = 0;
+        }
+    }
+
+    for (int node = 0; node < nodeCount; ++node) {
+        for (int e = graph.edgeBegin(node); e < graph.edgeEnd(node); ++e) {
+            if (graph.edgeCosts[e] + dist[graph.edgeTargets[e]] < dist[node]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DistanceTable::addKeys(const NavGraph& graph, const std::vector<int>& keyNodes)
+{
+    if (incoming.isEmpty()) {
+        // First use for this graph: index incoming edges once
+        indexIncomingEdges(graph);
+    }
+
+    const int oldCount = keyCount();
+    for (int node : keyNodes) {
+        if (node >= 0 && node < nodeCount && slotOfNode[node] < 0) {
+            slotOfNode[node] = static_cast<int>(keys.size());
+            keys.push_back(node);
+        }
+    }
+
+    const int newCount = keyCount();
+    if (newCount == oldCount) {
+        return false;
+    }
+
+    if (newCount > stride) {
+        resizeCosts(std::max(newCount, stride * 2));
+    }
+    nextEdge.resize(static_cast<size_t>(newCount) * nodeCount, -1);
+
+    // New columns: one backward search per new key gives the cost from
+    // every node, so all rows of that column are filled at once.
+    std::vector<double> dist;
+    for (int slot = oldCount; slot < newCount; ++slot) {
+        computeColumn(graph, slot, dist);
+        for (int from = 0; from < newCount; ++from) {
+            costs[from * stride + slot] = dist[keys[from]];
+        }
+    }
+
+    // New rows against old columns: follow the stored next-hop chains.
+    for (int from = oldCount; from < newCount; ++from) {
+        for (int slot = 0; slot < oldCount; ++slot) {
+            costs[from * stride + slot] = walkCost(graph, keys[from], slot);
+        }
+    }
+
+    return true;
+}
+
+void DistanceTable::resizeCosts(int newStride)
+{
+    std::vector<double> resized(static_cast<size_t>(newStride) * newStride,
+                                std::numeric_limits<double>::infinity());
+    for (int from = 0; from < stride; ++from) {
+        for (int to = 0; to < stride; ++to) {
+            resized[from * newStride + to] = costs[from * stride + to];
+        }
+    }
+    costs.swap(resized);
+    stride = newStride;
+}
+
+void DistanceTable::computeColumn(const NavGraph& graph, int slot, std::vector<double>& dist)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    dist.assign(nodeCount, infinity);
+
+    int* next = nextEdge.data() + static_cast<size_t>(slot) * nodeCount;
+
+    using QueueEntry = std::pair<double, int>; // (cost to key, node)
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    int target = keys[slot];
+    dist[target] = 0.0;
+    queue.emplace(0.0, target);
+
+    while (!queue.empty()) {
+        auto [d, node] = queue.top();
+        queue.pop();
+
+        if (d > dist[node]) {
+            continue; // Stale entry
+        }
+
+        for (int r = incoming.offsets[node]; r < incoming.offsets[node + 1]; ++r) {
+            int e = incoming.edges[r];
+            int source = incoming.sources[r];
+
+            double candidate = d + graph.edgeCosts[e];
+            if (candidate < dist[source]) {
+                dist[source] = candidate;
+                next[source] = e;
+                queue.emplace(candidate, source);
+            }
+        }
+    }
+}
+
+double DistanceTable::walkCost(const NavGraph& graph, int fromNode, int slot) const
+{
+    const int* next = nextEdge.data() + static_cast<size_t>(slot) * nodeCount;
+    const int target = keys[slot];
+
+    double total = 0.0;
+    int node = fromNode;
+    while (node != target) {
+        int e = next[node];
+        if (e < 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        total += graph.edgeCosts[e];
+        node = graph.edgeTargets[e];
+    }
+    return total;
+}
+
+bool DistanceTable::appendPath(const NavGraph& graph, int fromNode, int toNode, std::vector<int>& path) const
+{
+    const int slot = slotOfNode[toNode];
+    const int* next = nextEdge.data() + static_cast<size_t>(slot) * nodeCount;
+
+    if (fromNode != toNode && next[fromNode] < 0) {
+        return false;
+    }
+
+    int node = fromNode;
+    while (node != toNode) {
+        node = graph.edgeTargets[next[node]];
+        path.push_back(node);
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "NavGraph.h"
+
+// All-pairs shortest-path costs between a set of key nodes (starts,
+// release, balls, comm tower, plus whatever a planner asks for), together
+// with a next-hop table so a full path between two key nodes can be
+// expanded by walking successors instead of running another search.
+//
+// Each key node gets one backward Dijkstra over the whole graph. The
+// result is stored as the next edge to take from every node towards that
+// key, so memory is keyCount() * nodeCount() ints plus a keyCount()^2 cost
+// matrix.
+class DistanceTable
+{
+public:
+    void clear();
+    bool isEmpty() const { return keys.empty(); }
+
+    // Builds the table for the given key nodes. Duplicates are ignored.
+    void build(const NavGraph& graph, const std::vector<int>& keyNodes);
+
+    // Adds key nodes that are not in the table yet, reusing the existing
+    // columns. Returns true if anything had to be computed.
+    bool addKeys(const NavGraph& graph, const std::vector<int>& keyNodes);
+
+    // Takes a table stored with an arena (see ArenaFile) instead of
+    // computing it: keyCount()^2 costs by slot and keyCount() * nodeCount()
+    // next edges. False unless the next edges form shortest paths on graph
+    // and the costs match them, which takes O(keyCount() * edgeCount())
+    // but no searches.
+    bool restore(const NavGraph& graph, const std::vector<int>& keyNodes,
+                 const double* keyCosts, const int* nextEdges);
+    const std::vector<int>& nextEdges() const { return nextEdge; }
+
+    int keyCount() const { return static_cast<int>(keys.size()); }
+    const std::vector<int>& keyNodes() const { return keys; }
+    bool containsNode(int node) const { return node >= 0 && node < static_cast<int>(slotOfNode.size()) && slotOfNode[node] >= 0; }
+    int slotOf(int node) const { return slotOfNode[node]; }
+
+    // Shortest path cost between two key nodes, infinity if unreachable.
+    double cost(int fromNode, int toNode) const
+    {
+        return costs[slotOfNode[fromNode] * stride + slotOfNode[toNode]];
+    }
+
+    double costBySlot(int fromSlot, int toSlot) const
+    {
+        return costs[fromSlot * stride + toSlot];
+    }
+
+    // Appends the shortest path from fromNode to toNode (which must be a
+    // key node) to path, excluding fromNode itself. fromNode may be any
+    // node. Returns false if toNode is unreachable.
+    bool appendPath(const NavGraph& graph, int fromNode, int toNode, std::vector<int>& path) const;
+
+private:
+    void indexIncomingEdges(const NavGraph& graph);
+    void computeColumn(const NavGraph& graph, int slot, std::vector<double>& dist);
+    bool checkColumn(const NavGraph& graph, int slot, std::vector<double>& dist) const;
+    double walkCost(const NavGraph& graph, int fromNode, int slot) const;
+    void resizeCosts(int newStride);
+
+    int nodeCount = 0;
+    int stride = 0;                 // Row length of costs (>= keyCount())
+    std::vector<int> keys;
+    std::vector<int> slotOfNode;    // nodeCount entries, -1 for non-key nodes
+    std::vector<double> costs;      // stride * stride, row = from, column = to
+    std::vector<int> nextEdge;      // keyCount() * nodeCount(), -1 if no path
+
+    ReverseIndex incoming;          // Built once per graph
+};
@@ -0,0 +1,250 @@
+#include "ExactRouteSolver.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+ExactRouteSolver::ExactRouteSolver()
+    : nodeBudget(500000)
+    , proven(false)
+    , bestRouteCost(std::numeric_limits<double>::infinity())
+    , costMatrix(nullptr)
+    , genomeLength(0)
+    , expandedNodes(0)
+    , aborted(false)
+{}
+
+std::vector<int> ExactRouteSolver::solveHeldKarp(const std::vector<double>& costs,
+                                                 int targetCount,
+                                                 const PlannerControl& control)
+{
+    proven = false;
+    bestRouteCost = std::numeric_limits<double>::infinity();
+    if (targetCount <= 0 || targetCount > heldKarpLimit) {
+        return std::vector<int>();
+    }
+
+    const int n = targetCount;
+    const int stride = n + 1;
+    const std::uint32_t fullMask = (std::uint32_t(1) << n) - 1;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // best[mask * n + last]: cheapest way from the start through exactly
+    // the targets in mask, ending at last
+    std::vector<double> best(static_cast<size_t>(fullMask + 1) * n, infinity);
+    std::vector<std::int8_t> parent(static_cast<size_t>(fullMask + 1) * n, -1);
+
+    for (int target = 0; target < n; ++target) {
+        best[(std::uint32_t(1) << target) * n + target] = costs[n * stride + target];
+    }
+
+    for (std::uint32_t mask = 1; mask <= fullMask; ++mask) {
+        if ((mask & 4095) == 0) {
+            if (control.isCancelled()) {
+                return std::vector<int>();
+            }
+            control.reportProgress(static_cast<int>(mask), static_cast<int>(fullMask), 0.0);
+        }
+
+        for (int last = 0; last < n; ++last) {
+            const double current = best[static_cast<size_t>(mask) * n + last];
+            if (!(mask & (std::uint32_t(1) << last)) || current == infinity) {
+                continue;
+            }
+
+            for (int next = 0; next < n; ++next) {
+                const std::uint32_t bit = std::uint32_t(1) << next;
+                if (mask & bit) {
+                    continue;
+                }
+
+                const size_t cell = static_cast<size_t>(mask | bit) * n + next;
+                const double candidate = current + costs[last * stride + next];
+                if (candidate < best[cell]) {
+                    best[cell] = candidate;
+                    parent[cell] = static_cast<std::int8_t>(last);
+                }
+            }
+        }
+    }
+
+    int last = 0;
+    for (int target = 1; target < n; ++target) {
+        if (best[static_cast<size_t>(fullMask) * n + target] < best[static_cast<size_t>(fullMask) * n + last]) {
+            last = target;
+        }
+    }
+    bestRouteCost = best[static_cast<size_t>(fullMask) * n + last];
+    if (bestRouteCost == infinity) {
+        // No order reaches every target, and the parents of the full
+        // mask were never set
+        return std::vector<int>();
+    }
+
+    // Walk the parents back from the cheapest end point
+    std::vector<int> order(n);
+    std::uint32_t mask = fullMask;
+    for (int position = n - 1; position >= 0; --position) {
+        order[position] = last;
+        const int previous = parent[static_cast<size_t>(mask) * n + last];
+        mask &= ~(std::uint32_t(1) << last);
+        last = previous;
+    }
+
+    proven = true;
+    control.reportProgress(static_cast<int>(fullMask), static_cast<int>(fullMask), bestRouteCost);
+    return order;
+}
+
+std::vector<int> ExactRouteSolver::solveBranchAndBound(const std::vector<double>& costs,
+                                                       int targetCount,
+                                                       const std::vector<int>& initialOrder,
+                                                       const PlannerControl& control)
+{
+    proven = false;
+    costMatrix = costs.data();
+    genomeLength = targetCount;
+    expandedNodes = 0;
+    aborted = false;
+
+    bestOrder = initialOrder;
+    bestRouteCost = static_cast<int>(initialOrder.size()) == targetCount
+                        ? routeCost(initialOrder)
+                        : std::numeric_limits<double>::infinity();
+    if (targetCount <= 0) {
+        return bestOrder;
+    }
+
+    const int n = targetCount;
+    const int stride = n + 1;
+
+    // Cheapest sources into every target and cheapest targets out of every
+    // row, for the bound and for trying near targets first
+    incomingOrder.assign(n, std::vector<int>());
+    for (int target = 0; target < n; ++target) {
+        std::vector<int>& order = incomingOrder[target];
+        for (int from = 0; from < stride; ++from) {
+            if (from != target) {
+                order.push_back(from);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return costs[a * stride + target] < costs[b * stride + target];
+        });
+    }
+
+    neighbourOrder.assign(stride, std::vector<int>(n));
+    for (int from = 0; from < stride; ++from) {
+        std::vector<int>& order = neighbourOrder[from];
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return costs[from * stride + a] < costs[from * stride + b];
+        });
+    }
+
+    currentOrder.assign(n, 0);
+    visited.assign(n, 0);
+
+    if (lowerBound(n) == std::numeric_limits<double>::infinity()) {
+        // Some target can't be reached at all, so every route is infinite
+        return std::vector<int>();
+    }
+
+    branch(0, n, 0.0, control);
+
+    if (control.isCancelled() || bestRouteCost == std::numeric_limits<double>::infinity()) {
+        return std::vector<int>();
+    }
+
+    proven = !aborted;
+    control.reportProgress(1, 1, bestRouteCost);
+    return bestOrder;
+}
+
+double ExactRouteSolver::routeCost(const std::vector<int>& order) const
+{
+    const int stride = genomeLength + 1;
+
+    // Start is the last row of the matrix
+    double totalDistance = costMatrix[genomeLength * stride + order[0]];
+    for (int i = 0; i + 1 < genomeLength; ++i) {
+        totalDistance += costMatrix[order[i] * stride + order[i + 1]];
+    }
+
+    return totalDistance;
+}
+
+double ExactRouteSolver::lowerBound(int last) const
+{
+    // Every unvisited target still has to be entered once, either from
+    // the current end of the route or from another unvisited target
+    const int stride = genomeLength + 1;
+    double bound = 0.0;
+
+    for (int target = 0; target < genomeLength; ++target) {
+        if (visited[target]) {
+            continue;
+        }
+
+        double cheapest = std::numeric_limits<double>::infinity();
+        for (int from : incomingOrder[target]) {
+            if (from == last || (from < genomeLength && !visited[from])) {
+                cheapest = costMatrix[from * stride + target];
+                break;
+            }
+        }
+        bound += cheapest;
+    }
+
+    return bound;
+}
+
+void ExactRouteSolver::branch(int depth, int last, double cost, const PlannerControl& control)
+{
+    if (aborted) {
+        return;
+    }
+
+    if (depth == genomeLength) {
+        if (cost < bestRouteCost) {
+            bestRouteCost = cost;
+            bestOrder = currentOrder;
+        }
+        return;
+    }
+
+    if (cost + lowerBound(last) >= bestRouteCost) {
+        return;
+    }
+
+    if (++expandedNodes > nodeBudget) {
+        aborted = true;
+        return;
+    }
+
+    if ((expandedNodes & 4095) == 0) {
+        if (control.isCancelled()) {
+            aborted = true;
+            return;
+        }
+        control.reportProgress(static_cast<int>(expandedNodes / 4096),
+                               static_cast<int>(nodeBudget / 4096),
+                               bestRouteCost);
+    }
+
+    const int stride = genomeLength + 1;
+    for (int next : neighbourOrder[last]) {
+        if (visited[next]) {
+            continue;
+        }
+
+        const double nextCost = cost + costMatrix[last * stride + next];
+        if (nextCost >= bestRouteCost) {
+            continue;
+        }
+
+        visited[next] = 1;
+        currentOrder[depth] = next;
+        branch(depth + 1, next, nextCost, control);
+        visited[next] = 0;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "PlannerControl.h"
+
+// Exact solvers for the open-path TSP behind findOptimalCollectionRoute,
+// on the same cost matrix layout as GeneticRouteSolver: (targetCount + 1)^2,
+// row-major, with the start as the last row.
+//
+// Held-Karp is O(2^n * n^2) time and O(2^n * n) memory, which is instant
+// up to heldKarpLimit targets. Branch and bound handles a few more targets
+// when it is given a good initial route to prune against, and gives up
+// (without a proof) after nodeBudget search nodes.
+class ExactRouteSolver
+{
+public:
+    static constexpr int heldKarpLimit = 16;
+    static constexpr int branchAndBoundLimit = 24;
+
+    ExactRouteSolver();
+
+    void setNodeBudget(std::int64_t budget) { nodeBudget = budget; }
+
+    // Returns the optimal target order, or an empty vector when cancelled
+    // or when no order visits every target at a finite cost
+    std::vector<int> solveHeldKarp(const std::vector<double>& costs,
+                                   int targetCount,
+                                   const PlannerControl& control = PlannerControl());
+
+    // Searches for a route cheaper than initialOrder and returns the best
+    // one known, which is initialOrder itself if nothing better exists.
+    // Empty when cancelled or when no order has a finite cost.
+    std::vector<int> solveBranchAndBound(const std::vector<double>& costs,
+                                         int targetCount,
+                                         const std::vector<int>& initialOrder,
+                                         const PlannerControl& control = PlannerControl());
+
+    // True if the last solve finished its search, so bestCost() is optimal
+    bool provenOptimal() const { return proven; }
+    double bestCost() const { return bestRouteCost; }
+
+private:
+    std::int64_t nodeBudget;
+    bool proven;
+    double bestRouteCost;
+
+    // Branch and bound state
+    const double* costMatrix;
+    int genomeLength;
+    std::int64_t expandedNodes;
+    bool aborted;
+    std::vector<std::vector<int>> incomingOrder;  // Per target, sources cheapest first
+    std::vector<std::vector<int>> neighbourOrder; // Per row, targets nearest first
+    std::vector<int> currentOrder;
+    std::vector<int> bestOrder;
+    std::vector<char> visited;
+
+    double routeCost(const std::vector<int>& order) const;
+    double lowerBound(int last) const;
+    void branch(int depth, int last, double cost, const PlannerControl& control);
+};
@@ -0,0 +1,324 @@
+#include "GeneticRouteSolver.h"
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+GeneticRouteSolver::GeneticRouteSolver(const GeneticSettings& settings)
+    : settings(settings)
+    , costMatrix(nullptr)
+    , genomeLength(0)
+    , populationSize(0)
+    , eliteCount(0)
+    , migrantCount(0)
+    , bestFitness(std::numeric_limits<double>::max())
+{}
+
+std::vector<int> GeneticRouteSolver::solve(const std::vector<double>& costs,
+                                           int targetCount,
+                                           unsigned int seed,
+                                           const PlannerControl& control,
+                                           const ImprovedCallback& improved)
+{
+    bestFitness = std::numeric_limits<double>::max();
+    if (targetCount <= 0) {
+        return std::vector<int>();
+    }
+
+    costMatrix = costs.data();
+    genomeLength = targetCount;
+    populationSize = std::max(2, settings.populationSize);
+    eliteCount = std::min(populationSize - 1, static_cast<int>(populationSize * settings.elitePercentage));
+    migrantCount = std::min(settings.migrantCount, populationSize / 2);
+
+    const int islandCount = std::max(1, settings.islandCount);
+    const int generations = settings.generations;
+    const int epochLength = std::max(1, settings.migrationInterval);
+
+    // Everything the generations need is allocated here, up front
+    islands.resize(islandCount);
+    for (int i = 0; i < islandCount; ++i) {
+        initializeIsland(islands[i], seed, i);
+    }
+    migrants.resize(static_cast<size_t>(islandCount) * migrantCount * genomeLength);
+    migrantFitness.resize(static_cast<size_t>(islandCount) * migrantCount);
+    bestOrder.assign(genomeLength, 0);
+    updateBest();
+
+    // Islands 1..n-1 get a thread each for the whole run and island 0 runs
+    // here. Islands only synchronise at epoch boundaries, so the result
+    // depends on the seed and island count but not on thread timing.
+    std::mutex mutex;
+    std::condition_variable epochStarted;
+    std::condition_variable epochDone;
+    int epoch = 0;
+    int epochGenerations = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+    workers.reserve(islandCount - 1);
+    for (int i = 1; i < islandCount; ++i) {
+        workers.emplace_back([&, i]() {
+            int seenEpoch = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                epochStarted.wait(lock, [&]() { return stopping || epoch != seenEpoch; });
+                if (stopping) {
+                    return;
+                }
+                seenEpoch = epoch;
+                const int count = epochGenerations;
+
+                lock.unlock();
+                evolveIsland(islands[i], count, control);
+                lock.lock();
+
+                if (--pending == 0) {
+                    epochDone.notify_one();
+                }
+            }
+        });
+    }
+
+    for (int generation = 0; generation < generations; generation += epochLength) {
+        if (control.isCancelled()) {
+            break;
+        }
+
+        const int count = std::min(epochLength, generations - generation);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            epochGenerations = count;
+            pending = islandCount - 1;
+            ++epoch;
+        }
+        epochStarted.notify_all();
+
+        evolveIsland(islands[0], count, control);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            epochDone.wait(lock, [&]() { return pending == 0; });
+        }
+
+        if (control.isCancelled()) {
+            break;
+        }
+
+        if ((updateBest() || generation == 0) && improved) {
+            improved(bestOrder, bestFitness);
+        }
+        control.reportProgress(generation + count, generations, bestFitness);
+
+        migrateElites();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    epochStarted.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (control.isCancelled()) {
+        return std::vector<int>();
+    }
+
+    return bestOrder;
+}
+
+void GeneticRouteSolver::initializeIsland(Island& island, unsigned int seed, int index)
+{
+    std::seed_seq islandSeed{seed, static_cast<unsigned int>(index)};
+    island.rng.seed(islandSeed);
+
+    const size_t cells = static_cast<size_t>(populationSize) * genomeLength;
+    island.genes.resize(cells);
+    island.nextGenes.resize(cells);
+    island.fitness.resize(populationSize);
+    island.ranking.resize(populationSize);
+    island.used.resize((genomeLength + 63) / 64);
+
+    // Random permutations of the targets
+    for (int row = 0; row < populationSize; ++row) {
+        int* genome = &island.genes[static_cast<size_t>(row) * genomeLength];
+        std::iota(genome, genome + genomeLength, 0);
+        std::shuffle(genome, genome + genomeLength, island.rng);
+    }
+
+    evaluateIsland(island);
+}
+
+void GeneticRouteSolver::evolveIsland(Island& island, int generations, const PlannerControl& control)
+{
+    for (int generation = 0; generation < generations; ++generation) {
+        if (control.isCancelled()) {
+            return;
+        }
+
+        // Keep elite individuals
+        for (int i = 0; i < eliteCount; ++i) {
+            const int* elite = &island.genes[static_cast<size_t>(island.ranking[i]) * genomeLength];
+            std::copy(elite, elite + genomeLength, &island.nextGenes[static_cast<size_t>(i) * genomeLength]);
+        }
+
+        // Fill rest with crossover and mutation
+        for (int row = eliteCount; row < populationSize; ++row) {
+            const int* parent1 = &island.genes[static_cast<size_t>(tournament(island)) * genomeLength];
+            const int* parent2 = &island.genes[static_cast<size_t>(tournament(island)) * genomeLength];
+            int* offspring = &island.nextGenes[static_cast<size_t>(row) * genomeLength];
+
+            crossover(island, parent1, parent2, offspring);
+            mutate(island, offspring);
+        }
+
+        island.genes.swap(island.nextGenes);
+        evaluateIsland(island);
+    }
+}
+
+void GeneticRouteSolver::evaluateIsland(Island& island)
+{
+    for (int row = 0; row < populationSize; ++row) {
+        island.fitness[row] = routeCost(&island.genes[static_cast<size_t>(row) * genomeLength]);
+    }
+
+    // Rank by fitness (lower is better)
+    const std::vector<double>& fitness = island.fitness;
+    std::iota(island.ranking.begin(), island.ranking.end(), 0);
+    std::sort(island.ranking.begin(), island.ranking.end(),
+              [&fitness](int a, int b) {
+                  return fitness[a] < fitness[b];
+              });
+}
+
+void GeneticRouteSolver::migrateElites()
+{
+    const int islandCount = static_cast<int>(islands.size());
+    if (islandCount < 2 || migrantCount <= 0) {
+        return;
+    }
+
+    // Ring topology: island i sends copies of its best individuals to
+    // island i + 1, replacing that island's worst
+    for (int i = 0; i < islandCount; ++i) {
+        const Island& source = islands[i];
+        for (int j = 0; j < migrantCount; ++j) {
+            const size_t slot = static_cast<size_t>(i) * migrantCount + j;
+            const int* genome = &source.genes[static_cast<size_t>(source.ranking[j]) * genomeLength];
+            std::copy(genome, genome + genomeLength, &migrants[slot * genomeLength]);
+            migrantFitness[slot] = source.fitness[source.ranking[j]];
+        }
+    }
+
+    for (int i = 0; i < islandCount; ++i) {
+        Island& target = islands[(i + 1) % islandCount];
+        for (int j = 0; j < migrantCount; ++j) {
+            const size_t slot = static_cast<size_t>(i) * migrantCount + j;
+            const int row = target.ranking[populationSize - 1 - j];
+            std::copy(&migrants[slot * genomeLength], &migrants[(slot + 1) * genomeLength],
+                      &target.genes[static_cast<size_t>(row) * genomeLength]);
+            target.fitness[row] = migrantFitness[slot];
+        }
+
+        const std::vector<double>& fitness = target.fitness;
+        std::sort(target.ranking.begin(), target.ranking.end(),
+                  [&fitness](int a, int b) {
+                      return fitness[a] < fitness[b];
+                  });
+    }
+}
+
+bool GeneticRouteSolver::updateBest()
+{
+    bool improvedBest = false;
+
+    for (const Island& island : islands) {
+        const int row = island.ranking[0];
+        if (island.fitness[row] < bestFitness) {
+            bestFitness = island.fitness[row];
+            const int* genome = &island.genes[static_cast<size_t>(row) * genomeLength];
+            std::copy(genome, genome + genomeLength, bestOrder.begin());
+            improvedBest = true;
+        }
+    }
+
+    return improvedBest;
+}
+
+double GeneticRouteSolver::routeCost(const int* genome) const
+{
+    const int stride = genomeLength + 1;
+
+    // Start is the last row of the matrix
+    double totalDistance = costMatrix[genomeLength * stride + genome[0]];
+    for (int i = 0; i + 1 < genomeLength; ++i) {
+        totalDistance += costMatrix[genome[i] * stride + genome[i + 1]];
+    }
+
+    return totalDistance;
+}
+
+int GeneticRouteSolver::tournament(Island& island)
+{
+    // Tournament selection over row indices
+    const int tournamentSize = 3;
+    int best = island.rng() % populationSize;
+
+    for (int j = 1; j < tournamentSize; ++j) {
+        int candidate = island.rng() % populationSize;
+        if (island.fitness[candidate] < island.fitness[best]) {
+            best = candidate;
+        }
+    }
+
+    return best;
+}
+
+void GeneticRouteSolver::crossover(Island& island, const int* parent1, const int* parent2, int* offspring)
+{
+    // Need at least two targets to pick a crossover segment
+    if (genomeLength < 2) {
+        std::copy(parent1, parent1 + genomeLength, offspring);
+        return;
+    }
+
+    // Order crossover (OX)
+    int start = island.rng() % genomeLength;
+    int end = start + island.rng() % (genomeLength - start);
+
+    std::fill(island.used.begin(), island.used.end(), 0);
+
+    // Copy segment from parent1
+    int length = 0;
+    for (int i = start; i <= end; ++i) {
+        const int gene = parent1[i];
+        offspring[length++] = gene;
+        island.used[gene >> 6] |= std::uint64_t(1) << (gene & 63);
+    }
+
+    // Fill remaining from parent2
+    for (int i = 0; i < genomeLength; ++i) {
+        const int gene = parent2[i];
+        if (!(island.used[gene >> 6] & (std::uint64_t(1) << (gene & 63)))) {
+            offspring[length++] = gene;
+        }
+    }
+}
+
+void GeneticRouteSolver::mutate(Island& island, int* genome)
+{
+    if (genomeLength < 2) return;
+
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(island.rng) < settings.mutationRate) {
+        // Swap two random positions
+        int pos1 = island.rng() % genomeLength;
+        int pos2 = island.rng() % genomeLength;
+
+        std::swap(genome[pos1], genome[pos2]);
+    }
+}
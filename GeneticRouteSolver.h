@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+#include "PlannerControl.h"
+
+// Tuning for the island-model genetic algorithm in findOptimalCollectionRoute.
+// Every island evolves populationSize individuals for the full number of
+// generations, so more islands means a proportionally bigger search.
+struct GeneticSettings {
+    int islandCount = 1;
+    int populationSize = 100;
+    int generations = 500;
+    int migrationInterval = 25; // Generations between elite exchanges
+    int migrantCount = 2;
+    double mutationRate = 0.1;
+    double elitePercentage = 0.2;
+};
+
+// Island-model GA for the open-path TSP behind findOptimalCollectionRoute.
+// It works on a dense cost matrix over the targets only, so a genome is a
+// permutation of 0..targetCount-1 and the start is implicit.
+//
+// Every island keeps its population in two flat arrays of populationSize
+// rows (current and next generation) that are swapped after each
+// generation, and ranks individuals by index. All buffers are sized in
+// solve() before the first generation, so the generation loop itself never
+// touches the heap.
+class GeneticRouteSolver
+{
+public:
+    // Called with the target order whenever the best route improves
+    using ImprovedCallback = std::function<void(const std::vector<int>& order, double cost)>;
+
+    explicit GeneticRouteSolver(const GeneticSettings& settings);
+
+    // costs is (targetCount + 1)^2, row-major, with the start as the last
+    // row. Returns the best target order found, or an empty vector when
+    // cancelled.
+    std::vector<int> solve(const std::vector<double>& costs,
+                           int targetCount,
+                           unsigned int seed,
+                           const PlannerControl& control = PlannerControl(),
+                           const ImprovedCallback& improved = ImprovedCallback());
+
+    double bestCost() const { return bestFitness; }
+
+private:
+    struct Island {
+        std::vector<int> genes;           // populationSize rows of genomeLength
+        std::vector<int> nextGenes;       // Next generation, swapped with genes
+        std::vector<double> fitness;      // Per row of genes
+        std::vector<int> ranking;         // Row indices, best first
+        std::vector<std::uint64_t> used;  // OX bookkeeping, one bit per target
+        std::mt19937 rng;
+    };
+
+    GeneticSettings settings;
+    const double* costMatrix;
+    int genomeLength;
+    int populationSize;
+    int eliteCount;
+    int migrantCount;
+    double bestFitness;
+
+    std::vector<Island> islands;
+    std::vector<int> migrants; // Outgoing elites, migrantCount rows per island
+    std::vector<double> migrantFitness;
+    std::vector<int> bestOrder;
+
+    void initializeIsland(Island& island, unsigned int seed, int index);
+    void evolveIsland(Island& island, int generations, const PlannerControl& control);
+    void evaluateIsland(Island& island);
+    void migrateElites();
+    bool updateBest();
+
+    double routeCost(const int* genome) const;
+    int tournament(Island& island);
+    void crossover(Island& island, const int* parent1, const int* parent2, int* offspring);
+    void mutate(Island& island, int* genome);
+};
@@ -0,0 +1,207 @@
+#include "IncrementalPlanner.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const double infinity = std::numeric_limits<double>::infinity();
+}
+
+void IncrementalPlanner::reset(const NavGraph& navGraph, int goal)
+{
+    graph = &navGraph;
+    goalNode = goal;
+    expansions = 0;
+
+    const int nodeCount = graph->nodeCount();
+    const int edgeCount = graph->edgeCount();
+
+    costs = graph->edgeCosts;
+
+    // Reverse adjacency, so a changed node can update its predecessors
+    edgeSources.resize(edgeCount);
+    reverseOffsets.assign(nodeCount + 1, 0);
+    for (int node = 0; node < nodeCount; ++node) {
+        for (int e = graph->edgeBegin(node); e < graph->edgeEnd(node); ++e) {
+            edgeSources[e] = node;
+            reverseOffsets[graph->edgeTargets[e] + 1]++;
+        }
+    }
+    for (int node = 0; node < nodeCount; ++node) {
+        reverseOffsets[node + 1] += reverseOffsets[node];
+    }
+
+    reverseEdges.resize(edgeCount);
+    std::vector<int> cursor(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (int e = 0; e < edgeCount; ++e) {
+        reverseEdges[cursor[graph->edgeTargets[e]]++] = e;
+    }
+
+    restartSearch();
+}
+
+void IncrementalPlanner::restartSearch()
+{
+    heuristicScale = infinity;
+    for (int e = 0; e < graph->edgeCount(); ++e) {
+        const double length = edgeLength(e);
+        if (length > 0.0 && costs[e] < infinity) {
+            heuristicScale = std::min(heuristicScale, costs[e] / length);
+        }
+    }
+    if (heuristicScale == infinity) {
+        heuristicScale = 0.0;
+    }
+
+    lastStart = -1;
+    keyModifier = 0.0;
+    g.assign(graph->nodeCount(), infinity);
+    rhs.assign(graph->nodeCount(), infinity);
+    openSet = decltype(openSet)();
+
+    rhs[goalNode] = 0.0;
+    openSet.emplace(Key{0.0, 0.0}, goalNode);
+}
+
+double IncrementalPlanner::edgeLength(int edge) const
+{
+    const int source = edgeSources[edge];
+    const int target = graph->edgeTargets[edge];
+    return std::hypot(graph->x[source] - graph->x[target], graph->y[source] - graph->y[target]);
+}
+
+double IncrementalPlanner::heuristic(int a, int b) const
+{
+    return heuristicScale * std::hypot(graph->x[a] - graph->x[b], graph->y[a] - graph->y[b]);
+}
+
+void IncrementalPlanner::setEdgeCost(int edge, double cost)
+{
+    if (costs[edge] == cost) {
+        return;
+    }
+
+    costs[edge] = cost;
+    if (cost < heuristicScale * edgeLength(edge)) {
+        // The heuristic would overestimate across this edge
+        restartSearch();
+        return;
+    }
+    updateVertex(edgeSources[edge]);
+}
+
+void IncrementalPlanner::removeNode(int node)
+{
+    for (int e = graph->edgeBegin(node); e < graph->edgeEnd(node); ++e) {
+        setEdgeCost(e, infinity);
+    }
+    for (int i = reverseOffsets[node]; i < reverseOffsets[node + 1]; ++i) {
+        setEdgeCost(reverseEdges[i], infinity);
+    }
+}
+
+std::vector<int> IncrementalPlanner::replan(int startNode)
+{
+    expansions = 0;
+
+    // Moving the start lowers every queued key by at most the distance
+    // moved; adding it to the modifier keeps the old keys valid bounds
+    if (lastStart >= 0 && lastStart != startNode) {
+        keyModifier += heuristic(lastStart, startNode);
+    }
+    lastStart = startNode;
+
+    computeShortestPath(startNode);
+
+    if (g[startNode] == infinity) {
+        return std::vector<int>();
+    }
+
+    // Follow the cheapest successor down to the goal
+    std::vector<int> path;
+    path.push_back(startNode);
+
+    int current = startNode;
+    while (current != goalNode) {
+        int next = -1;
+        double bestCost = infinity;
+        for (int e = graph->edgeBegin(current); e < graph->edgeEnd(current); ++e) {
+            double cost = costs[e] + g[graph->edgeTargets[e]];
+            if (cost < bestCost) {
+                bestCost = cost;
+                next = graph->edgeTargets[e];
+            }
+        }
+
+        if (next < 0 || static_cast<int>(path.size()) > graph->nodeCount()) {
+            return std::vector<int>();
+        }
+
+        path.push_back(next);
+        current = next;
+    }
+
+    return path;
+}
+
+IncrementalPlanner::Key IncrementalPlanner::calculateKey(int node) const
+{
+    double best = std::min(g[node], rhs[node]);
+    double estimate = lastStart >= 0 ? heuristic(lastStart, node) : 0.0;
+    return Key{best + estimate + keyModifier, best};
+}
+
+void IncrementalPlanner::updateVertex(int node)
+{
+    if (node != goalNode) {
+        double best = infinity;
+        for (int e = graph->edgeBegin(node); e < graph->edgeEnd(node); ++e) {
+            best = std::min(best, costs[e] + g[graph->edgeTargets[e]]);
+        }
+        rhs[node] = best;
+    }
+
+    if (g[node] != rhs[node]) {
+        openSet.emplace(calculateKey(node), node);
+    }
+}
+
+void IncrementalPlanner::computeShortestPath(int startNode)
+{
+    while (!openSet.empty()) {
+        const OpenEntry top = openSet.top();
+        const int node = top.second;
+
+        // Consistent nodes are left over from earlier pushes
+        if (g[node] == rhs[node]) {
+            openSet.pop();
+            continue;
+        }
+
+        if (!(top.first < calculateKey(startNode)) && rhs[startNode] == g[startNode]) {
+            break;
+        }
+
+        openSet.pop();
+
+        Key current = calculateKey(node);
+        if (top.first < current) {
+            // Queued before the start moved
+            openSet.emplace(current, node);
+            continue;
+        }
+
+        ++expansions;
+
+        if (g[node] > rhs[node]) {
+            g[node] = rhs[node];
+        } else {
+            g[node] = infinity;
+            updateVertex(node);
+        }
+
+        for (int i = reverseOffsets[node]; i < reverseOffsets[node + 1]; ++i) {
+            updateVertex(edgeSources[reverseEdges[i]]);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <queue>
+#include <utility>
+#include <vector>
+#include "NavGraph.h"
+
+// D* Lite shortest-path search towards a fixed goal. The search runs
+// backwards from the goal, so the start may move and edge costs may change
+// between calls to replan(): only the part of the search tree the change
+// affects is expanded again.
+//
+// The planner keeps its own copy of the edge costs; the graph passed to
+// reset() must stay alive and must not change its topology while in use.
+//
+// The keys need a consistent heuristic, which NavGraph::heuristic() is not
+// once elevation counts: the planner uses the flat distance scaled down to
+// the cheapest cost per unit of length of any edge. An edit that makes an
+// edge cheaper than that starts the search over.
+class IncrementalPlanner
+{
+public:
+    void reset(const NavGraph& graph, int goalNode);
+    bool isValid() const { return graph != nullptr; }
+    int goal() const { return goalNode; }
+
+    // Edge index as in the graph's CSR arrays
+    void setEdgeCost(int edge, double cost);
+    // Makes every edge into and out of node impassable
+    void removeNode(int node);
+
+    // Shortest path from startNode to the goal, empty if there is none
+    std::vector<int> replan(int startNode);
+
+    // Nodes expanded by the last replan(), for profiling
+    int lastExpansions() const { return expansions; }
+
+private:
+    struct Key {
+        double primary;
+        double secondary;
+
+        bool operator<(const Key& other) const
+        {
+            return primary < other.primary || (primary == other.primary && secondary < other.secondary);
+        }
+    };
+
+    using OpenEntry = std::pair<Key, int>;
+
+    struct OpenOrder {
+        bool operator()(const OpenEntry& a, const OpenEntry& b) const { return b.first < a.first; }
+    };
+
+    const NavGraph* graph = nullptr;
+    int goalNode = -1;
+    int lastStart = -1;
+    double keyModifier = 0.0;
+    double heuristicScale = 0.0;        // Lowest cost per unit of flat length
+    int expansions = 0;
+
+    std::vector<double> costs;          // Current cost of every edge
+    std::vector<int> edgeSources;
+    std::vector<int> reverseOffsets;    // Incoming edges per node
+    std::vector<int> reverseEdges;
+    std::vector<double> g;
+    std::vector<double> rhs;
+
+    // Entries are never removed early: stale ones are skipped when popped
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenOrder> openSet;
+
+    double edgeLength(int edge) const;
+    double heuristic(int a, int b) const;
+    void restartSearch();
+    Key calculateKey(int node) const;
+    void updateVertex(int node);
+    void computeShortestPath(int startNode);
+};
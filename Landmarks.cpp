@@ -0,0 +1,170 @@
+#include "Landmarks.h"
+#include "SearchScratch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Costs from source to every node, or from every node to source when
+// running backwards over the incoming edges
+void shortestCosts(const NavGraph& graph, const ReverseIndex& incoming, int source, bool backwards,
+                   IndexedHeap& open, std::vector<double>& dist)
+{
+    dist.assign(graph.nodeCount(), std::numeric_limits<double>::infinity());
+    open.reset(graph.nodeCount());
+
+    dist[source] = 0.0;
+    open.pushOrDecrease(source, 0.0);
+    while (!open.isEmpty()) {
+        const int node = open.pop();
+        const double d = dist[node];
+
+        const int begin = backwards ? incoming.offsets[node] : graph.edgeBegin(node);
+        const int end = backwards ? incoming.offsets[node + 1] : graph.edgeEnd(node);
+        for (int i = begin; i < end; ++i) {
+            const int e = backwards ? incoming.edges[i] : i;
+            const int next = backwards ? incoming.sources[i] : graph.edgeTargets[e];
+            const double candidate = d + graph.edgeCosts[e];
+            if (candidate < dist[next]) {
+                dist[next] = candidate;
+                open.pushOrDecrease(next, candidate);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void Landmarks::build(const NavGraph& graph, int landmarkCount)
+{
+    const int nodeCount = graph.nodeCount();
+    const int k = std::min(landmarkCount, nodeCount);
+    nodes.clear();
+    from.assign(static_cast<size_t>(nodeCount) * std::max(0, k), 0.0);
+    to.assign(from.size(), 0.0);
+    incoming.build(graph);
+    if (k <= 0) {
+        return;
+    }
+
+    IndexedHeap open;
+    std::vector<double> dist;
+
+    // Bounds are tight for routes heading away from a landmark, so the
+    // landmarks go round the rim of the arena: around the node nearest the
+    // middle, one per angular sector, each the one costliest to reach
+    double middleX = 0.0;
+    double middleY = 0.0;
+    for (int node = 0; node < nodeCount; ++node) {
+        middleX += graph.x[node] / nodeCount;
+        middleY += graph.y[node] / nodeCount;
+    }
+    int middle = 0;
+    for (int node = 1; node < nodeCount; ++node) {
+        if (std::hypot(graph.x[node] - middleX, graph.y[node] - middleY)
+            < std::hypot(graph.x[middle] - middleX, graph.y[middle] - middleY)) {
+            middle = node;
+        }
+    }
+
+    std::vector<double> fromMiddle;
+    shortestCosts(graph, incoming, middle, false, open, fromMiddle);
+
+    constexpr double pi = 3.14159265358979323846;
+    std::vector<int> sectorBest(k, -1);
+    for (int node = 0; node < nodeCount; ++node) {
+        if (!std::isfinite(fromMiddle[node])) {
+            continue;
+        }
+        const double angle = std::atan2(graph.y[node] - graph.y[middle], graph.x[node] - graph.x[middle]);
+        const int sector = std::min(k - 1, static_cast<int>((angle + pi) / (2 * pi) * k));
+        if (sectorBest[sector] < 0 || fromMiddle[node] > fromMiddle[sectorBest[sector]]) {
+            sectorBest[sector] = node;
+        }
+    }
+    for (int node : sectorBest) {
+        if (node >= 0) {
+            nodes.push_back(node);
+        }
+    }
+
+    // Sectors left empty (small or lopsided graphs) fall back to the
+    // nodes farthest from the landmarks picked so far
+    std::vector<double> closest(fromMiddle);
+    std::vector<char> picked(nodeCount, 0);
+    for (int column = 0; column < k; ++column) {
+        if (column == static_cast<int>(nodes.size())) {
+            int landmark = -1;
+            for (int node = 0; node < nodeCount; ++node) {
+                if (!picked[node] && (landmark < 0 || closest[node] > closest[landmark])) {
+                    landmark = node;
+                }
+            }
+            nodes.push_back(landmark);
+        }
+        const int landmark = nodes[column];
+        picked[landmark] = 1;
+
+        shortestCosts(graph, incoming, landmark, false, open, dist);
+        for (int node = 0; node < nodeCount; ++node) {
+            from[static_cast<size_t>(node) * k + column] = dist[node];
+            closest[node] = std::min(closest[node], dist[node]);
+        }
+
+        shortestCosts(graph, incoming, landmark, true, open, dist);
+        for (int node = 0; node < nodeCount; ++node) {
+            to[static_cast<size_t>(node) * k + column] = dist[node];
+        }
+    }
+}
+
+bool Landmarks::restore(const NavGraph& graph, const std::vector<int>& landmarkNodes,
+                        const double* fromLandmarks, const double* toLandmarks)
+{
+    const int nodeCount = graph.nodeCount();
+    for (int node : landmarkNodes) {
+        if (node < 0 || node >= nodeCount) {
+            return false;
+        }
+    }
+
+    // A table that overestimates anywhere would make the landmark searches
+    // return longer paths without any sign of it, so the stored costs must
+    // be consistent with every edge: from a landmark no node is cheaper to
+    // reach than through any of its predecessors, and vice versa. Costs
+    // that only underestimate, like after run-time blocking, still pass.
+    const int k = static_cast<int>(landmarkNodes.size());
+    for (int column = 0; column < k; ++column) {
+        const size_t at = static_cast<size_t>(landmarkNodes[column]) * k + column;
+        if (fromLandmarks[at] != 0.0 || toLandmarks[at] != 0.0) {
+            return false;
+        }
+    }
+    const size_t size = static_cast<size_t>(nodeCount) * k;
+    for (size_t i = 0; i < size; ++i) {
+        if (!(fromLandmarks[i] >= 0.0) || !(toLandmarks[i] >= 0.0)) {
+            return false;
+        }
+    }
+    for (int node = 0; node < nodeCount; ++node) {
+        const double* fromNode = fromLandmarks + static_cast<size_t>(node) * k;
+        const double* toNode = toLandmarks + static_cast<size_t>(node) * k;
+        for (int e = graph.edgeBegin(node); e < graph.edgeEnd(node); ++e) {
+            const double cost = graph.edgeCosts[e];
+            const double* fromNext = fromLandmarks + static_cast<size_t>(graph.edgeTargets[e]) * k;
+            const double* toNext = toLandmarks + static_cast<size_t>(graph.edgeTargets[e]) * k;
+            for (int column = 0; column < k; ++column) {
+                if (fromNext[column] > fromNode[column] + cost || toNode[column] > cost + toNext[column]) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    nodes = landmarkNodes;
+    from.assign(fromLandmarks, fromLandmarks + size);
+    to.assign(toLandmarks, toLandmarks + size);
+    incoming.build(graph);
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include "NavGraph.h"
+
+// Landmark distances for ALT search (A*, landmarks, triangle inequality).
+// For a few landmark nodes L spread over the arena, the shortest path cost
+// from L to every node and from every node to L gives, for any two nodes,
+//
+//   cost(v, t) >= cost(L, t) - cost(L, v)   and   cost(v, t) >= cost(v, L) - cost(t, L)
+//
+// The largest of these bounds follows the real edge costs, hills included,
+// so it is much tighter than the straight-line heuristic and still never
+// overestimates; A* on it returns shortest paths. It stays a lower bound
+// when edge costs go up, so run-time blocking keeps the table valid.
+//
+// Memory is 2 * count() * nodeCount() doubles, stored per node so one
+// bound reads two short runs of memory.
+class Landmarks
+{
+public:
+    bool isEmpty() const { return nodes.empty(); }
+    int count() const { return static_cast<int>(nodes.size()); }
+    const std::vector<int>& landmarkNodes() const { return nodes; }
+
+    // Picks up to landmarkCount landmarks spread round the rim of the arena
+    // and computes their distances with one forward and one backward
+    // Dijkstra each.
+    void build(const NavGraph& graph, int landmarkCount);
+
+    // Takes landmark distances stored with an arena (see ArenaFile) instead
+    // of computing them. False if they do not fit the graph or could
+    // overestimate on any of its edges.
+    bool restore(const NavGraph& graph, const std::vector<int>& landmarkNodes,
+                 const double* fromLandmarks, const double* toLandmarks);
+    // nodeCount() * count() costs, row = node, column = landmark
+    const std::vector<double>& costsFromLandmarks() const { return from; }
+    const std::vector<double>& costsToLandmarks() const { return to; }
+
+    // Lower bound on the cost from node to target; infinity if the table
+    // proves target unreachable from node
+    double lowerBound(int node, int target) const
+    {
+        const int k = count();
+        const double* fromNode = from.data() + static_cast<size_t>(node) * k;
+        const double* fromTarget = from.data() + static_cast<size_t>(target) * k;
+        const double* toNode = to.data() + static_cast<size_t>(node) * k;
+        const double* toTarget = to.data() + static_cast<size_t>(target) * k;
+
+        // Unreachable pairs give infinity (a real bound) or NaN (no
+        // information), which the comparisons skip
+        double bound = 0.0;
+        for (int i = 0; i < k; ++i) {
+            const double viaFrom = fromTarget[i] - fromNode[i];
+            const double viaTo = toNode[i] - toTarget[i];
+            if (viaFrom > bound) {
+                bound = viaFrom;
+            }
+            if (viaTo > bound) {
+                bound = viaTo;
+            }
+        }
+        return bound;
+    }
+
+    // Incoming edges, for searches that run backwards from the target
+    const ReverseIndex& incomingEdges() const { return incoming; }
+
+private:
+    std::vector<int> nodes;
+    std::vector<double> from;   // cost(landmark, node)
+    std::vector<double> to;     // cost(node, landmark)
+    ReverseIndex incoming;
+};
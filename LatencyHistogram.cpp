@@ -0,0 +1,84 @@
+#include "LatencyHistogram.h"
+#include <QtAlgorithms>
+#include <cmath>
+
+int LatencyHistogram::bucketOf(qint64 value)
+{
+    if (value < 2 * SubBuckets) {
+        return value < 0 ? 0 : int(value);
+    }
+
+    // The top SubBucketBits + 1 bits select the bucket
+    const int msb = 63 - int(qCountLeadingZeroBits(quint64(value)));
+    const int octave = msb - SubBucketBits - 1;
+    if (octave >= Octaves) {
+        return BucketCount - 1;
+    }
+    const int shift = msb - SubBucketBits;
+    return 2 * SubBuckets + octave * SubBuckets + int((value >> shift) - SubBuckets);
+}
+
+qint64 LatencyHistogram::highestValueIn(int bucket)
+{
+    if (bucket < 2 * SubBuckets) {
+        return bucket;
+    }
+
+    const int octave = (bucket - 2 * SubBuckets) / SubBuckets;
+    const qint64 sub = (bucket - 2 * SubBuckets) % SubBuckets + SubBuckets;
+    const int shift = octave + 1;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 microseconds)
+{
+    buckets[bucketOf(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+    qint64 seen = maxValue.load(std::memory_order_relaxed);
+    while (microseconds > seen
+           && !maxValue.compare_exchange_weak(seen, microseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    const quint64 n = count();
+    return n > 0 ? double(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const
+{
+    // Bucket counts are read one by one while others may be recording, so
+    // rank against their own total rather than the separate counter
+    std::array<quint64, BucketCount> snapshot;
+    quint64 n = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        n += snapshot[i];
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(percent / 100.0 * n)));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += snapshot[i];
+        if (seen >= rank) {
+            return qMin(highestValueIn(i), max());
+        }
+    }
+    return max();
+}
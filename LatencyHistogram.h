@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+
+// Log-linear latency histogram in the style of HdrHistogram.
+// Values up to 63 us get a bucket each, above that every power of two is
+// split into 32 buckets, so any recorded value is known to within about 3%
+// up to several hours. record() is a handful of relaxed atomic operations
+// and safe from any thread while another thread reads.
+class LatencyHistogram
+{
+public:
+    void record(qint64 microseconds);
+    void reset();
+
+    quint64 count() const { return total.load(std::memory_order_relaxed); }
+    qint64 max() const { return maxValue.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Highest value equivalent to the bucket holding the given percentile
+    qint64 percentile(double percent) const;
+
+private:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBuckets = 1 << SubBucketBits;   // Per power of two
+    static constexpr int Octaves = 30;
+    static constexpr int BucketCount = 2 * SubBuckets + Octaves * SubBuckets;
+
+    static int bucketOf(qint64 value);
+    static qint64 highestValueIn(int bucket);
+
+    std::array<std::atomic<quint64>, BucketCount> buckets{};
+    std::atomic<quint64> total{0};
+    std::atomic<qint64> sum{0};
+    std::atomic<qint64> maxValue{0};
+};
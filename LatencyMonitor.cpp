@@ -0,0 +1,166 @@
+#include "LatencyMonitor.h"
+#include "ControlFrame.h"
+#include "Logging.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <chrono>
+
+namespace {
+
+const char* const stageNames[] = { "input", "queue", "reply", "total" };
+
+double toMs(qint64 microseconds)
+{
+    return microseconds / 1000.0;
+}
+
+}
+
+LatencyMonitor::LatencyMonitor(QObject *parent)
+    : QObject(parent)
+    , m_summarisedCount(0)
+    , m_refreshTimer(new QTimer(this))
+{
+    m_refreshTimer->setInterval(1000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &LatencyMonitor::refresh);
+    m_refreshTimer->start();
+}
+
+qint64 LatencyMonitor::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyMonitor::recordParse(qint64 nanoseconds)
+{
+    m_histograms[0].record(nanoseconds / 1000);
+}
+
+void LatencyMonitor::record(int endpoint, Stage stage, qint64 nanoseconds)
+{
+    if (endpoint >= 0 && endpoint < EndpointCount) {
+        m_histograms[1 + endpoint * StageCount + stage].record(nanoseconds / 1000);
+    }
+}
+
+std::vector<LatencyMonitor::Series> LatencyMonitor::series() const
+{
+    std::vector<Series> result;
+    result.push_back({QStringLiteral("serial"), QStringLiteral("parse"), &m_histograms[0]});
+    for (int endpoint = 0; endpoint < EndpointCount; ++endpoint) {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            result.push_back({ControlFrame::endpointPath(quint8(endpoint)), QString::fromLatin1(stageNames[stage]),
+                              &m_histograms[1 + endpoint * StageCount + stage]});
+        }
+    }
+    return result;
+}
+
+void LatencyMonitor::refresh()
+{
+    quint64 recorded = 0;
+    for (const LatencyHistogram& histogram : m_histograms) {
+        recorded += histogram.count();
+    }
+    if (recorded == m_summarisedCount) {
+        return;
+    }
+    m_summarisedCount = recorded;
+
+    m_summary.clear();
+    for (const Series& each : series()) {
+        if (each.histogram->count() == 0) {
+            continue;
+        }
+
+        QVariantMap row;
+        row["endpoint"] = each.endpoint;
+        row["stage"] = each.stage;
+        row["count"] = each.histogram->count();
+        row["p50"] = toMs(each.histogram->percentile(50.0));
+        row["p99"] = toMs(each.histogram->percentile(99.0));
+        row["max"] = toMs(each.histogram->max());
+        row["mean"] = each.histogram->mean() / 1000.0;
+        m_summary.append(row);
+    }
+    emit summaryChanged();
+}
+
+void LatencyMonitor::reset()
+{
+    for (LatencyHistogram& histogram : m_histograms) {
+        histogram.reset();
+    }
+    m_summarisedCount = 0;
+    m_summary.clear();
+    emit summaryChanged();
+}
+
+QString LatencyMonitor::toCsv() const
+{
+    QString csv = "endpoint,stage,count,p50_ms,p90_ms,p99_ms,p999_ms,max_ms,mean_ms\n";
+    for (const Series& each : series()) {
+        const LatencyHistogram& h = *each.histogram;
+        csv += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+                   .arg(each.endpoint, each.stage)
+                   .arg(h.count())
+                   .arg(toMs(h.percentile(50.0)))
+                   .arg(toMs(h.percentile(90.0)))
+                   .arg(toMs(h.percentile(99.0)))
+                   .arg(toMs(h.percentile(99.9)))
+                   .arg(toMs(h.max()))
+                   .arg(h.mean() / 1000.0);
+    }
+    return csv;
+}
+
+QString LatencyMonitor::toJson() const
+{
+    QJsonArray rows;
+    for (const Series& each : series()) {
+        const LatencyHistogram& h = *each.histogram;
+        QJsonObject row;
+        row["endpoint"] = each.endpoint;
+        row["stage"] = each.stage;
+        row["count"] = qint64(h.count());
+        row["p50"] = toMs(h.percentile(50.0));
+        row["p90"] = toMs(h.percentile(90.0));
+        row["p99"] = toMs(h.percentile(99.0));
+        row["p999"] = toMs(h.percentile(99.9));
+        row["max"] = toMs(h.max());
+        row["mean"] = h.mean() / 1000.0;
+        rows.append(row);
+    }
+
+    QJsonObject report;
+    report["unit"] = "ms";
+    report["series"] = rows;
+    return QString::fromUtf8(QJsonDocument(report).toJson());
+}
+
+QString LatencyMonitor::saveReport(const QString& path) const
+{
+    QString target = path;
+    if (target.isEmpty()) {
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(directory);
+        target = directory + "/latency-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".csv";
+    }
+
+    QFile file(target);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(lcLatency) << "Cannot write latency report" << target << ":" << file.errorString();
+        return QString();
+    }
+
+    const bool json = target.endsWith(".json", Qt::CaseInsensitive);
+    file.write((json ? toJson() : toCsv()).toUtf8());
+    qCInfo(lcLatency) << "Latency report written to" << target;
+    return target;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantList>
+#include <array>
+#include <vector>
+#include "LatencyHistogram.h"
+
+// Latency of the input-to-actuation path, stage by stage.
+//
+//   serial bytes read ─parse─▶ sample ─input─▶ command decided
+//     ─queue─▶ sent ─reply─▶ car replied       (total: read to reply)
+//
+// Parse is per serial sample, the other stages per endpoint. Commands that
+// do not start at the serial port (buttons, the drive page) begin at the
+// decision, so their input stage is zero. Recording is lock-free and may
+// happen on any thread; the properties are refreshed on the owner's
+// thread once a second.
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+
+    // One map per series that has samples: endpoint, stage, count and
+    // p50, p99, max and mean in milliseconds
+    Q_PROPERTY(QVariantList summary READ summary NOTIFY summaryChanged)
+
+public:
+    enum Stage {
+        Input,
+        Queue,
+        Reply,
+        Total,
+        StageCount
+    };
+
+    explicit LatencyMonitor(QObject *parent = nullptr);
+
+    // Monotonic nanoseconds shared by all threads that record
+    static qint64 now();
+
+    void recordParse(qint64 nanoseconds);
+    // endpoint is a ControlFrame::Endpoint
+    void record(int endpoint, Stage stage, qint64 nanoseconds);
+
+    QVariantList summary() const { return m_summary; }
+
+    Q_INVOKABLE void reset();
+    Q_INVOKABLE QString toCsv() const;
+    Q_INVOKABLE QString toJson() const;
+    // Writes JSON for a .json path and CSV otherwise; without a path a
+    // time-stamped CSV goes to the app data directory. Returns the path
+    // written, empty on failure.
+    Q_INVOKABLE QString saveReport(const QString& path = QString()) const;
+
+signals:
+    void summaryChanged();
+
+private:
+    static constexpr int EndpointCount = 3;
+    static constexpr int SeriesCount = 1 + EndpointCount * StageCount;
+
+    struct Series {
+        QString endpoint;
+        QString stage;
+        const LatencyHistogram* histogram;
+    };
+
+    std::array<LatencyHistogram, SeriesCount> m_histograms;
+    QVariantList m_summary;
+    quint64 m_summarisedCount;
+    QTimer* m_refreshTimer;
+
+    std::vector<Series> series() const;
+    void refresh();
+};
@@ -0,0 +1,289 @@
+#include "Logging.h"
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QtEndian>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+Q_LOGGING_CATEGORY(lcPlanner, "rccar.planner")
+Q_LOGGING_CATEGORY(lcCar, "rccar.car")
+Q_LOGGING_CATEGORY(lcCarCommand, "rccar.car.command", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcChannel, "rccar.channel")
+Q_LOGGING_CATEGORY(lcThumbstick, "rccar.thumbstick")
+Q_LOGGING_CATEGORY(lcThumbstickCommand, "rccar.thumbstick.command", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcSerial, "rccar.serial", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcLatency, "rccar.latency")
+
+namespace {
+
+// One slot of the ring, a cache line multiple so producers on different
+// slots do not share lines. Longer messages are cut.
+struct alignas(64) Record {
+    std::atomic<quint64> sequence;
+    qint64 timestamp;
+    quintptr thread;
+    quint16 length;
+    quint8 type;
+    quint8 categoryLength;
+    char category[44];
+    char text[184];
+};
+
+// Bounded multi-producer queue (Vyukov): a producer claims a position with
+// one CAS on head, fills the slot and publishes it through the slot's
+// sequence; the writer thread is the only consumer. Full means dropped, a
+// producer never waits.
+class RecordRing
+{
+public:
+    static constexpr quint64 Capacity = 2048;
+
+    RecordRing()
+        : records(new Record[Capacity])
+    {
+        for (quint64 i = 0; i < Capacity; ++i) {
+            records[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(QtMsgType type, const char* category, const QString& message)
+    {
+        quint64 position = head.load(std::memory_order_relaxed);
+        Record* slot;
+        for (;;) {
+            slot = &records[position & (Capacity - 1)];
+            const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+            const qint64 lag = static_cast<qint64>(sequence - position);
+            if (lag == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch()).count();
+        slot->thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+        slot->type = static_cast<quint8>(type);
+
+        const size_t categoryLength = category ? qMin(strlen(category), sizeof(slot->category)) : 0;
+        memcpy(slot->category, category, categoryLength);
+        slot->categoryLength = static_cast<quint8>(categoryLength);
+
+        const QByteArray text = message.toUtf8();
+        const size_t length = qMin(static_cast<size_t>(text.size()), sizeof(slot->text));
+        memcpy(slot->text, text.constData(), length);
+        slot->length = static_cast<quint16>(length);
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    const Record* front() const
+    {
+        const Record* slot = &records[tail & (Capacity - 1)];
+        return slot->sequence.load(std::memory_order_acquire) == tail + 1 ? slot : nullptr;
+    }
+
+    void pop()
+    {
+        records[tail & (Capacity - 1)].sequence.store(tail + Capacity, std::memory_order_release);
+        ++tail;
+    }
+
+    std::atomic<quint64> dropped{0};
+
+private:
+    std::unique_ptr<Record[]> records;
+    alignas(64) std::atomic<quint64> head{0};
+    alignas(64) quint64 tail = 0;
+};
+
+const char levelLetters[] = "DWCFI";
+
+struct Sink {
+    RecordRing ring;
+    QFile file;
+    Logging::Format format = Logging::Format::Text;
+    qint64 startedAt = 0;
+    quint64 reportedDrops = 0;
+    std::atomic<bool> running{true};
+    QThread* writer = nullptr;
+    QtMessageHandler previousHandler = nullptr;
+
+    void writeRecord(const Record& record, QByteArray& out) const
+    {
+        if (format == Logging::Format::Binary) {
+            char header[12];
+            qToLittleEndian<qint64>(record.timestamp - startedAt, header);
+            header[8] = static_cast<char>(record.type);
+            header[9] = static_cast<char>(record.categoryLength);
+            qToLittleEndian<quint16>(record.length, header + 10);
+            out.append(header, sizeof(header));
+            out.append(record.category, record.categoryLength);
+            out.append(record.text, record.length);
+            return;
+        }
+
+        char prefix[48];
+        const qint64 sinceStart = record.timestamp - startedAt;
+        const int prefixLength = snprintf(prefix, sizeof(prefix), "%lld.%06lld %c ",
+                                          static_cast<long long>(sinceStart / 1000000000),
+                                          static_cast<long long>(sinceStart % 1000000000 / 1000),
+                                          levelLetters[record.type < 5 ? record.type : 0]);
+        out.append(prefix, prefixLength);
+        out.append(record.category, record.categoryLength);
+        const int threadLength = snprintf(prefix, sizeof(prefix), " [%llx] ",
+                                          static_cast<unsigned long long>(record.thread));
+        out.append(prefix, threadLength);
+        out.append(record.text, record.length);
+        out.append('\n');
+    }
+
+    // Writer thread: batch whatever is in the ring into one write
+    void drain()
+    {
+        QByteArray out;
+        while (const Record* record = ring.front()) {
+            writeRecord(*record, out);
+            ring.pop();
+        }
+
+        const quint64 drops = ring.dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops && format == Logging::Format::Text) {
+            out.append(QByteArray::number(drops - reportedDrops) + " log messages dropped\n");
+        }
+        reportedDrops = drops;
+
+        if (!out.isEmpty()) {
+            file.write(out);
+            file.flush();
+        }
+    }
+
+    void run()
+    {
+        while (running.load(std::memory_order_acquire)) {
+            drain();
+            QThread::msleep(10);
+        }
+        drain();
+    }
+};
+
+Sink* sink = nullptr;
+
+QMutex rulesMutex;
+QMap<QString, bool> categoryRules;
+QString baseRules;
+
+void applyRules()
+{
+    QString rules = baseRules;
+    for (auto it = categoryRules.constBegin(); it != categoryRules.constEnd(); ++it) {
+        rules += "\n" + it.key() + (it.value() ? "=true" : "=false");
+    }
+    QLoggingCategory::setFilterRules(rules);
+}
+
+void asyncMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    if (type == QtFatalMsg) {
+        fprintf(stderr, "%s: %s\n", context.category ? context.category : "default", qPrintable(message));
+        fflush(stderr);
+        return;
+    }
+    sink->ring.push(type, context.category, message);
+}
+
+} // namespace
+
+namespace Logging {
+
+void installAsyncSink(const QString& path, Format format)
+{
+    if (sink) {
+        return;
+    }
+
+    auto next = std::make_unique<Sink>();
+    next->startedAt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+    bool opened;
+    if (path.isEmpty()) {
+        next->format = Format::Text;
+        opened = next->file.open(stderr, QIODevice::WriteOnly);
+    } else {
+        next->format = format;
+        next->file.setFileName(path);
+        opened = next->file.open(QIODevice::WriteOnly | QIODevice::Append);
+        if (opened && format == Format::Binary && next->file.size() == 0) {
+            next->file.write("RCLOG1\0\0", 8);
+        }
+    }
+    if (!opened) {
+        qWarning() << "Cannot open log file" << path << "- logging synchronously";
+        return;
+    }
+
+    sink = next.release();
+    sink->writer = QThread::create([] { sink->run(); });
+    sink->writer->setObjectName("LogWriter");
+    sink->writer->start(QThread::LowPriority);
+    sink->previousHandler = qInstallMessageHandler(asyncMessageHandler);
+}
+
+void shutdown()
+{
+    if (!sink || !sink->writer) {
+        return;
+    }
+
+    qInstallMessageHandler(sink->previousHandler);
+    sink->running.store(false, std::memory_order_release);
+    sink->writer->wait();
+    delete sink->writer;
+    sink->writer = nullptr;
+    // The ring itself stays: a thread may still be inside the handler
+}
+
+quint64 droppedCount()
+{
+    return sink ? sink->ring.dropped.load(std::memory_order_relaxed) : 0;
+}
+
+void setRules(const QString& rules)
+{
+    QMutexLocker locker(&rulesMutex);
+    baseRules = rules;
+    categoryRules.clear();
+    applyRules();
+}
+
+void setCategoryEnabled(const QString& category, QtMsgType type, bool enabled)
+{
+    const char* level = "debug";
+    switch (type) {
+    case QtInfoMsg: level = "info"; break;
+    case QtWarningMsg: level = "warning"; break;
+    case QtCriticalMsg: level = "critical"; break;
+    default: break;
+    }
+
+    QMutexLocker locker(&rulesMutex);
+    categoryRules[category + "." + level] = enabled;
+    applyRules();
+}
+
+} // namespace Logging
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QLoggingCategory>
+#include <QString>
+
+// Logging categories and the asynchronous log sink.
+//
+// Everything logs through qCDebug/qCInfo/qCWarning with one of the
+// categories below. A disabled category costs one call and one atomic load
+// before the message is built, so hot paths log at debug level in
+// categories that are off by default (the *.command and serial ones) and
+// can be switched on at runtime:
+//
+//   QT_LOGGING_RULES="rccar.car.command.debug=true" appRC_CAR_QUI
+//   appRC_CAR_QUI --log-rules "rccar.*.debug=true"
+//   Logging::setCategoryEnabled("rccar.serial", QtDebugMsg, true);
+//
+// Levels below RC_LOG_LEVEL (CMake cache variable: debug, info, warning)
+// are compiled out entirely through QT_NO_DEBUG_OUTPUT/QT_NO_INFO_OUTPUT.
+//
+// Once installAsyncSink() is called, the message handler only copies each
+// message into a fixed ring of records; a writer thread formats and writes
+// them, so no console or file I/O happens on the logging thread.
+Q_DECLARE_LOGGING_CATEGORY(lcPlanner)         // rccar.planner: graph loads, route results
+Q_DECLARE_LOGGING_CATEGORY(lcCar)             // rccar.car: drive state changes
+Q_DECLARE_LOGGING_CATEGORY(lcCarCommand)      // rccar.car.command: every command and reply (off)
+Q_DECLARE_LOGGING_CATEGORY(lcChannel)         // rccar.channel: binary control channel
+Q_DECLARE_LOGGING_CATEGORY(lcThumbstick)      // rccar.thumbstick: serial port state
+Q_DECLARE_LOGGING_CATEGORY(lcThumbstickCommand) // rccar.thumbstick.command: requests and replies (off)
+Q_DECLARE_LOGGING_CATEGORY(lcSerial)          // rccar.serial: raw serial frames (off)
+Q_DECLARE_LOGGING_CATEGORY(lcLatency)         // rccar.latency: latency reports
+
+namespace Logging {
+
+enum class Format {
+    Text,   // One line per record: seconds, level, category, thread, message
+    Binary  // Header "RCLOG1\0\0", then per record: qint64 ns, quint8 level,
+            // quint8 category length, quint16 message length, both strings
+            // as UTF-8, all little-endian
+};
+
+// Routes all Qt messages through the ring, once per process. An empty path
+// writes text to stderr. Fatal messages are still written synchronously.
+void installAsyncSink(const QString& path = QString(), Format format = Format::Text);
+
+// Drains the ring, stops the writer and restores the previous handler.
+// Call it after the event loop, later messages are written synchronously.
+void shutdown();
+
+// Messages lost because the ring was full
+quint64 droppedCount();
+
+// Runtime enablement. Rules use the QT_LOGGING_RULES syntax and replace the
+// ones set earlier; setCategoryEnabled adds or changes a single rule.
+// QT_LOGGING_RULES in the environment still takes precedence.
+void setRules(const QString& rules);
+void setCategoryEnabled(const QString& category, QtMsgType type, bool enabled);
+
+} // namespace Logging
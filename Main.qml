@@ -11,8 +11,8 @@ ApplicationWindow{
     height: 800
     color: "#DDDDDD"
 
-    // Global optimal path storage
-    property var globalOptimalPath: []
+    // Global optimal path storage, a RouteModel filled by the engine
+    property var globalOptimalPath: pathfindingEngine.route
 
     // PathfindingEngine instance at application level
     PathfindingEngine {
@@ -147,17 +147,11 @@ ApplicationWindow{
                             id: miniMap
                             anchors.fill: parent
                             anchors.margins: 5
+                            engine: pathfindingEngine
+                            interactive: false
                             showConnections: false // Hide connections in mini-map for cleaner view
                             showOptimalPath: true
                             optimalPath: globalOptimalPath // Bind to global path
-
-                            // Watch for changes in globalOptimalPath and refresh
-                            Connections {
-                                target: application
-                                function onGlobalOptimalPathChanged() {
-                                    miniMap.refresh()
-                                }
-                            }
                         }
 
                         // Mini-map title
@@ -201,6 +195,38 @@ ApplicationWindow{
         Page {
             title: "Map Details"
 
+            // Pending asynchronous route request started by one of the buttons below
+            property int routeJobId: -1
+            property string routeLabel: ""
+            property bool routeAppendsRelease: false
+
+            function requestRoute(label, appendRelease, jobId) {
+                routeLabel = label
+                routeAppendsRelease = appendRelease
+                routeJobId = jobId
+                pathStatusText.text = jobId >= 0 ? "Planning route..." : "No route found"
+            }
+
+            function showRoute() {
+                var optimalRoute = pathfindingEngine.route
+                if (optimalRoute.count > 0) {
+                    // Add release area to the end
+                    if (routeAppendsRelease) {
+                        optimalRoute.appendNode("release")
+                    }
+
+                    var totalPoints = optimalRoute.totalPoints
+
+                    console.log(routeLabel, "route found with", optimalRoute.count, "nodes")
+                    console.log("Total points:", totalPoints)
+                    pathStatusText.text = "Route: " + optimalRoute.count + " nodes, " + totalPoints + " points"
+                                          + (pathfindingEngine.lastRouteProvenOptimal ? " (optimal)" : "")
+                } else {
+                    console.log("No", routeLabel.toLowerCase(), "route found")
+                    pathStatusText.text = "No route found"
+                }
+            }
+
             ColumnLayout {
                 anchors.fill: parent
                 spacing: 10
@@ -255,23 +281,15 @@ ApplicationWindow{
                         anchors.fill: parent
                         anchors.margins: 2
 
+                        engine: pathfindingEngine
                         showConnections: true
                         showOptimalPath: true
                         optimalPath: globalOptimalPath // Bind to global path
-
                         // Initialize pathfinding engine with map data
                         Component.onCompleted: {
                             initializePathfindingEngineLocal()
                         }
 
-                        // Watch for changes in globalOptimalPath and refresh
-                        Connections {
-                            target: application
-                            function onGlobalOptimalPathChanged() {
-                                fullMap.refresh()
-                            }
-                        }
-
                         function initializePathfindingEngineLocal() {
                             var nodeArray = []
                             for (var i = 0; i < fullMap.nodeModel.count; i++) {
@@ -288,28 +306,8 @@ ApplicationWindow{
 
                             pathfindingEngine.setNodes(nodeArray)
 
-                            var connectionMap = {}
-                            var connections = fullMap.nodeConnections
-                            for (var nodeId in connections) {
-                                var nodeConnections = connections[nodeId]
-                                var connectionArray = []
-
-                                for (var j = 0; j < nodeConnections.length; j++) {
-                                    var conn = nodeConnections[j]
-                                    if (conn.targetIndex < fullMap.nodeModel.count) {
-                                        var targetNode = fullMap.nodeModel.get(conn.targetIndex)
-                                        connectionArray.push({
-                                            targetId: targetNode.elementId,
-                                            cost: conn.cost,
-                                            distance: conn.distance,
-                                            targetIndex: conn.targetIndex
-                                        })
-                                    }
-                                }
-                                connectionMap[nodeId] = connectionArray
-                            }
-
-                            pathfindingEngine.setConnections(connectionMap)
+                            // Six nearest neighbours per node, priced by distance and climb
+                            pathfindingEngine.buildGraph(6, "elevation")
                             console.log("Pathfinding engine initialized")
                         }
 
@@ -326,26 +324,8 @@ ApplicationWindow{
                         text: "Optimal Ball Collection\n(8 balls max)"
                         onClicked: {
                             // Find optimal route collecting up to 8 balls and returning to release
-                            var optimalRoute = pathfindingEngine.findOptimalBallCollectionRoute("start_a", "release", 8)
-                            if (optimalRoute.length > 0) {
-                                globalOptimalPath = optimalRoute
-                                fullMap.refresh()
-
-                                // Calculate total points
-                                var totalPoints = 0
-                                for (var i = 0; i < optimalRoute.length; i++) {
-                                    if (optimalRoute[i].points) {
-                                        totalPoints += optimalRoute[i].points
-                                    }
-                                }
-
-                                console.log("Optimal collection route found with", optimalRoute.length, "nodes")
-                                console.log("Total points:", totalPoints)
-                                pathStatusText.text = "Route: " + optimalRoute.length + " nodes, " + totalPoints + " points"
-                            } else {
-                                console.log("No optimal collection route found")
-                                pathStatusText.text = "No route found"
-                            }
+                            requestRoute("Optimal collection", false,
+                                         pathfindingEngine.requestOptimalBallCollectionRoute("start_a", "release", 8))
                         }
                     }
 
@@ -358,31 +338,8 @@ ApplicationWindow{
                                 "comm_tow"    // Communication tower (60 points)
                             ]
 
-                            var optimalRoute = pathfindingEngine.findOptimalCollectionRoute("start_a", highValueNodes)
-                            if (optimalRoute.length > 0) {
-                                // Add release area to the end
-                                var releaseNode = fullMap.getNodeByElementId("release")
-                                if (releaseNode) {
-                                    optimalRoute.push(releaseNode)
-                                }
-
-                                globalOptimalPath = optimalRoute
-                                fullMap.refresh()
-
-                                var totalPoints = 0
-                                for (var i = 0; i < optimalRoute.length; i++) {
-                                    if (optimalRoute[i].points) {
-                                        totalPoints += optimalRoute[i].points
-                                    }
-                                }
-
-                                console.log("High value route found with", optimalRoute.length, "nodes")
-                                console.log("Total points:", totalPoints)
-                                pathStatusText.text = "Route: " + optimalRoute.length + " nodes, " + totalPoints + " points"
-                            } else {
-                                console.log("No high value route found")
-                                pathStatusText.text = "No route found"
-                            }
+                            requestRoute("High value", true,
+                                         pathfindingEngine.requestOptimalCollectionRoute("start_a", highValueNodes))
                         }
                     }
 
@@ -390,56 +347,56 @@ ApplicationWindow{
                         text: "Start B Route\n(Alternative start)"
                         onClicked: {
                             // Find optimal route from start_b
-                            var optimalRoute = pathfindingEngine.findOptimalBallCollectionRoute("start_b", "release", 8)
-                            if (optimalRoute.length > 0) {
-                                globalOptimalPath = optimalRoute
-                                fullMap.refresh()
-
-                                var totalPoints = 0
-                                for (var i = 0; i < optimalRoute.length; i++) {
-                                    if (optimalRoute[i].points) {
-                                        totalPoints += optimalRoute[i].points
-                                    }
-                                }
-
-                                console.log("Start B route found with", optimalRoute.length, "nodes")
-                                console.log("Total points:", totalPoints)
-                                pathStatusText.text = "Route: " + optimalRoute.length + " nodes, " + totalPoints + " points"
-                            } else {
-                                console.log("No route found from start B")
-                                pathStatusText.text = "No route found"
-                            }
+                            requestRoute("Start B", false,
+                                         pathfindingEngine.requestOptimalBallCollectionRoute("start_b", "release", 8))
                         }
                     }
 
                     Button {
                         text: "Clear Path"
                         onClicked: {
-                            globalOptimalPath = []
+                            routeJobId = -1
                             pathfindingEngine.clearPath()
-                            fullMap.refresh()
                             pathStatusText.text = "Path Status: None"
                             console.log("Path cleared")
                         }
                     }
                 }
 
+                // Routes are planned on a worker thread; a new request cancels the previous one
+                Connections {
+                    target: pathfindingEngine
+
+                    function onPlanningProgress(jobId, step, totalSteps, bestScore) {
+                        if (jobId === routeJobId && totalSteps > 0) {
+                            pathStatusText.text = "Planning route... " + Math.round(100 * step / totalSteps) + "%"
+                        }
+                    }
+
+                    function onPlanningFinished(jobId) {
+                        if (jobId === routeJobId) {
+                            routeJobId = -1
+                            showRoute()
+                        }
+                    }
+                }
+
                 // Update the status row to show more detailed information:
                 RowLayout {
                     Layout.alignment: Qt.AlignHCenter
                     spacing: 20
 
                     Text {
-                        text: "Path Length: " + globalOptimalPath.length + " nodes"
+                        text: "Path Length: " + globalOptimalPath.count + " nodes"
                         font.pixelSize: 12
                         color: "#666666"
                     }
 
                     Text {
                         id: pathStatusText
-                        text: globalOptimalPath.length > 0 ? "Path Status: Active" : "Path Status: None"
+                        text: globalOptimalPath.count > 0 ? "Path Status: Active" : "Path Status: None"
                         font.pixelSize: 12
-                        color: globalOptimalPath.length > 0 ? "#2ecc71" : "#e74c3c"
+                        color: globalOptimalPath.count > 0 ? "#2ecc71" : "#e74c3c"
                     }
                 }
             }
@@ -598,6 +555,32 @@ ApplicationWindow{
                                         Layout.preferredWidth: 40
                                     }
                                 }
+
+                                // Binary TCP channel, falls back to HTTP
+                                RowLayout {
+                                    spacing: 10
+
+                                    Switch {
+                                        text: "Low-latency link"
+                                        checked: carController.lowLatency
+                                        onToggled: carController.lowLatency = checked
+                                    }
+
+                                    Text {
+                                        text: carController.transport.toUpperCase() + "  "
+                                              + carController.lastRoundTripMs.toFixed(1) + " ms"
+                                        color: "white"
+                                        font.pixelSize: 14
+                                    }
+                                }
+
+                                Text {
+                                    text: "Sent " + carController.scheduler.sentCount
+                                          + "  coalesced " + carController.scheduler.coalescedCount
+                                          + "  dropped " + carController.scheduler.droppedCount
+                                    color: "#BDC3C7"
+                                    font.pixelSize: 12
+                                }
                             }
                         }
 
@@ -1106,6 +1089,12 @@ ApplicationWindow{
                                         font.pixelSize: 12
                                         font.bold: true
                                     }
+                                    Text {
+                                        text: "Frames: " + thumbstickController.serialFrames
+                                              + " (" + thumbstickController.malformedFrames + " bad)"
+                                        color: thumbstickController.malformedFrames > 0 ? "#F39C12" : "#BDC3C7"
+                                        font.pixelSize: 12
+                                    }
                                 }
                             }
                         }
@@ -1138,6 +1127,105 @@ ApplicationWindow{
                                 }
                             }
                         }
+
+                        // Control latency per stage, in milliseconds
+                        GroupBox {
+                            Layout.fillWidth: true
+                            title: "Latency (ms)"
+
+                            ColumnLayout {
+                                anchors.fill: parent
+                                spacing: 4
+
+                                Repeater {
+                                    model: thumbstickController.latency.summary
+
+                                    Text {
+                                        text: modelData.endpoint + " " + modelData.stage
+                                              + "  n=" + modelData.count
+                                              + "  p50 " + modelData.p50.toFixed(2)
+                                              + "  p99 " + modelData.p99.toFixed(2)
+                                              + "  max " + modelData.max.toFixed(2)
+                                        color: "white"
+                                        font.pixelSize: 10
+                                        font.family: "monospace"
+                                    }
+                                }
+
+                                RowLayout {
+                                    spacing: 10
+
+                                    Button {
+                                        text: "Reset"
+                                        onClicked: thumbstickController.latency.reset()
+                                    }
+
+                                    Button {
+                                        text: "Save Report"
+                                        onClicked: {
+                                            var path = thumbstickController.latency.saveReport()
+                                            debugOutput.addDebugLine(path !== "" ? "Latency report: " + path
+                                                                                 : "Latency report failed")
+                                        }
+                                    }
+                                }
+                            }
+                        }
+
+                        // Record the serial input and commands, replay them without hardware
+                        GroupBox {
+                            Layout.fillWidth: true
+                            title: "Telemetry"
+
+                            ColumnLayout {
+                                anchors.fill: parent
+                                spacing: 4
+
+                                RowLayout {
+                                    spacing: 10
+
+                                    Button {
+                                        text: thumbstickController.recording ? "Stop Recording" : "Record"
+                                        enabled: !thumbstickController.replaying
+                                        onClicked: {
+                                            if (thumbstickController.recording) {
+                                                thumbstickController.stopRecording()
+                                            } else {
+                                                thumbstickController.startRecording()
+                                            }
+                                        }
+                                    }
+
+                                    ComboBox {
+                                        id: replaySpeedCombo
+                                        Layout.preferredWidth: 90
+                                        model: ["1x", "4x", "Max"]
+                                    }
+
+                                    Button {
+                                        text: thumbstickController.replaying ? "Stop Replay" : "Replay"
+                                        enabled: thumbstickController.recordingPath !== "" && !thumbstickController.recording
+                                        onClicked: {
+                                            if (thumbstickController.replaying) {
+                                                thumbstickController.stopReplay()
+                                            } else {
+                                                thumbstickController.startReplay(thumbstickController.recordingPath,
+                                                                                 [1, 4, 0][replaySpeedCombo.currentIndex])
+                                            }
+                                        }
+                                    }
+                                }
+
+                                Text {
+                                    text: thumbstickController.recordingPath
+                                          + (thumbstickController.replaying ? " → " + thumbstickController.replayUrl : "")
+                                    color: "#BDC3C7"
+                                    font.pixelSize: 10
+                                    elide: Text.ElideMiddle
+                                    Layout.fillWidth: true
+                                }
+                            }
+                        }
                     }
 
                     // Connections for handling thumbstick events
@@ -1156,6 +1244,16 @@ ApplicationWindow{
                             debugOutput.addDebugLine("HTTP ERROR " + endpoint + ": " + error)
                         }
 
+                        function onReplayFinished(stats) {
+                            if (stats.error !== undefined) {
+                                debugOutput.addDebugLine("Replay failed: " + stats.error)
+                                return
+                            }
+                            debugOutput.addDebugLine("Replay: " + stats.frames + " frames in " + stats.elapsedMs.toFixed(1)
+                                                     + " ms (" + Math.round(stats.framesPerSecond) + "/s), "
+                                                     + stats.mismatches + " mismatched commands")
+                        }
+
                         function onMotorControlReceived(direction, speed) {
                             console.log("Motor control:", direction, "speed:", speed)
                         }
@@ -0,0 +1,122 @@
+#include "NavGraph.h"
+
+void ReverseIndex::clear()
+{
+    offsets.clear();
+    edges.clear();
+    sources.clear();
+}
+
+void ReverseIndex::build(const NavGraph& graph)
+{
+    const int nodeCount = graph.nodeCount();
+    offsets.assign(nodeCount + 1, 0);
+    for (int e = 0; e < graph.edgeCount(); ++e) {
+        offsets[graph.edgeTargets[e] + 1]++;
+    }
+    for (int i = 0; i < nodeCount; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    edges.resize(graph.edgeCount());
+    sources.resize(graph.edgeCount());
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (int node = 0; node < nodeCount; ++node) {
+        for (int e = graph.edgeBegin(node); e < graph.edgeEnd(node); ++e) {
+            int slot = cursor[graph.edgeTargets[e]]++;
+            edges[slot] = e;
+            sources[slot] = node;
+        }
+    }
+}
+
+void NavGraph::clear()
+{
+    x.clear();
+    y.clear();
+    elevation.clear();
+    points.clear();
+    kind.clear();
+    edgeOffsets.assign(1, 0);
+    edgeTargets.clear();
+    edgeCosts.clear();
+    edgeDistances.clear();
+}
+
+void NavGraph::resizeNodes(int count)
+{
+    x.resize(count, 0.0);
+    y.resize(count, 0.0);
+    elevation.resize(count, 0.0);
+    points.resize(count, 0);
+    kind.resize(count, NodeKind::Other);
+    clearEdges();
+}
+
+void NavGraph::clearEdges()
+{
+    edgeOffsets.assign(nodeCount() + 1, 0);
+    edgeTargets.clear();
+    edgeCosts.clear();
+    edgeDistances.clear();
+}
+
+void NavGraph::setEdges(const std::vector<EdgeInput>& edges)
+{
+    const int count = nodeCount();
+    edgeOffsets.assign(count + 1, 0);
+
+    // Counting pass, then prefix sum into offsets
+    for (const EdgeInput& edge : edges) {
+        edgeOffsets[edge.source + 1]++;
+    }
+    for (int i = 0; i < count; ++i) {
+        edgeOffsets[i + 1] += edgeOffsets[i];
+    }
+
+    edgeTargets.resize(edges.size());
+    edgeCosts.resize(edges.size());
+    edgeDistances.resize(edges.size());
+
+    std::vector<int> cursor(edgeOffsets.begin(), edgeOffsets.end() - 1);
+    for (const EdgeInput& edge : edges) {
+        int slot = cursor[edge.source]++;
+        edgeTargets[slot] = edge.target;
+        edgeCosts[slot] = edge.cost;
+        edgeDistances[slot] = edge.distance;
+    }
+}
+
+std::vector<int> NavGraph::passableLinks() const
+{
+    std::vector<int> links;
+    links.reserve(edgeCount());
+
+    for (int source = 0; source < nodeCount(); ++source) {
+        for (int e = edgeBegin(source); e < edgeEnd(source); ++e) {
+            int target = edgeTargets[e];
+            if (!std::isfinite(edgeCosts[e])) {
+                continue;
+            }
+            if (target < source) {
+                int back = findEdge(target, source);
+                if (back >= 0 && std::isfinite(edgeCosts[back])) {
+                    continue;
+                }
+            }
+            links.push_back(e);
+        }
+    }
+
+    return links;
+}
+
+int NavGraph::findEdge(int source, int target) const
+{
+    for (int e = edgeBegin(source); e < edgeEnd(source); ++e) {
+        if (edgeTargets[e] == target) {
+            return e;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+// Node categories used by the planners. Kept as a byte per node so the
+// collectible/start/release checks never touch the QString type names.
+enum class NodeKind : unsigned char {
+    Other,
+    Keystone,
+    StartA,
+    StartB,
+    Release,
+    GreenBall,
+    BlackStripedBall,
+    StarBall,
+    CommTower
+};
+
+inline bool isCollectibleKind(NodeKind kind)
+{
+    return kind == NodeKind::GreenBall ||
+           kind == NodeKind::BlackStripedBall ||
+           kind == NodeKind::StarBall ||
+           kind == NodeKind::CommTower;
+}
+
+// Dense, integer-indexed navigation graph.
+// Node attributes are stored as parallel arrays (struct-of-arrays) and the
+// outgoing edges of node i live in [edgeOffsets[i], edgeOffsets[i + 1]) of
+// the CSR edge arrays. Node indices are assigned by PathfindingEngine when
+// the QML node list is interned; nothing in here knows about element IDs.
+struct NavGraph {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> elevation;
+    std::vector<int> points;
+    std::vector<NodeKind> kind;
+
+    std::vector<int> edgeOffsets;     // nodeCount() + 1 entries
+    std::vector<int> edgeTargets;
+    std::vector<double> edgeCosts;
+    std::vector<double> edgeDistances;
+
+    int nodeCount() const { return static_cast<int>(x.size()); }
+    int edgeCount() const { return static_cast<int>(edgeTargets.size()); }
+
+    int edgeBegin(int node) const { return edgeOffsets[node]; }
+    int edgeEnd(int node) const { return edgeOffsets[node + 1]; }
+
+    // Euclidean distance with elevation weighted less, as used by A*.
+    double heuristic(int a, int b) const
+    {
+        double dx = x[a] - x[b];
+        double dy = y[a] - y[b];
+        double dz = elevation[a] - elevation[b];
+        return std::sqrt(dx * dx + dy * dy + dz * dz * 0.1);
+    }
+
+    void clear();
+    void resizeNodes(int count);
+
+    // Drops all edges but keeps the node arrays.
+    void clearEdges();
+
+    struct EdgeInput {
+        int source;
+        int target;
+        double cost;
+        double distance;
+    };
+
+    // Rebuilds the CSR arrays from an unordered edge list. Edges keep their
+    // relative order per source node.
+    void setEdges(const std::vector<EdgeInput>& edges);
+
+    // Index of the first edge from source to target, -1 if there is none.
+    int findEdge(int source, int target) const;
+
+    // Edges to draw on a map: passable ones only, and a two-way connection
+    // just once, from its lower-index end.
+    std::vector<int> passableLinks() const;
+};
+
+// Incoming edges of every node in the same CSR layout, for searches that
+// run backwards towards a node. Entries hold forward edge indices, so edge
+// costs changed at run time are picked up without rebuilding.
+struct ReverseIndex {
+    std::vector<int> offsets;   // nodeCount() + 1 entries
+    std::vector<int> edges;     // Forward edge index of each incoming edge
+    std::vector<int> sources;   // Node the edge comes from
+
+    bool isEmpty() const { return offsets.empty(); }
+    void clear();
+    void build(const NavGraph& graph);
+};
@@ -0,0 +1,81 @@
+#include "PathCache.h"
+
+size_t PathCache::KeyHash::operator()(const Key& key) const
+{
+    // 64-bit mix of all fields; start and end alone would collide across
+    // versions of the same query
+    std::uint64_t hash = static_cast<std::uint32_t>(key.startNode);
+    hash = hash * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(key.endNode);
+    hash = hash * 0x9E3779B97F4A7C15ull + key.graphVersion;
+    hash = hash * 0x9E3779B97F4A7C15ull + key.costModelVersion;
+    hash = hash * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(key.search);
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+PathCache::PathCache(size_t capacityBytes)
+    : capacityBytes(capacityBytes)
+{}
+
+void PathCache::setCapacity(size_t bytes)
+{
+    capacityBytes = bytes;
+    evictTo(capacityBytes);
+}
+
+const std::vector<int>* PathCache::find(const Key& key)
+{
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++missCount;
+        return nullptr;
+    }
+
+    ++hitCount;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->path;
+}
+
+void PathCache::insert(const Key& key, std::vector<int> path)
+{
+    // The list node, the index node and the path itself
+    const size_t bytes = sizeof(Entry) + 4 * sizeof(void*) + sizeof(std::pair<Key, void*>)
+                       + path.size() * sizeof(int);
+    if (bytes > capacityBytes) {
+        return;
+    }
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        usedBytes -= it->second->bytes;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    evictTo(capacityBytes - bytes);
+    path.shrink_to_fit();
+    entries.push_front({key, std::move(path), bytes});
+    index.emplace(key, entries.begin());
+    usedBytes += bytes;
+}
+
+void PathCache::clear()
+{
+    entries.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+double PathCache::hitRate() const
+{
+    const long long lookups = hitCount + missCount;
+    return lookups > 0 ? static_cast<double>(hitCount) / lookups : 0.0;
+}
+
+void PathCache::evictTo(size_t bytes)
+{
+    while (usedBytes > bytes && !entries.empty()) {
+        usedBytes -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
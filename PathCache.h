@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Least-recently-used cache of findPath results. Keys carry the version
+// of the graph and of its cost model they were computed on, so a result
+// can never outlive a change to either: after a change old entries just
+// stop matching and age out. Empty paths (no route) are cached too.
+// Bounded by an estimate of the memory held. Not thread-safe.
+class PathCache
+{
+public:
+    struct Key {
+        int startNode;
+        int endNode;
+        std::uint64_t graphVersion;
+        std::uint64_t costModelVersion;
+        int search;     // PathSearch mode; modes may return different paths
+
+        bool operator==(const Key& other) const
+        {
+            return startNode == other.startNode && endNode == other.endNode
+                && graphVersion == other.graphVersion && costModelVersion == other.costModelVersion
+                && search == other.search;
+        }
+    };
+
+    explicit PathCache(size_t capacityBytes);
+
+    // Zero turns the cache off
+    void setCapacity(size_t capacityBytes);
+    size_t capacity() const { return capacityBytes; }
+
+    // Cached path for key, now the most recently used; null on a miss.
+    // Valid until the next insert(), setCapacity() or clear().
+    const std::vector<int>* find(const Key& key);
+    void insert(const Key& key, std::vector<int> path);
+    void clear();
+
+    long long hits() const { return hitCount; }
+    long long misses() const { return missCount; }
+    double hitRate() const;
+    int size() const { return static_cast<int>(entries.size()); }
+    size_t memoryUsage() const { return usedBytes; }
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<int> path;
+        size_t bytes;
+    };
+
+    // Most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    size_t capacityBytes;
+    size_t usedBytes = 0;
+    long long hitCount = 0;
+    long long missCount = 0;
+
+    void evictTo(size_t bytes);
+};
@@ -1,695 +1,943 @@
 #include "PathfindingEngine.h"
-#include <QDebug>
-#include <algorithm>
-#include <cmath>
-#include <unordered_set>
+#include "ArenaFile.h"
+#include "Logging.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include <limits>
 
 PathfindingEngine::PathfindingEngine(QObject *parent)
-    : QObject(parent), rng(std::random_device{}())
-{}
-
-void PathfindingEngine::setNodes(const QVariantList& nodeList)
+    : QObject(parent)
+    , plannerGraph(std::make_shared<PlannerGraph>())
+    , builtNeighbours(0)
+    , builtCostModel(EdgeCostModel::Elevation)
+    , rng(std::random_device{}())
+    , searchScratch(std::make_shared<SearchScratch>())
+    , reverseSearchScratch(std::make_shared<SearchScratch>())
+    , m_randomSeed(0)
+    , m_islandCount(qMax(1, QThread::idealThreadCount()))
+    , m_ballRouteTimeBudget(200)
+    , m_lastRouteProvenOptimal(false)
+    , m_route(new RouteModel(this))
+    , m_bestRoute(new RouteModel(this))
+    , m_watchArenaFile(false)
+    , m_pathSearch(QStringLiteral("astar"))
+    , pathCache(4 * 1024 * 1024)
+    , graphVersion(0)
+    , costModelVersion(0)
+    , arenaWatcher(new QFileSystemWatcher(this))
+    , arenaReloadTimer(new QTimer(this))
+    , threadPool(new QThreadPool(this))
+    , lastJobId(0)
 {
-    nodes.clear();
+    threadPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
 
-    for (const QVariant& nodeVariant : nodeList) {
-        QVariantMap nodeMap = nodeVariant.toMap();
-
-        QString elementId = nodeMap["elementId"].toString();
-        double x = nodeMap["x"].toDouble();
-        double y = nodeMap["y"].toDouble();
-        double elevation = nodeMap["elevation"].toDouble();
-        QString type = nodeMap["type"].toString();
-        int points = nodeMap["points"].toInt();
+    arenaReloadTimer->setSingleShot(true);
+    arenaReloadTimer->setInterval(100);
+    connect(arenaWatcher, &QFileSystemWatcher::fileChanged, arenaReloadTimer, qOverload<>(&QTimer::start));
+    connect(arenaReloadTimer, &QTimer::timeout, this, &PathfindingEngine::reloadArena);
+}
 
-        nodes[elementId] = Node(elementId, x, y, elevation, type, points);
+PathfindingEngine::~PathfindingEngine()
+{
+    // Jobs post their results back to this object, so they must be gone
+    // before it is
+    for (auto& entry : activeJobs) {
+        entry.second->cancelled = true;
     }
-
-    qDebug() << "Loaded" << nodes.size() << "nodes";
+    if (hierarchyBuildCancelled) {
+        *hierarchyBuildCancelled = true;
+    }
+    threadPool->waitForDone();
 }
 
-void PathfindingEngine::setConnections(const QVariantMap& connectionMap)
+void PathfindingEngine::setRandomSeed(int seed)
 {
-    connections.clear();
-
-    for (auto it = connectionMap.begin(); it != connectionMap.end(); ++it) {
-        QString nodeId = it.key();
-        QVariantList connectionList = it.value().toList();
-
-        std::vector<Connection> nodeConnections;
-
-        for (const QVariant& connectionVariant : connectionList) {
-            QVariantMap connMap = connectionVariant.toMap();
-
-            QString targetId = connMap["targetId"].toString();
-            double cost = connMap["cost"].toDouble();
-            double distance = connMap["distance"].toDouble();
-
-            // Find target node ID by index
-            // int targetIndex = connMap["targetIndex"].toInt();
-            // We need to map the index back to element ID
-            // This is a bit tricky since we're working with the original node order
-            // For now, we'll assume the connections are properly set up
+    if (m_randomSeed != seed) {
+        m_randomSeed = seed;
+        emit randomSeedChanged();
+    }
+}
 
-            nodeConnections.emplace_back(targetId, cost, distance);
-        }
+void PathfindingEngine::setIslandCount(int count)
+{
+    count = qMax(1, count);
+    if (m_islandCount != count) {
+        m_islandCount = count;
+        emit islandCountChanged();
+    }
+}
 
-        connections[nodeId] = nodeConnections;
+void PathfindingEngine::setBallRouteTimeBudget(int milliseconds)
+{
+    milliseconds = qMax(1, milliseconds);
+    if (m_ballRouteTimeBudget != milliseconds) {
+        m_ballRouteTimeBudget = milliseconds;
+        emit ballRouteTimeBudgetChanged();
     }
-    qDebug() << "Loaded connections for" << connections.size() << "nodes";
 }
 
-double PathfindingEngine::calculateHeuristic(const QString& nodeId1, const QString& nodeId2)
+void PathfindingEngine::setWatchArenaFile(bool watch)
 {
-    if (!nodeExists(nodeId1) || !nodeExists(nodeId2)) {
-        return std::numeric_limits<double>::max();
+    if (m_watchArenaFile != watch) {
+        m_watchArenaFile = watch;
+        watchArena();
+        emit watchArenaFileChanged();
     }
+}
 
-    const Node& node1 = nodes[nodeId1];
-    const Node& node2 = nodes[nodeId2];
+void PathfindingEngine::setPathSearch(const QString& search)
+{
+    PathSearch unused;
+    if (!toPathSearch(search, unused)) {
+        qCWarning(lcPlanner) << "Unknown path search" << search << "- keeping" << m_pathSearch;
+        return;
+    }
+    if (m_pathSearch != search) {
+        m_pathSearch = search;
+        preparePathSearch();
+        emit pathSearchChanged();
+    }
+}
 
-    // Euclidean distance with elevation consideration
-    double dx = node1.x - node2.x;
-    double dy = node1.y - node2.y;
-    double dz = node1.elevation - node2.elevation;
+void PathfindingEngine::setPathCacheCapacity(int bytes)
+{
+    bytes = qMax(0, bytes);
+    if (pathCacheCapacity() != bytes) {
+        pathCache.setCapacity(bytes);
+        emit pathCacheCapacityChanged();
+        emit pathCacheStatsChanged();
+    }
+}
 
-    return std::sqrt(dx * dx + dy * dy + dz * dz * 0.1); // Weight elevation less
+QVariantMap PathfindingEngine::pathCacheStats() const
+{
+    return QVariantMap{{"hits", static_cast<qint64>(pathCache.hits())},
+                       {"misses", static_cast<qint64>(pathCache.misses())},
+                       {"hitRate", pathCache.hitRate()},
+                       {"entries", pathCache.size()},
+                       {"bytes", static_cast<qint64>(pathCache.memoryUsage())},
+                       {"capacity", static_cast<qint64>(pathCache.capacity())}};
 }
 
-QVariantList PathfindingEngine::findPath(const QString& startNodeId, const QString& endNodeId)
+void PathfindingEngine::setLastRouteProvenOptimal(bool provenOptimal)
 {
-    if (!nodeExists(startNodeId) || !nodeExists(endNodeId)) {
-        qDebug() << "Invalid start or end node";
-        return QVariantList();
+    if (m_lastRouteProvenOptimal != provenOptimal) {
+        m_lastRouteProvenOptimal = provenOptimal;
+        emit lastRouteProvenOptimalChanged();
     }
+}
 
-    std::priority_queue<AStarNode, std::vector<AStarNode>, AStarNodeComparator> openSet;
-    std::unordered_set<QString> closedSet;
-    std::unordered_map<QString, QString> cameFrom;
-    std::unordered_map<QString, double> gScore;
-
-    // Initialize
-    gScore[startNodeId] = 0.0;
-    openSet.emplace(startNodeId, 0.0, calculateHeuristic(startNodeId, endNodeId));
+unsigned int PathfindingEngine::nextSeed()
+{
+    return m_randomSeed != 0 ? static_cast<unsigned int>(m_randomSeed) : rng();
+}
 
-    while (!openSet.empty()) {
-        AStarNode current = openSet.top();
-        openSet.pop();
+GeneticSettings PathfindingEngine::geneticSettings() const
+{
+    GeneticSettings settings;
+    settings.islandCount = m_islandCount;
+    return settings;
+}
 
-        if (current.nodeId == endNodeId) {
-            // Path found
-            std::vector<QString> path = reconstructPath(cameFrom, endNodeId);
-            path.insert(path.begin(), startNodeId);
-            return convertPathToVariantList(path);
-        }
+PrizeRouteSettings PathfindingEngine::prizeRouteSettings() const
+{
+    PrizeRouteSettings settings;
+    // A clock cut-off would make seeded runs depend on machine load
+    settings.timeBudgetMs = m_randomSeed != 0 ? 0 : m_ballRouteTimeBudget;
+    return settings;
+}
 
-        if (closedSet.count(current.nodeId)) {
-            continue;
+void PathfindingEngine::setNodes(const QVariantList& nodeList)
+{
+    if (arenaConnections) {
+        // Explicit connections of an arena file exist only as edges; the new
+        // nodes are matched to them by id
+        const PlannerGraph& arena = *arenaConnections;
+        connectionData.clear();
+        for (int node = 0; node < arena.graph.nodeCount(); ++node) {
+            QVariantList connectionList;
+            for (int e = arena.graph.edgeBegin(node); e < arena.graph.edgeEnd(node); ++e) {
+                connectionList.append(QVariantMap{{"targetId", arena.nodeIds[arena.graph.edgeTargets[e]]},
+                                                  {"cost", arena.graph.edgeCosts[e]},
+                                                  {"distance", arena.graph.edgeDistances[e]}});
+            }
+            connectionData.insert(arena.nodeIds[node], connectionList);
         }
+        arenaConnections.reset();
+    }
+    setArenaFile(QString());
 
-        closedSet.insert(current.nodeId);
-
-        // Check all neighbors
-        if (connections.count(current.nodeId)) {
-            for (const Connection& conn : connections[current.nodeId]) {
-                if (closedSet.count(conn.targetId)) {
-                    continue;
-                }
+    auto next = std::make_shared<PlannerGraph>();
+    next->loadNodes(nodeList);
+    if (builtNeighbours > 0) {
+        next->buildNearestNeighbours(builtNeighbours, builtCostModel);
+    } else {
+        next->loadConnections(connectionData);
+    }
+    plannerGraph = next;
+    editedGraph.reset();
+    ++graphVersion;
+    resetReplanner();
+    preparePathSearch();
 
-                double tentativeGScore = gScore[current.nodeId] + conn.cost;
+    qCInfo(lcPlanner) << "Loaded" << next->graph.nodeCount() << "nodes";
+    emit graphChanged();
+}
 
-                if (!gScore.count(conn.targetId) || tentativeGScore < gScore[conn.targetId]) {
-                    cameFrom[conn.targetId] = current.nodeId;
-                    gScore[conn.targetId] = tentativeGScore;
+void PathfindingEngine::setConnections(const QVariantMap& connectionMap)
+{
+    // Connections from QML bring their own costs
+    if (builtNeighbours > 0) {
+        ++costModelVersion;
+    }
+    connectionData = connectionMap;
+    builtNeighbours = 0;
+    arenaConnections.reset();
+
+    auto next = std::make_shared<PlannerGraph>();
+    next->copyNodesFrom(*currentGraph());
+    next->loadConnections(connectionData);
+    plannerGraph = next;
+    ++graphVersion;
+    resetReplanner();
+    preparePathSearch();
+
+    qCInfo(lcPlanner) << "Loaded" << next->graph.edgeCount() << "connections for" << connectionData.size() << "nodes";
+    emit graphChanged();
+}
 
-                    double hScore = calculateHeuristic(conn.targetId, endNodeId);
-                    openSet.emplace(conn.targetId, tentativeGScore, hScore);
-                }
-            }
+int PathfindingEngine::buildGraph(int neighbours, const QString& costModel)
+{
+    const bool hadBuiltCosts = builtNeighbours > 0;
+    const EdgeCostModel previousCostModel = builtCostModel;
+    if (costModel == "distance") {
+        builtCostModel = EdgeCostModel::Distance;
+    } else {
+        if (costModel != "elevation") {
+            qCWarning(lcPlanner) << "Unknown cost model" << costModel << "- using elevation";
         }
-    }
+        builtCostModel = EdgeCostModel::Elevation;
+    }
+    builtNeighbours = qMax(1, neighbours);
+    connectionData.clear();
+    arenaConnections.reset();
+    if (!hadBuiltCosts || builtCostModel != previousCostModel) {
+        ++costModelVersion;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto next = std::make_shared<PlannerGraph>();
+    next->copyNodesFrom(*currentGraph());
+    next->buildNearestNeighbours(builtNeighbours, builtCostModel);
+    plannerGraph = next;
+    ++graphVersion;
+    resetReplanner();
+    preparePathSearch();
+
+    qCInfo(lcPlanner) << "Built" << next->graph.edgeCount() << "connections for" << next->graph.nodeCount()
+                      << "nodes in" << timer.elapsed() << "ms";
+    emit graphChanged();
+    return next->graph.edgeCount();
+}
 
-    qDebug() << "No path found between" << startNodeId << "and" << endNodeId;
-    return QVariantList();
+bool PathfindingEngine::loadArena(const QString& path)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto next = std::make_shared<PlannerGraph>();
+    ArenaFile::Info info;
+    QString error;
+    if (!ArenaFile::load(path, *next, info, &error)) {
+        qCWarning(lcPlanner) << "Could not load arena" << path << "-" << error;
+        return false;
+    }
+
+    // Arenas with explicit connections bring their own costs
+    if (info.neighbours == 0 || builtNeighbours == 0 || info.costModel != builtCostModel) {
+        ++costModelVersion;
+    }
+    builtNeighbours = info.neighbours;
+    builtCostModel = info.costModel;
+    connectionData.clear();
+    arenaConnections = info.neighbours > 0 ? nullptr : next;
+    plannerGraph = next;
+    editedGraph.reset();
+    ++graphVersion;
+    resetReplanner();
+    preparePathSearch();
+    setArenaFile(QFileInfo(path).absoluteFilePath());
+
+    const int elapsed = static_cast<int>(timer.elapsed());
+    qCInfo(lcPlanner) << "Loaded arena" << path << "with" << next->graph.nodeCount() << "nodes and"
+                      << next->graph.edgeCount() << "connections in" << elapsed << "ms";
+    emit graphChanged();
+    emit arenaLoaded(m_arenaFile, elapsed);
+    return true;
 }
 
-QVariantList PathfindingEngine::findOptimalCollectionRoute(const QString& startNodeId, const QVariantList& targetNodes)
+bool PathfindingEngine::saveArena(const QString& path, bool includeTables)
 {
-    if (!nodeExists(startNodeId) || targetNodes.isEmpty()) {
-        return QVariantList();
-    }
+    ArenaFile::Info info;
+    info.neighbours = builtNeighbours;
+    info.costModel = builtCostModel;
 
-    std::vector<QString> targets;
-    for (const QVariant& target : targetNodes) {
-        QString targetId = target.toString();
-        if (nodeExists(targetId)) {
-            targets.push_back(targetId);
-        }
+    QString error;
+    if (!ArenaFile::save(path, *currentGraph(), info, includeTables, &error)) {
+        qCWarning(lcPlanner) << "Could not save arena" << path << "-" << error;
+        return false;
     }
+    return true;
+}
 
-    if (targets.empty()) {
-        return QVariantList();
+void PathfindingEngine::setArenaFile(const QString& path)
+{
+    if (m_arenaFile != path) {
+        m_arenaFile = path;
+        watchArena();
+        emit arenaFileChanged();
     }
+}
 
-    // Use Genetic Algorithm to solve TSP
-    const int populationSize = 100;
-    const int generations = 500;
-    const double mutationRate = 0.1;
-    const double elitePercentage = 0.2;
-
-    std::vector<Individual> population = initializePopulation(startNodeId, targets, populationSize);
-
-    for (int generation = 0; generation < generations; ++generation) {
-        // Calculate fitness for all individuals
-        for (Individual& individual : population) {
-            individual.fitness = calculateRouteFitness(individual.route);
-        }
-
-        // Sort by fitness (lower is better)
-        std::sort(population.begin(), population.end(),
-                  [](const Individual& a, const Individual& b) {
-                      return a.fitness < b.fitness;
-                  });
-
-        // Create new population
-        std::vector<Individual> newPopulation;
+void PathfindingEngine::watchArena()
+{
+    const QStringList watched = arenaWatcher->files();
+    const bool wanted = m_watchArenaFile && !m_arenaFile.isEmpty();
+    if (!watched.isEmpty() && (!wanted || watched.first() != m_arenaFile)) {
+        arenaWatcher->removePaths(watched);
+    }
+    // Files saved by renaming a new one over them drop out of the watch
+    if (wanted && arenaWatcher->files().isEmpty() && QFileInfo::exists(m_arenaFile)) {
+        arenaWatcher->addPath(m_arenaFile);
+    }
+}
 
-        // Keep elite individuals
-        int eliteCount = static_cast<int>(populationSize * elitePercentage);
-        for (int i = 0; i < eliteCount; ++i) {
-            newPopulation.push_back(population[i]);
-        }
+void PathfindingEngine::reloadArena()
+{
+    // A failed reload (file still being written) keeps the previous arena,
+    // the next change event tries again
+    if (!m_arenaFile.isEmpty()) {
+        loadArena(m_arenaFile);
+    }
+    watchArena();
+}
 
-        // Fill rest with crossover and mutation
-        while (newPopulation.size() < populationSize) {
-            std::vector<Individual> parents = selection(population, 2);
-            Individual offspring = crossover(parents[0], parents[1]);
-            mutate(offspring, mutationRate);
-            newPopulation.push_back(offspring);
+QVariantList PathfindingEngine::edgeSegments()
+{
+    std::shared_ptr<const PlannerGraph> snapshot = currentGraph();
+    const NavGraph& graph = snapshot->graph;
+
+    const std::vector<int> links = graph.passableLinks();
+    QVariantList segments;
+    segments.reserve(links.size() * 4);
+
+    // Links come in edge order, so the source node only ever moves forward
+    int source = 0;
+    for (int e : links) {
+        while (e >= graph.edgeEnd(source)) {
+            ++source;
         }
-
-        population = newPopulation;
+        int target = graph.edgeTargets[e];
+        segments << graph.x[source] << graph.y[source] << graph.x[target] << graph.y[target];
     }
 
-    // Find best solution
-    double bestFitness = std::numeric_limits<double>::max();
-    Individual bestIndividual;
+    return segments;
+}
 
-    for (const Individual& individual : population) {
-        double fitness = calculateRouteFitness(individual.route);
-        if (fitness < bestFitness) {
-            bestFitness = fitness;
-            bestIndividual = individual;
+QString PathfindingEngine::nodeAt(double x, double y, double radius) const
+{
+    const PlannerGraph& graph = latestGraph();
+    std::vector<SpatialGrid::Neighbour> hits;
+    graph.spatialIndex.withinRadius(x, y, radius, hits);
+    for (const auto& hit : hits) {
+        if (!graph.isRemoved(hit.second)) {
+            return graph.nodeIds[hit.second];
         }
     }
+    return QString();
+}
 
-    // Convert to full path with A* between waypoints
-    QVariantList fullPath;
-
-    for (size_t i = 0; i < bestIndividual.route.size() - 1; ++i) {
-        QVariantList segmentPath = findPath(bestIndividual.route[i], bestIndividual.route[i + 1]);
-
-        // Add segment path (excluding the last node to avoid duplicates)
-        for (int j = 0; j < segmentPath.size() - 1; ++j) {
-            fullPath.append(segmentPath[j]);
+QString PathfindingEngine::nearestNode(double x, double y) const
+{
+    // Removed nodes are rare, so widen the query only while every node
+    // found so far is one of them
+    const PlannerGraph& graph = latestGraph();
+    std::vector<SpatialGrid::Neighbour> nearest;
+    for (int count = 1;; count *= 4) {
+        graph.spatialIndex.nearest(x, y, count, -1, nearest);
+        for (const auto& candidate : nearest) {
+            if (!graph.isRemoved(candidate.second)) {
+                return graph.nodeIds[candidate.second];
+            }
+        }
+        if (static_cast<int>(nearest.size()) < count) {
+            return QString();
         }
     }
+}
 
-    // Add the final destination
-    if (!bestIndividual.route.empty()) {
-        fullPath.append(bestIndividual.route.back());
+QStringList PathfindingEngine::nodesInRect(double x, double y, double width, double height) const
+{
+    const PlannerGraph& graph = latestGraph();
+    std::vector<int> nodes;
+    graph.spatialIndex.inRect(x, y, x + width, y + height, nodes);
+
+    QStringList nodeIds;
+    nodeIds.reserve(nodes.size());
+    for (int node : nodes) {
+        if (!graph.isRemoved(node)) {
+            nodeIds.append(graph.nodeIds[node]);
+        }
     }
-
-    qDebug() << "Optimal route found with fitness:" << bestFitness;
-
-    return fullPath;
+    return nodeIds;
 }
 
-void PathfindingEngine::clearPath()
+QVariantMap PathfindingEngine::nodeData(const QString& nodeId)
 {
-    // This method can be used to clear any cached paths if needed
-    qDebug() << "Path cleared";
+    std::shared_ptr<const PlannerGraph> snapshot = currentGraph();
+    int node = snapshot->indexOf(nodeId);
+    return node >= 0 ? snapshot->nodeToVariantMap(node) : QVariantMap();
 }
 
-std::vector<QString> PathfindingEngine::reconstructPath(const std::unordered_map<QString, QString>& cameFrom, const QString& current)
+QVariantList PathfindingEngine::findPath(const QString& startNodeId, const QString& endNodeId, const QString& search)
 {
-    std::vector<QString> path;
-    QString currentNode = current;
+    int startNode = plannerGraph->indexOf(startNodeId);
+    int endNode = plannerGraph->indexOf(endNodeId);
 
-    while (cameFrom.count(currentNode)) {
-        path.push_back(currentNode);
-        currentNode = cameFrom.at(currentNode);
+    if (startNode < 0 || endNode < 0) {
+        qCWarning(lcPlanner) << "Invalid start or end node";
+        return QVariantList();
     }
 
-    std::reverse(path.begin(), path.end());
-    return path;
-}
-
-QVariantList PathfindingEngine::convertPathToVariantList(const std::vector<QString>& path)
-{
-    QVariantList result;
+    PathSearch pathSearch;
+    if (!toPathSearch(search.isEmpty() ? m_pathSearch : search, pathSearch)) {
+        qCWarning(lcPlanner) << "Unknown path search" << search;
+        return QVariantList();
+    }
 
-    for (const QString& nodeId : path) {
-        if (nodeExists(nodeId)) {
-            QVariantMap nodeData;
-            const Node& node = nodes[nodeId];
-            nodeData["elementId"] = node.elementId;
-            nodeData["x"] = node.x;
-            nodeData["y"] = node.y;
-            nodeData["elevation"] = node.elevation;
-            nodeData["type"] = node.type;
-            nodeData["points"] = node.points;
+    std::shared_ptr<const PlannerGraph> snapshot = currentGraph();
+    pathSearch = availableSearch(pathSearch, snapshot);
+    const PathCache::Key key = pathKey(startNode, endNode, pathSearch);
+    std::vector<int> path;
+    if (const std::vector<int>* cached = pathCache.find(key)) {
+        path = *cached;
+    } else {
+        RoutePlanner planner(snapshot, nextSeed());
+        planner.setSearchScratch(searchScratch, reverseSearchScratch);
+        path = planner.findPath(startNode, endNode, pathSearch);
+        pathCache.insert(key, path);
+    }
+    emit pathCacheStatsChanged();
 
-            result.append(nodeData);
-        }
+    if (path.empty()) {
+        qCDebug(lcPlanner) << "No path found between" << startNodeId << "and" << endNodeId;
+        return QVariantList();
     }
 
-    return result;
+    return snapshot->toVariantList(path);
 }
 
-std::vector<Individual> PathfindingEngine::initializePopulation(const QString& startNodeId,
-                                                                const std::vector<QString>& targets,
-                                                                int populationSize)
+QVariantList PathfindingEngine::findOptimalCollectionRoute(const QString& startNodeId, const QVariantList& targetNodes)
 {
-    std::vector<Individual> population;
-
-    for (int i = 0; i < populationSize; ++i) {
-        Individual individual;
-        individual.route.push_back(startNodeId);
-
-        // Create random permutation of targets
-        std::vector<QString> shuffledTargets = targets;
-        std::shuffle(shuffledTargets.begin(), shuffledTargets.end(), rng);
-
-        for (const QString& target : shuffledTargets) {
-            individual.route.push_back(target);
-        }
-
-        population.push_back(individual);
+    int startNode = plannerGraph->indexOf(startNodeId);
+    if (startNode < 0 || targetNodes.isEmpty()) {
+        return QVariantList();
     }
 
-    return population;
+    RoutePlanner planner(currentGraph(), nextSeed());
+    planner.setGeneticSettings(geneticSettings());
+    std::vector<int> route = planner.findOptimalCollectionRoute(startNode, toNodeIndices(targetNodes));
+    setLastRouteProvenOptimal(planner.lastRouteProvenOptimal());
+    return plannerGraph->toVariantList(route);
 }
 
-double PathfindingEngine::calculateRouteFitness(const std::vector<QString>& route)
+QVariantList PathfindingEngine::findOptimalBallCollectionRoute(const QString& startNodeId,
+                                                               const QString& releaseNodeId,
+                                                               int carryCapacity)
 {
-    if (route.size() < 2) {
-        return std::numeric_limits<double>::max();
+    int startNode = plannerGraph->indexOf(startNodeId);
+    int releaseNode = plannerGraph->indexOf(releaseNodeId);
+
+    if (startNode < 0 || releaseNode < 0) {
+        qCWarning(lcPlanner) << "Invalid start or release node";
+        return QVariantList();
     }
 
-    double totalDistance = 0.0;
+    RoutePlanner planner(currentGraph(), nextSeed());
+    planner.setPrizeRouteSettings(prizeRouteSettings());
+    return plannerGraph->toVariantList(planner.findOptimalBallCollectionRoute(startNode, releaseNode, carryCapacity));
+}
 
-    for (size_t i = 0; i < route.size() - 1; ++i) {
-        // For simplicity, use heuristic distance
-        // In practice, you might want to use actual A* distance
-        double distance = calculateHeuristic(route[i], route[i + 1]);
-        totalDistance += distance;
+double PathfindingEngine::calculateRouteValue(const std::vector<QString>& route, const QString& releaseNodeId)
+{
+    std::vector<int> routeNodes;
+    routeNodes.reserve(route.size());
+    for (const QString& nodeId : route) {
+        int node = plannerGraph->indexOf(nodeId);
+        if (node >= 0) {
+            routeNodes.push_back(node);
+        }
     }
 
-    return totalDistance;
+    RoutePlanner planner(currentGraph(), nextSeed());
+    return planner.calculateRouteValue(routeNodes, plannerGraph->indexOf(releaseNodeId));
 }
 
-double PathfindingEngine::calculateTotalDistance(const std::vector<QString>& route)
+void PathfindingEngine::clearPath()
 {
-    return calculateRouteFitness(route);
+    // Drop any route still being planned along with the shown one
+    cancelAllRequests();
+    m_route->clear();
+    m_bestRoute->clear();
+    qCDebug(lcPlanner) << "Path cleared";
 }
 
-Individual PathfindingEngine::crossover(const Individual& parent1, const Individual& parent2)
+int PathfindingEngine::requestPath(const QString& startNodeId, const QString& endNodeId, const QString& search)
 {
-    Individual offspring;
+    int startNode = plannerGraph->indexOf(startNodeId);
+    int endNode = plannerGraph->indexOf(endNodeId);
 
-    if (parent1.route.size() != parent2.route.size()) {
-        return parent1; // Fallback
+    if (startNode < 0 || endNode < 0) {
+        qCWarning(lcPlanner) << "Invalid start or end node";
+        return -1;
     }
 
-    offspring.route.push_back(parent1.route[0]); // Start node
-
-    // Order crossover (OX)
-    int size = parent1.route.size() - 1; // Exclude start node
-    int start = 1 + (rng() % (size - 1));
-    int end = start + (rng() % (size - start));
-
-    std::unordered_set<QString> included;
-
-    // Copy segment from parent1
-    for (int i = start; i <= end; ++i) {
-        offspring.route.push_back(parent1.route[i]);
-        included.insert(parent1.route[i]);
+    PathSearch pathSearch;
+    if (!toPathSearch(search.isEmpty() ? m_pathSearch : search, pathSearch)) {
+        qCWarning(lcPlanner) << "Unknown path search" << search;
+        return -1;
     }
 
-    // Fill remaining from parent2
-    for (int i = 1; i < parent2.route.size(); ++i) {
-        if (included.find(parent2.route[i]) == included.end()) {
-            offspring.route.push_back(parent2.route[i]);
-        }
+    pathSearch = availableSearch(pathSearch, currentGraph());
+
+    // A cached path still goes through a job, so callers see the same
+    // signals either way
+    const PathCache::Key key = pathKey(startNode, endNode, pathSearch);
+    const std::vector<int>* cached = pathCache.find(key);
+    emit pathCacheStatsChanged();
+    if (cached) {
+        return startJob(JobKind::Path, [path = *cached](RoutePlanner&, const PlannerControl&) {
+            return path;
+        });
     }
 
-    return offspring;
+    return startJob(JobKind::Path, [startNode, endNode, pathSearch](RoutePlanner& planner, const PlannerControl&) {
+        return planner.findPath(startNode, endNode, pathSearch);
+    }, &key);
 }
 
-void PathfindingEngine::mutate(Individual& individual, double mutationRate)
+int PathfindingEngine::requestOptimalCollectionRoute(const QString& startNodeId, const QVariantList& targetNodes)
 {
-    if (individual.route.size() < 3) return; // Need at least start + 2 targets
-
-    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < mutationRate) {
-        // Swap two random positions (excluding start)
-        int pos1 = 1 + (rng() % (individual.route.size() - 1));
-        int pos2 = 1 + (rng() % (individual.route.size() - 1));
-
-        std::swap(individual.route[pos1], individual.route[pos2]);
+    int startNode = plannerGraph->indexOf(startNodeId);
+    if (startNode < 0 || targetNodes.isEmpty()) {
+        return -1;
     }
+
+    std::vector<int> targets = toNodeIndices(targetNodes);
+    return startJob(JobKind::Route, [startNode, targets](RoutePlanner& planner, const PlannerControl& control) {
+        return planner.findOptimalCollectionRoute(startNode, targets, control);
+    });
 }
 
-std::vector<Individual> PathfindingEngine::selection(const std::vector<Individual>& population, int selectionSize)
+int PathfindingEngine::requestOptimalBallCollectionRoute(const QString& startNodeId,
+                                                         const QString& releaseNodeId,
+                                                         int carryCapacity)
 {
-    std::vector<Individual> selected;
-
-    // Tournament selection
-    for (int i = 0; i < selectionSize; ++i) {
-        int tournamentSize = 3;
-        Individual best = population[rng() % population.size()];
-
-        for (int j = 1; j < tournamentSize; ++j) {
-            Individual candidate = population[rng() % population.size()];
-            if (candidate.fitness < best.fitness) {
-                best = candidate;
-            }
-        }
+    int startNode = plannerGraph->indexOf(startNodeId);
+    int releaseNode = plannerGraph->indexOf(releaseNodeId);
 
-        selected.push_back(best);
+    if (startNode < 0 || releaseNode < 0) {
+        qCWarning(lcPlanner) << "Invalid start or release node";
+        return -1;
     }
 
-    return selected;
+    return startJob(JobKind::Route, [startNode, releaseNode, carryCapacity](RoutePlanner& planner, const PlannerControl& control) {
+        return planner.findOptimalBallCollectionRoute(startNode, releaseNode, carryCapacity, control);
+    });
 }
 
-bool PathfindingEngine::nodeExists(const QString& nodeId) const
+void PathfindingEngine::cancelRequest(int jobId)
 {
-    return nodes.count(nodeId) > 0;
-}
+    auto it = activeJobs.find(jobId);
+    if (it == activeJobs.end()) {
+        return;
+    }
 
-std::vector<QString> PathfindingEngine::getShortestPathBetween(const QString& start, const QString& end)
-{
-    QVariantList path = findPath(start, end);
-    std::vector<QString> result;
+    it->second->cancelled = true;
+    activeJobs.erase(it);
 
-    for (const QVariant& nodeVariant : path) {
-        QVariantMap nodeMap = nodeVariant.toMap();
-        result.push_back(nodeMap["elementId"].toString());
+    emit planningCancelled(jobId);
+    if (activeJobs.empty()) {
+        emit busyChanged();
     }
-
-    return result;
 }
 
-// Replace the problematic section in findOptimalBallCollectionRoute method
-
-QVariantList PathfindingEngine::findOptimalBallCollectionRoute(const QString& startNodeId,
-                                                               const QString& releaseNodeId,
-                                                               int carryCapacity)
+void PathfindingEngine::cancelAllRequests()
 {
-    if (!nodeExists(startNodeId) || !nodeExists(releaseNodeId)) {
-        qDebug() << "Invalid start or release node";
-        return QVariantList();
+    std::vector<int> jobIds;
+    for (const auto& entry : activeJobs) {
+        jobIds.push_back(entry.first);
     }
 
-    std::vector<QString> allBalls = getCollectibleBallNodes();
-    if (allBalls.empty()) {
-        qDebug() << "No collectible balls found";
-        return QVariantList();
+    for (int jobId : jobIds) {
+        cancelRequest(jobId);
     }
+}
 
-    qDebug() << "Found" << allBalls.size() << "balls, capacity:" << carryCapacity;
-
-    // Limit the search space to prevent combinatorial explosion
-    int maxBallsToConsider = std::min(carryCapacity, std::min(8, (int)allBalls.size()));
-
-    // If we have too many balls, select the closest ones to start with
-    if (allBalls.size() > maxBallsToConsider) {
-        std::vector<std::pair<double, QString>> ballDistances;
-        for (const QString& ballId : allBalls) {
-            double distance = calculateHeuristic(startNodeId, ballId);
-            ballDistances.emplace_back(distance, ballId);
+bool PathfindingEngine::updateEdgeCost(const QString& fromNodeId, const QString& toNodeId, double cost)
+{
+    int fromNode = plannerGraph->indexOf(fromNodeId);
+    int toNode = plannerGraph->indexOf(toNodeId);
+
+    if (fromNode < 0 || toNode < 0 || plannerGraph->graph.findEdge(fromNode, toNode) < 0) {
+        qCWarning(lcPlanner) << "No connection from" << fromNodeId << "to" << toNodeId;
+        return false;
+    }
+    // Every search relies on costs never being negative; NaN fails
+    // this too
+    if (!(cost >= 0.0)) {
+        qCWarning(lcPlanner) << "Invalid cost" << cost << "from" << fromNodeId << "to" << toNodeId;
+        return false;
+    }
+
+    PlannerGraph& edited = editableGraph();
+    NavGraph& graph = edited.graph;
+    for (int e = graph.edgeBegin(fromNode); e < graph.edgeEnd(fromNode); ++e) {
+        if (graph.edgeTargets[e] == toNode) {
+            // Landmark bounds survive dearer edges, not cheaper ones; the
+            // hierarchy's shortcuts survive neither
+            if (cost < graph.edgeCosts[e]) {
+                edited.setLandmarks(nullptr);
+            }
+            edited.setHierarchy(nullptr);
+            graph.edgeCosts[e] = cost;
+            if (replanGraph) {
+                replanner.setEdgeCost(e, cost);
+            }
         }
+    }
+    ++graphVersion;
+
+    emit graphChanged();
+    return true;
+}
 
-        // Sort by distance and take the closest ones
-        std::sort(ballDistances.begin(), ballDistances.end());
-        allBalls.clear();
-        for (int i = 0; i < maxBallsToConsider; ++i) {
-            allBalls.push_back(ballDistances[i].second);
+bool PathfindingEngine::removeNode(const QString& nodeId)
+{
+    int node = plannerGraph->indexOf(nodeId);
+    if (node < 0) {
+        qCWarning(lcPlanner) << "Invalid node" << nodeId;
+        return false;
+    }
+
+    // The node stays in the graph, nothing can pass through it any more
+    const double blocked = std::numeric_limits<double>::infinity();
+    PlannerGraph& edited = editableGraph();
+    NavGraph& graph = edited.graph;
+    edited.setHierarchy(nullptr);
+    ++graphVersion;
+    for (int e = 0; e < graph.edgeCount(); ++e) {
+        if (graph.edgeTargets[e] == node) {
+            graph.edgeCosts[e] = blocked;
         }
     }
+    for (int e = graph.edgeBegin(node); e < graph.edgeEnd(node); ++e) {
+        graph.edgeCosts[e] = blocked;
+    }
+    edited.removedNodes.resize(graph.nodeCount(), 0);
+    edited.removedNodes[node] = 1;
 
-    qDebug() << "Considering" << allBalls.size() << "balls for optimization";
+    if (replanGraph) {
+        replanner.removeNode(node);
+    }
 
-    // Generate combinations more efficiently
-    std::vector<std::vector<QString>> ballCombinations;
+    emit graphChanged();
+    return true;
+}
 
-    // Use iterative approach for smaller combinations to avoid stack overflow
-    for (int size = 1; size <= std::min(carryCapacity, (int)allBalls.size()); ++size) {
-        if (size <= 6) { // Only generate combinations up to reasonable size
-            generateCombinations(allBalls, size, ballCombinations);
-        }
+bool PathfindingEngine::markCollected(const QString& nodeId)
+{
+    int node = plannerGraph->indexOf(nodeId);
+    if (node < 0 || !isCollectibleKind(plannerGraph->graph.kind[node])) {
+        qCDebug(lcPlanner) << "Nothing to collect at" << nodeId;
+        return false;
     }
 
-    qDebug() << "Generated" << ballCombinations.size() << "combinations";
-
-    // Find the best combination
-    double bestValue = 0.0;
-    std::vector<QString> bestCombination;
+    // Collected balls are worth nothing and no longer route targets
+    NavGraph& graph = editableGraph().graph;
+    graph.points[node] = 0;
+    graph.kind[node] = NodeKind::Other;
 
-    for (const auto& combination : ballCombinations) {
-        try {
-            // Calculate route value more efficiently
-            double routeValue = calculateSimpleRouteValue(startNodeId, combination, releaseNodeId);
+    emit graphChanged();
+    return true;
+}
 
-            if (routeValue > bestValue) {
-                bestValue = routeValue;
-                bestCombination = combination;
-            }
-        } catch (const std::exception& e) {
-            qDebug() << "Error calculating route value:" << e.what();
-            continue;
-        }
-    }
+QVariantList PathfindingEngine::replanFrom(const QString& currentNodeId, const QString& goalNodeId)
+{
+    int startNode = plannerGraph->indexOf(currentNodeId);
+    int goalNode = goalNodeId.isEmpty() ? replanner.goal() : plannerGraph->indexOf(goalNodeId);
 
-    if (bestCombination.empty()) {
-        qDebug() << "No valid combination found";
+    if (startNode < 0 || goalNode < 0) {
+        qCWarning(lcPlanner) << "Invalid start or goal node";
         return QVariantList();
     }
 
-    qDebug() << "Best combination has" << bestCombination.size() << "balls with value:" << bestValue;
-
-    // Generate final optimized route
-    QVariantList ballsToCollect;
-    for (const QString& ballId : bestCombination) {
-        ballsToCollect.append(QVariant(ballId));
+    std::shared_ptr<const PlannerGraph> snapshot = currentGraph();
+    if (!replanGraph || replanner.goal() != goalNode) {
+        replanGraph = snapshot;
+        replanner.reset(replanGraph->graph, goalNode);
     }
 
-    QVariantList optimizedPath;
-
-    try {
-        // Use a simpler pathfinding approach for the final route
-        optimizedPath = findSimpleCollectionRoute(startNodeId, ballsToCollect);
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<int> path = replanner.replan(startNode);
+    qCDebug(lcPlanner) << "Replanned in" << timer.nsecsElapsed() / 1000 << "us," << replanner.lastExpansions() << "nodes expanded";
 
-        // Add release area to the end
-        if (!optimizedPath.empty() && nodeExists(releaseNodeId)) {
-            QVariantMap releaseData;
-            const Node& releaseNode = nodes[releaseNodeId];
-            releaseData["elementId"] = releaseNode.elementId;
-            releaseData["x"] = releaseNode.x;
-            releaseData["y"] = releaseNode.y;
-            releaseData["elevation"] = releaseNode.elevation;
-            releaseData["type"] = releaseNode.type;
-            releaseData["points"] = releaseNode.points;
-
-            optimizedPath.append(releaseData);
-        }
-    } catch (const std::exception& e) {
-        qDebug() << "Error generating final route:" << e.what();
+    if (path.empty()) {
+        qCDebug(lcPlanner) << "No path found from" << currentNodeId;
         return QVariantList();
     }
 
-    qDebug() << "Final route generated with" << optimizedPath.size() << "nodes";
-    return optimizedPath;
+    return snapshot->toVariantList(path);
 }
 
-// Helper method to generate combinations more safely
-void PathfindingEngine::generateCombinations(const std::vector<QString>& items,
-                                             int size,
-                                             std::vector<std::vector<QString>>& combinations)
+QVariantList PathfindingEngine::replanFromPosition(double x, double y, const QString& goalNodeId)
 {
-    if (size > items.size() || size <= 0) {
-        return;
+    QString currentNodeId = nearestNode(x, y);
+    if (currentNodeId.isEmpty()) {
+        qCWarning(lcPlanner) << "No nodes to snap the position to";
+        return QVariantList();
     }
-
-    std::vector<bool> selector(items.size(), false);
-    std::fill(selector.begin(), selector.begin() + size, true);
-
-    int count = 0;
-    const int maxCombinations = 1000; // Limit to prevent memory issues
-
-    do {
-        if (count >= maxCombinations) {
-            qDebug() << "Reached maximum combinations limit";
-            break;
-        }
-
-        std::vector<QString> combination;
-        for (size_t i = 0; i < items.size(); ++i) {
-            if (selector[i]) {
-                combination.push_back(items[i]);
-            }
-        }
-        combinations.push_back(combination);
-        count++;
-    } while (std::prev_permutation(selector.begin(), selector.end()));
+    return replanFrom(currentNodeId, goalNodeId);
 }
 
-double PathfindingEngine::calculateSimpleRouteValue(const QString& startNodeId,
-                                                    const std::vector<QString>& ballIds,
-                                                    const QString& releaseNodeId)
+std::shared_ptr<const PlannerGraph> PathfindingEngine::currentGraph()
 {
-    if (ballIds.empty()) {
-        return 0.0;
+    // Publish pending run-time edits as a new snapshot
+    if (editedGraph) {
+        plannerGraph = editedGraph;
+        editedGraph.reset();
+        preparePathSearch();
     }
+    return plannerGraph;
+}
 
-    // Calculate total points
-    int totalPoints = 0;
-    for (const QString& ballId : ballIds) {
-        if (nodeExists(ballId)) {
-            totalPoints += nodes[ballId].points;
-        }
+PlannerGraph& PathfindingEngine::editableGraph()
+{
+    if (!editedGraph) {
+        editedGraph = std::make_shared<PlannerGraph>();
+        editedGraph->copyFrom(*plannerGraph);
+        editedGraph->setLandmarks(plannerGraph->builtLandmarks());
+        editedGraph->setHierarchy(plannerGraph->builtHierarchy());
     }
+    return *editedGraph;
+}
 
-    // Estimate total distance (simplified)
-    double totalDistance = 0.0;
+void PathfindingEngine::resetReplanner()
+{
+    // Edge indices change with the connections, start over on the next replan
+    replanner = IncrementalPlanner();
+    replanGraph.reset();
+}
 
-    // Distance from start to first ball (use closest ball as approximation)
-    double minDistanceToStart = std::numeric_limits<double>::max();
-    for (const QString& ballId : ballIds) {
-        double distance = calculateHeuristic(startNodeId, ballId);
-        minDistanceToStart = std::min(minDistanceToStart, distance);
-    }
-    totalDistance += minDistanceToStart;
+PathCache::Key PathfindingEngine::pathKey(int startNode, int endNode, PathSearch search) const
+{
+    return PathCache::Key{startNode, endNode, graphVersion, costModelVersion, static_cast<int>(search)};
+}
 
-    // Approximate distance between balls (use average)
-    double avgBallDistance = 0.0;
-    if (ballIds.size() > 1) {
-        for (size_t i = 0; i < ballIds.size() - 1; ++i) {
-            avgBallDistance += calculateHeuristic(ballIds[i], ballIds[i + 1]);
-        }
-        avgBallDistance /= (ballIds.size() - 1);
-        totalDistance += avgBallDistance * (ballIds.size() - 1);
+bool PathfindingEngine::toPathSearch(const QString& name, PathSearch& search) const
+{
+    if (name == "astar") {
+        search = PathSearch::AStar;
+    } else if (name == "landmarks") {
+        search = PathSearch::Landmarks;
+    } else if (name == "bidirectional") {
+        search = PathSearch::Bidirectional;
+    } else if (name == "hierarchy") {
+        search = PathSearch::Hierarchy;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void PathfindingEngine::preparePathSearch()
+{
+    // Build tables off the GUI thread so queries do not have to; a query
+    // arriving earlier uses plain A* instead of waiting for the build
+    std::shared_ptr<const PlannerGraph> snapshot = plannerGraph;
+    const bool hasNodes = snapshot->graph.nodeCount() > 0;
+    const bool wantsHierarchy = m_pathSearch == "hierarchy" && hasNodes;
+    if (hierarchyBuildCancelled && (!wantsHierarchy || hierarchyBuildGraph.lock() != snapshot)) {
+        *hierarchyBuildCancelled = true;
+        hierarchyBuildCancelled.reset();
+    }
+
+    if (wantsHierarchy && !hierarchyBuildCancelled && !snapshot->builtHierarchy()) {
+        auto cancelled = std::make_shared<std::atomic<bool>>(false);
+        hierarchyBuildCancelled = cancelled;
+        hierarchyBuildGraph = snapshot;
+        threadPool->start([snapshot, cancelled]() {
+            QElapsedTimer timer;
+            timer.start();
+            if (snapshot->hierarchy(cancelled.get())) {
+                qCInfo(lcPlanner) << "Hierarchy for" << snapshot->graph.nodeCount() << "nodes ready in"
+                                  << timer.elapsed() << "ms";
+            }
+        });
     }
 
-    // Distance from last ball to release (use closest ball as approximation)
-    double minDistanceToRelease = std::numeric_limits<double>::max();
-    for (const QString& ballId : ballIds) {
-        double distance = calculateHeuristic(ballId, releaseNodeId);
-        minDistanceToRelease = std::min(minDistanceToRelease, distance);
+    if ((m_pathSearch == "landmarks" || m_pathSearch == "bidirectional") && hasNodes) {
+        buildLandmarks(snapshot);
     }
-    totalDistance += minDistanceToRelease;
+}
 
-    if (totalDistance <= 0.0) {
-        return 0.0;
+void PathfindingEngine::buildLandmarks(const std::shared_ptr<const PlannerGraph>& snapshot)
+{
+    if (snapshot->builtLandmarks() || landmarkBuildGraph.lock() == snapshot) {
+        return;
     }
 
-    return totalPoints / totalDistance;
+    landmarkBuildGraph = snapshot;
+    threadPool->start([snapshot]() {
+        snapshot->landmarks();
+    });
 }
 
-QVariantList PathfindingEngine::findSimpleCollectionRoute(const QString& startNodeId,
-                                                          const QVariantList& ballsToCollect)
+PathSearch PathfindingEngine::availableSearch(PathSearch search, const std::shared_ptr<const PlannerGraph>& snapshot)
 {
-    if (ballsToCollect.empty()) {
-        return QVariantList();
+    // Keying the cache by the search that ran keeps an A* fallback from
+    // being served as a landmark or hierarchy result later
+    if (search == PathSearch::Hierarchy) {
+        return snapshot->builtHierarchy() ? search : PathSearch::AStar;
     }
-
-    // Convert to vector for easier manipulation
-    std::vector<QString> balls;
-    for (const QVariant& ballVariant : ballsToCollect) {
-        balls.push_back(ballVariant.toString());
+    if (search == PathSearch::AStar || snapshot->builtLandmarks()) {
+        return search;
     }
 
-    // Use nearest neighbor heuristic instead of full genetic algorithm
-    std::vector<QString> route;
-    route.push_back(startNodeId);
+    // A query may ask for landmarks the engine's own mode did not build
+    buildLandmarks(snapshot);
+    return PathSearch::AStar;
+}
+
+int PathfindingEngine::startJob(JobKind kind, JobFunction work, const PathCache::Key* cacheKey)
+{
+    // Only the latest request matters to the operator
+    cancelAllRequests();
+
+    auto job = std::make_shared<PlannerJob>();
+    job->id = ++lastJobId;
+    job->kind = kind;
+    if (cacheKey) {
+        job->cachesPath = true;
+        job->pathKey = *cacheKey;
+    }
+    activeJobs[job->id] = job;
+    emit busyChanged();
+
+    std::shared_ptr<const PlannerGraph> snapshot = currentGraph();
+    unsigned int seed = nextSeed();
+    GeneticSettings settings = geneticSettings();
+    PrizeRouteSettings prizeSettings = prizeRouteSettings();
+
+    threadPool->start([this, job, snapshot, seed, settings, prizeSettings, work]() {
+        QElapsedTimer progressTimer;
+        progressTimer.start();
+
+        PlannerControl control;
+        control.cancelled = &job->cancelled;
+        control.progress = [this, job, progressTimer](int step, int totalSteps, double bestScore) mutable {
+            // Throttle to keep the GUI event queue short, but always send the last step
+            if (step < totalSteps && progressTimer.elapsed() < 50) {
+                return;
+            }
+            progressTimer.restart();
 
-    std::vector<QString> remaining = balls;
-    QString current = startNodeId;
+            QMetaObject::invokeMethod(this, [this, job, step, totalSteps, bestScore]() {
+                if (!job->cancelled) {
+                    emit planningProgress(job->id, step, totalSteps, bestScore);
+                }
+            }, Qt::QueuedConnection);
+        };
+        control.bestRoute = [this, job, snapshot](const std::vector<int>& route) {
+            QMetaObject::invokeMethod(this, [this, job, snapshot, route]() {
+                if (!job->cancelled) {
+                    m_bestRoute->setRoute(snapshot, route);
+                    emit bestRouteUpdated(job->id);
+                }
+            }, Qt::QueuedConnection);
+        };
 
-    while (!remaining.empty()) {
-        // Find closest remaining ball
-        double minDistance = std::numeric_limits<double>::max();
-        int bestIndex = 0;
+        RoutePlanner planner(snapshot, seed);
+        planner.setGeneticSettings(settings);
+        planner.setPrizeRouteSettings(prizeSettings);
+        std::vector<int> route = work(planner, control);
+        bool provenOptimal = planner.lastRouteProvenOptimal();
 
-        for (size_t i = 0; i < remaining.size(); ++i) {
-            double distance = calculateHeuristic(current, remaining[i]);
-            if (distance < minDistance) {
-                minDistance = distance;
-                bestIndex = i;
-            }
+        if (job->cancelled) {
+            return;
         }
 
-        // Add closest ball to route
-        route.push_back(remaining[bestIndex]);
-        current = remaining[bestIndex];
-        remaining.erase(remaining.begin() + bestIndex);
-    }
+        QMetaObject::invokeMethod(this, [this, job, snapshot, route = std::move(route), provenOptimal]() mutable {
+            finishJob(job->id, snapshot, std::move(route), provenOptimal);
+        }, Qt::QueuedConnection);
+    });
 
-    // Convert back to QVariantList
-    return convertPathToVariantList(route);
+    return job->id;
 }
 
-std::vector<QString> PathfindingEngine::getCollectibleBallNodes() const
+void PathfindingEngine::finishJob(int jobId,
+                                  std::shared_ptr<const PlannerGraph> snapshot,
+                                  std::vector<int> route,
+                                  bool provenOptimal)
 {
-    std::vector<QString> balls;
-
-    for (const auto& nodePair : nodes) {
-        const Node& node = nodePair.second;
-        if (node.type == "green_ball" ||
-            node.type == "black_striped_ball" ||
-            node.type == "star_ball" ||
-            node.type == "comm_tow") {
-            balls.push_back(node.elementId);
-        }
+    auto it = activeJobs.find(jobId);
+    if (it == activeJobs.end()) {
+        return; // Cancelled while the result was in flight
     }
 
-    return balls;
-}
-
-int PathfindingEngine::calculateTotalPoints(const std::vector<QString>& nodes) const
-{
-    int totalPoints = 0;
-    for (const QString& nodeId : nodes) {
-        if (nodeExists(nodeId)) {
-            totalPoints += this->nodes.at(nodeId).points;
-        }
+    JobKind kind = it->second->kind;
+    if (it->second->cachesPath) {
+        // The key holds the versions the job started on, so a result
+        // overtaken by an edit never matches a later query
+        pathCache.insert(it->second->pathKey, route);
+        emit pathCacheStatsChanged();
     }
-    return totalPoints;
-}
+    activeJobs.erase(it);
 
-double PathfindingEngine::calculateRouteValue(const std::vector<QString>& route, const QString& releaseNodeId)
-{
-    if (route.size() < 2) {
-        return 0.0;
+    if (kind == JobKind::Route) {
+        setLastRouteProvenOptimal(provenOptimal);
     }
 
-    // Calculate total points
-    int totalPoints = 0;
-    for (const QString& nodeId : route) {
-        if (nodeExists(nodeId) && nodeId != releaseNodeId) {
-            totalPoints += nodes[nodeId].points;
-        }
+    m_route->setRoute(std::move(snapshot), std::move(route));
+    m_bestRoute->clear();
+
+    emit planningFinished(jobId);
+    if (kind == JobKind::Path) {
+        emit pathCalculated();
+    } else {
+        emit optimalRouteCalculated();
     }
 
-    // Calculate total distance
-    double totalDistance = 0.0;
-    for (size_t i = 0; i < route.size() - 1; ++i) {
-        totalDistance += calculateHeuristic(route[i], route[i + 1]);
+    if (activeJobs.empty()) {
+        emit busyChanged();
     }
+}
 
-    if (totalDistance == 0.0) {
-        return 0.0;
+std::vector<int> PathfindingEngine::toNodeIndices(const QVariantList& nodeIds) const
+{
+    std::vector<int> indices;
+    indices.reserve(nodeIds.size());
+
+    for (const QVariant& nodeId : nodeIds) {
+        int node = plannerGraph->indexOf(nodeId.toString());
+        if (node >= 0) {
+            indices.push_back(node);
+        }
     }
 
-    return totalPoints / totalDistance; // Points per distance unit
+    return indices;
 }
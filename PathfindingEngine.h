@@ -1,70 +1,132 @@
 #pragma once
 
 #include <QObject>
+#include <QStringList>
 #include <QVariantList>
 #include <QVariantMap>
 #include <QPointF>
+#include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <unordered_map>
-#include <queue>
 #include <random>
+#include "PlannerGraph.h"
+#include "RoutePlanner.h"
+#include "IncrementalPlanner.h"
+#include "RouteModel.h"
+#include "PathCache.h"
 
-struct Node {
-    QString elementId;
-    double x, y;
-    double elevation;
-    QString type;
-    int points;
-
-    Node() : x(0), y(0), elevation(0), points(0) {}
-    Node(const QString& id, double x, double y, double elev, const QString& t, int p = 0)
-        : elementId(id), x(x), y(y), elevation(elev), type(t), points(p) {}
-};
-
-struct Connection {
-    QString targetId;
-    double cost;
-    double distance;
-
-    Connection(const QString& target, double c, double d)
-        : targetId(target), cost(c), distance(d) {}
-};
+class PathfindingEngine : public QObject
+{
+    Q_OBJECT
 
-struct AStarNode {
-    QString nodeId;
-    double gCost;  // Distance from start
-    double hCost;  // Heuristic distance to goal
-    double fCost() const { return gCost + hCost; }
-    QString parentId;
+    // True while an asynchronous planning request is running
+    Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
 
-    AStarNode(const QString& id, double g, double h, const QString& parent = "")
-        : nodeId(id), gCost(g), hCost(h), parentId(parent) {}
-};
+    // Non-zero makes every planner call repeatable: the same seed and island
+    // count always give the same route. The ball route search then runs to
+    // its iteration limit instead of ballRouteTimeBudget, so machine load
+    // cannot change where it stops. Zero picks a fresh seed per call.
+    Q_PROPERTY(int randomSeed READ randomSeed WRITE setRandomSeed NOTIFY randomSeedChanged)
+    // Parallel GA populations, defaults to one per hardware thread
+    Q_PROPERTY(int islandCount READ islandCount WRITE setIslandCount NOTIFY islandCountChanged)
+    // Search time for findOptimalBallCollectionRoute, in milliseconds;
+    // not used while randomSeed is set
+    Q_PROPERTY(int ballRouteTimeBudget READ ballRouteTimeBudget WRITE setBallRouteTimeBudget NOTIFY ballRouteTimeBudgetChanged)
+    // Whether the last collection route delivered is proven to be the
+    // cheapest visiting order (exact solver) or just the best one found (GA)
+    Q_PROPERTY(bool lastRouteProvenOptimal READ lastRouteProvenOptimal NOTIFY lastRouteProvenOptimalChanged)
 
-struct AStarNodeComparator {
-    bool operator()(const AStarNode& a, const AStarNode& b) const {
-        return a.fCost() > b.fCost();  // Min heap
-    }
-};
+    // Route delivered by the last finished asynchronous request
+    Q_PROPERTY(RouteModel* route READ route CONSTANT)
+    // Best route found so far by the request still running
+    Q_PROPERTY(RouteModel* bestRoute READ bestRoute CONSTANT)
 
-struct Individual {
-    std::vector<QString> route;
-    double fitness;
+    // Arena file the graph was last loaded from, empty after setNodes()
+    Q_PROPERTY(QString arenaFile READ arenaFile NOTIFY arenaFileChanged)
+    // Reload arenaFile whenever it changes on disk
+    Q_PROPERTY(bool watchArenaFile READ watchArenaFile WRITE setWatchArenaFile NOTIFY watchArenaFileChanged)
 
-    Individual() : fitness(0.0) {}
-    Individual(const std::vector<QString>& r) : route(r), fitness(0.0) {}
-};
+    // How findPath and requestPath search when not told otherwise: "astar"
+    // (straight-line heuristic), "landmarks" (A* on precomputed landmark
+    // bounds), "bidirectional" (landmark search from both ends) or
+    // "hierarchy" (contraction hierarchy). The other modes expand far
+    // fewer nodes on large arenas; their tables are built in the
+    // background whenever the graph changes. Until the hierarchy is
+    // ready, "hierarchy" answers with plain A*.
+    Q_PROPERTY(QString pathSearch READ pathSearch WRITE setPathSearch NOTIFY pathSearchChanged)
 
-class PathfindingEngine : public QObject
-{
-    Q_OBJECT
+    // findPath and requestPath results are kept for repeated queries, up
+    // to this many bytes; 0 turns the cache off. Any change to the graph
+    // or its costs makes earlier results stop matching.
+    Q_PROPERTY(int pathCacheCapacity READ pathCacheCapacity WRITE setPathCacheCapacity NOTIFY pathCacheCapacityChanged)
+    // hits, misses, hitRate (0..1), entries, bytes and capacity
+    Q_PROPERTY(QVariantMap pathCacheStats READ pathCacheStats NOTIFY pathCacheStatsChanged)
 
 public:
     explicit PathfindingEngine(QObject *parent = nullptr);
+    ~PathfindingEngine();
+
+    bool busy() const { return !activeJobs.empty(); }
+    int randomSeed() const { return m_randomSeed; }
+    int islandCount() const { return m_islandCount; }
+    int ballRouteTimeBudget() const { return m_ballRouteTimeBudget; }
+    bool lastRouteProvenOptimal() const { return m_lastRouteProvenOptimal; }
+    RouteModel* route() const { return m_route; }
+    RouteModel* bestRoute() const { return m_bestRoute; }
+    QString arenaFile() const { return m_arenaFile; }
+    bool watchArenaFile() const { return m_watchArenaFile; }
+    QString pathSearch() const { return m_pathSearch; }
+    int pathCacheCapacity() const { return static_cast<int>(pathCache.capacity()); }
+    QVariantMap pathCacheStats() const;
+
+    void setRandomSeed(int seed);
+    void setIslandCount(int count);
+    void setBallRouteTimeBudget(int milliseconds);
+    void setWatchArenaFile(bool watch);
+    void setPathSearch(const QString& search);
+    void setPathCacheCapacity(int bytes);
 
     Q_INVOKABLE void setNodes(const QVariantList& nodes);
     Q_INVOKABLE void setConnections(const QVariantMap& connections);
-    Q_INVOKABLE QVariantList findPath(const QString& startNodeId, const QString& endNodeId);
+
+    // Connects every node from setNodes() to its k nearest neighbours
+    // instead of taking connections from QML. costModel is "elevation"
+    // (distance weighted by height difference) or "distance". Stays in
+    // effect for later setNodes() calls until setConnections() is used.
+    // Returns the number of edges.
+    Q_INVOKABLE int buildGraph(int neighbours = 6, const QString& costModel = QStringLiteral("elevation"));
+    // Current connections for drawing, as a flat list of x1, y1, x2, y2
+    // map coordinates; each passable pair of nodes appears once
+    Q_INVOKABLE QVariantList edgeSegments();
+
+    // Replaces nodes and connections with a binary arena file (see
+    // ArenaFile), e.g. one written by arena_convert. Connections built by
+    // buildGraph() are rebuilt the same way by later setNodes() calls. On
+    // failure the current graph stays and false is returned.
+    Q_INVOKABLE bool loadArena(const QString& path);
+    // Writes the current graph, run-time edits included. With includeTables
+    // the key distance table and the landmark costs are computed if needed
+    // and stored, so the next load plans without building them.
+    Q_INVOKABLE bool saveArena(const QString& path, bool includeTables = true);
+
+    // Node lookups in arena coordinates through the graph's spatial index;
+    // cost depends on the nodes near the query, not on the arena size.
+    // nodeAt returns the nearest node within radius, or an empty string.
+    // All three skip nodes removed at run time.
+    Q_INVOKABLE QString nodeAt(double x, double y, double radius) const;
+    Q_INVOKABLE QString nearestNode(double x, double y) const;
+    Q_INVOKABLE QStringList nodesInRect(double x, double y, double width, double height) const;
+    // Node fields by id, as in the lists returned by the planners
+    Q_INVOKABLE QVariantMap nodeData(const QString& nodeId);
+
+    // search overrides pathSearch for this call
+    Q_INVOKABLE QVariantList findPath(const QString& startNodeId, const QString& endNodeId,
+                                      const QString& search = QString());
     Q_INVOKABLE QVariantList findOptimalCollectionRoute(const QString& startNodeId, const QVariantList& targetNodes);
     Q_INVOKABLE QVariantList findOptimalBallCollectionRoute(const QString& startNodeId,
                                                 const QString& releaseNodeId,
@@ -72,43 +134,141 @@ public:
     Q_INVOKABLE double calculateRouteValue(const std::vector<QString>& route, const QString& releaseNodeId);
     Q_INVOKABLE void clearPath();
 
+    // Asynchronous versions of the planners above. They run on a worker
+    // thread against the graph as it was when the request was made and
+    // return a job id. A new request cancels any request still running;
+    // the result is stored in route, then planningFinished plus
+    // pathCalculated or optimalRouteCalculated are emitted.
+    Q_INVOKABLE int requestPath(const QString& startNodeId, const QString& endNodeId,
+                                const QString& search = QString());
+    Q_INVOKABLE int requestOptimalCollectionRoute(const QString& startNodeId, const QVariantList& targetNodes);
+    Q_INVOKABLE int requestOptimalBallCollectionRoute(const QString& startNodeId,
+                                                      const QString& releaseNodeId,
+                                                      int carryCapacity = 8);
+    Q_INVOKABLE void cancelRequest(int jobId);
+    Q_INVOKABLE void cancelAllRequests();
+
+    // Changes made during a run. They apply to every planner from the next
+    // request on without reloading the map; the incremental planner below
+    // picks them up immediately. A cost of Infinity blocks a passage;
+    // negative and NaN costs are rejected.
+    Q_INVOKABLE bool updateEdgeCost(const QString& fromNodeId, const QString& toNodeId, double cost);
+    Q_INVOKABLE bool removeNode(const QString& nodeId);
+    Q_INVOKABLE bool markCollected(const QString& nodeId);
+
+    // Shortest path from the car's current node to goalNodeId (or to the
+    // previous goal when empty), reusing the previous search: after a
+    // local change only the affected part of the graph is searched again.
+    Q_INVOKABLE QVariantList replanFrom(const QString& currentNodeId, const QString& goalNodeId = QString());
+    // Same, starting from the node nearest to the car's measured position
+    Q_INVOKABLE QVariantList replanFromPosition(double x, double y, const QString& goalNodeId = QString());
+
+    // The graph as planners see it now, including run-time edits; for map
+    // views, which re-read it on graphChanged
+    std::shared_ptr<const PlannerGraph> graphSnapshot() { return currentGraph(); }
+
 signals:
-    void pathCalculated(const QVariantList& path);
-    void optimalRouteCalculated(const QVariantList& route);
+    void pathCalculated();
+    void optimalRouteCalculated();
+
+    void graphChanged();
+    void busyChanged();
+    void randomSeedChanged();
+    void islandCountChanged();
+    void ballRouteTimeBudgetChanged();
+    void lastRouteProvenOptimalChanged();
+    void planningProgress(int jobId, int step, int totalSteps, double bestScore);
+    void bestRouteUpdated(int jobId);
+    void planningFinished(int jobId);
+    void planningCancelled(int jobId);
+    void arenaFileChanged();
+    void watchArenaFileChanged();
+    void pathSearchChanged();
+    void pathCacheCapacityChanged();
+    void pathCacheStatsChanged();
+    void arenaLoaded(const QString& path, int milliseconds);
 
 private:
-    std::unordered_map<QString, Node> nodes;
-    std::unordered_map<QString, std::vector<Connection>> connections;
-    std::mt19937 rng;
-
-    // A* Algorithm methods
-    double calculateHeuristic(const QString& nodeId1, const QString& nodeId2);
-    std::vector<QString> reconstructPath(const std::unordered_map<QString, QString>& cameFrom,
-                                         const QString& current);
-    QVariantList convertPathToVariantList(const std::vector<QString>& path);
-
-    // Genetic Algorithm methods
-    std::vector<Individual> initializePopulation(const QString& startNodeId,
-                                                 const std::vector<QString>& targets,
-                                                 int populationSize);
-    double calculateRouteFitness(const std::vector<QString>& route);
-    double calculateTotalDistance(const std::vector<QString>& route);
-    Individual crossover(const Individual& parent1, const Individual& parent2);
-    void mutate(Individual& individual, double mutationRate);
-    std::vector<Individual> selection(const std::vector<Individual>& population, int selectionSize);
-
-    // Helper methods
-    bool nodeExists(const QString& nodeId) const;
-    std::vector<QString> getShortestPathBetween(const QString& start, const QString& end);
-    std::vector<QString> getCollectibleBallNodes() const;
-    int calculateTotalPoints(const std::vector<QString>& nodes) const;
-
-    void generateCombinations(const std::vector<QString>& items,
-                              int size,
-                              std::vector<std::vector<QString>>& combinations);
-    double calculateSimpleRouteValue(const QString& startNodeId,
-                                     const std::vector<QString>& ballIds,
-                                     const QString& releaseNodeId);
-    QVariantList findSimpleCollectionRoute(const QString& startNodeId,
-                                           const QVariantList& ballsToCollect);
+    enum class JobKind { Path, Route };
+
+    struct PlannerJob {
+        int id = 0;
+        JobKind kind = JobKind::Route;
+        std::atomic<bool> cancelled{false};
+        bool cachesPath = false;    // Store the result in pathCache under pathKey
+        PathCache::Key pathKey{};
+    };
+
+    using JobFunction = std::function<std::vector<int>(RoutePlanner&, const PlannerControl&)>;
+
+    // Current graph snapshot; replaced, never modified, by setNodes/setConnections
+    std::shared_ptr<const PlannerGraph> plannerGraph;
+    // Copy of plannerGraph collecting run-time edits until a planner needs it
+    std::shared_ptr<PlannerGraph> editedGraph;
+    QVariantMap connectionData; // Last setConnections() input, re-resolved when nodes change
+    int builtNeighbours;        // Non-zero while connections come from buildGraph()
+    EdgeCostModel builtCostModel;
+    // Arena whose explicit connections setNodes() has to turn back into
+    // connectionData; kept as loaded, without run-time edits
+    std::shared_ptr<const PlannerGraph> arenaConnections;
+    std::mt19937 rng;           // Seeds the per-call planners
+    // A* buffers shared by the synchronous findPath() calls, which all run
+    // on the engine's thread; jobs bring their own. The reverse one serves
+    // the backward half of bidirectional searches.
+    std::shared_ptr<SearchScratch> searchScratch;
+    std::shared_ptr<SearchScratch> reverseSearchScratch;
+    // Set to abandon the hierarchy build of a graph that has been replaced
+    std::shared_ptr<std::atomic<bool>> hierarchyBuildCancelled;
+    std::weak_ptr<const PlannerGraph> hierarchyBuildGraph;
+    std::weak_ptr<const PlannerGraph> landmarkBuildGraph;   // Last snapshot whose landmarks were queued
+    int m_randomSeed;
+    int m_islandCount;
+    int m_ballRouteTimeBudget;
+    bool m_lastRouteProvenOptimal;
+    RouteModel* m_route;
+    RouteModel* m_bestRoute;
+    QString m_arenaFile;
+    bool m_watchArenaFile;
+    QString m_pathSearch;
+    PathCache pathCache;
+    // Bumped by every change that can alter a path or its cost, and by
+    // every change of where edge costs come from; part of each cache key
+    std::uint64_t graphVersion;
+    std::uint64_t costModelVersion;
+    QFileSystemWatcher* arenaWatcher;
+    QTimer* arenaReloadTimer;   // Coalesces the several change events of one save
+
+    // D* Lite state for replanFrom, tied to the snapshot it was started on
+    IncrementalPlanner replanner;
+    std::shared_ptr<const PlannerGraph> replanGraph;
+
+    QThreadPool* threadPool;
+    std::unordered_map<int, std::shared_ptr<PlannerJob>> activeJobs;
+    int lastJobId;
+
+    std::shared_ptr<const PlannerGraph> currentGraph();
+    PlannerGraph& editableGraph();
+    // The graph with every run-time edit, published or not
+    const PlannerGraph& latestGraph() const { return editedGraph ? *editedGraph : *plannerGraph; }
+    void resetReplanner();
+    bool toPathSearch(const QString& name, PathSearch& search) const;
+    void preparePathSearch();
+    void buildLandmarks(const std::shared_ptr<const PlannerGraph>& snapshot);
+    // The search findPath() will actually run on the snapshot: plain A*
+    // while the requested one's tables are still missing
+    PathSearch availableSearch(PathSearch search, const std::shared_ptr<const PlannerGraph>& snapshot);
+    PathCache::Key pathKey(int startNode, int endNode, PathSearch search) const;
+    void setArenaFile(const QString& path);
+    void watchArena();
+    void reloadArena();
+    unsigned int nextSeed();
+    GeneticSettings geneticSettings() const;
+    PrizeRouteSettings prizeRouteSettings() const;
+    int startJob(JobKind kind, JobFunction work, const PathCache::Key* cacheKey = nullptr);
+    void finishJob(int jobId,
+                   std::shared_ptr<const PlannerGraph> snapshot,
+                   std::vector<int> route,
+                   bool provenOptimal);
+    void setLastRouteProvenOptimal(bool provenOptimal);
+    std::vector<int> toNodeIndices(const QVariantList& nodeIds) const;
 };
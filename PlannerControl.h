@@ -0,0 +1,23 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Hooks for long-running planners. Callbacks are invoked on the thread the
+// planner runs on; a planner that sees the cancel flag returns an empty route.
+struct PlannerControl {
+    const std::atomic<bool>* cancelled = nullptr;
+    std::function<void(int step, int totalSteps, double bestScore)> progress;
+    std::function<void(const std::vector<int>& route)> bestRoute;
+
+    bool isCancelled() const { return cancelled && cancelled->load(std::memory_order_relaxed); }
+    void reportProgress(int step, int totalSteps, double bestScore) const
+    {
+        if (progress) progress(step, totalSteps, bestScore);
+    }
+    void reportBestRoute(const std::vector<int>& route) const
+    {
+        if (bestRoute) bestRoute(route);
+    }
+};
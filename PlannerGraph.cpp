@@ -0,0 +1,269 @@
+#include "PlannerGraph.h"
+#include "Logging.h"
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+
+NodeKind nodeKindFromType(const QString& type)
+{
+    if (type == "keystone") return NodeKind::Keystone;
+    if (type == "start_a") return NodeKind::StartA;
+    if (type == "start_b") return NodeKind::StartB;
+    if (type == "release") return NodeKind::Release;
+    if (type == "green_ball") return NodeKind::GreenBall;
+    if (type == "black_striped_ball") return NodeKind::BlackStripedBall;
+    if (type == "star_ball") return NodeKind::StarBall;
+    if (type == "comm_tow") return NodeKind::CommTower;
+    return NodeKind::Other;
+}
+
+} // namespace
+
+void PlannerGraph::loadNodes(const QVariantList& nodeList)
+{
+    graph.clear();
+    nodeIds.clear();
+    nodeTypes.clear();
+    nodeIndex.clear();
+
+    graph.resizeNodes(nodeList.size());
+    nodeIds.reserve(nodeList.size());
+    nodeTypes.reserve(nodeList.size());
+
+    int count = 0;
+    for (const QVariant& nodeVariant : nodeList) {
+        QVariantMap nodeMap = nodeVariant.toMap();
+
+        QString elementId = nodeMap["elementId"].toString();
+        QString type = nodeMap["type"].toString();
+
+        // Later duplicates overwrite earlier ones, as the old map did
+        auto [it, inserted] = nodeIndex.emplace(elementId, count);
+        int index = it->second;
+        if (inserted) {
+            nodeIds.push_back(elementId);
+            nodeTypes.push_back(type);
+            ++count;
+        } else {
+            nodeTypes[index] = type;
+        }
+
+        graph.x[index] = nodeMap["x"].toDouble();
+        graph.y[index] = nodeMap["y"].toDouble();
+        graph.elevation[index] = nodeMap["elevation"].toDouble();
+        graph.points[index] = nodeMap["points"].toInt();
+        graph.kind[index] = nodeKindFromType(type);
+    }
+
+    graph.resizeNodes(count);
+    spatialIndex.build(graph.x, graph.y);
+}
+
+void PlannerGraph::copyNodesFrom(const PlannerGraph& other)
+{
+    graph.x = other.graph.x;
+    graph.y = other.graph.y;
+    graph.elevation = other.graph.elevation;
+    graph.points = other.graph.points;
+    graph.kind = other.graph.kind;
+    graph.clearEdges();
+
+    nodeIds = other.nodeIds;
+    nodeTypes = other.nodeTypes;
+    nodeIndex = other.nodeIndex;
+    spatialIndex = other.spatialIndex;
+}
+
+void PlannerGraph::copyFrom(const PlannerGraph& other)
+{
+    graph = other.graph;
+    nodeIds = other.nodeIds;
+    nodeTypes = other.nodeTypes;
+    nodeIndex = other.nodeIndex;
+    spatialIndex = other.spatialIndex;
+    removedNodes = other.removedNodes;
+}
+
+void PlannerGraph::loadConnections(const QVariantMap& connectionMap)
+{
+    std::vector<NavGraph::EdgeInput> edges;
+
+    for (auto it = connectionMap.begin(); it != connectionMap.end(); ++it) {
+        int source = indexOf(it.key());
+        if (source < 0) {
+            continue;
+        }
+
+        const QVariantList connectionList = it.value().toList();
+        for (const QVariant& connectionVariant : connectionList) {
+            QVariantMap connMap = connectionVariant.toMap();
+
+            // Connections to nodes we don't know about can never be part of a path
+            int target = indexOf(connMap["targetId"].toString());
+            if (target < 0) {
+                continue;
+            }
+
+            edges.push_back({source, target,
+                             connMap["cost"].toDouble(),
+                             connMap["distance"].toDouble()});
+        }
+    }
+
+    graph.setEdges(edges);
+}
+
+void PlannerGraph::buildNearestNeighbours(int neighbours, EdgeCostModel costModel)
+{
+    std::vector<NavGraph::EdgeInput> edges;
+    edges.reserve(static_cast<size_t>(graph.nodeCount()) * std::max(0, neighbours));
+    std::vector<SpatialGrid::Neighbour> nearest;
+
+    for (int source = 0; source < graph.nodeCount(); ++source) {
+        spatialIndex.nearest(graph.x[source], graph.y[source], neighbours, source, nearest);
+
+        for (const auto& [distance, target] : nearest) {
+            double cost = distance;
+            if (costModel == EdgeCostModel::Elevation) {
+                double heightDiff = std::fabs(graph.elevation[source] - graph.elevation[target]);
+                cost = distance * (1 + heightDiff / 50);
+            }
+            edges.push_back({source, target, cost, distance});
+        }
+    }
+
+    graph.setEdges(edges);
+}
+
+int PlannerGraph::indexOf(const QString& nodeId) const
+{
+    auto it = nodeIndex.find(nodeId);
+    return it != nodeIndex.end() ? it->second : -1;
+}
+
+QVariantMap PlannerGraph::nodeToVariantMap(int node) const
+{
+    QVariantMap nodeData;
+    nodeData["elementId"] = nodeIds[node];
+    nodeData["x"] = graph.x[node];
+    nodeData["y"] = graph.y[node];
+    nodeData["elevation"] = graph.elevation[node];
+    nodeData["type"] = nodeTypes[node];
+    nodeData["points"] = graph.points[node];
+    return nodeData;
+}
+
+QVariantList PlannerGraph::toVariantList(const std::vector<int>& path) const
+{
+    QVariantList result;
+    result.reserve(path.size());
+
+    for (int node : path) {
+        result.append(nodeToVariantMap(node));
+    }
+
+    return result;
+}
+
+std::shared_ptr<const DistanceTable> PlannerGraph::keyDistances(const std::vector<int>& extraNodes) const
+{
+    QMutexLocker locker(&distanceMutex);
+
+    if (!distanceTable) {
+        std::vector<int> keyNodes = defaultKeyNodes();
+        keyNodes.insert(keyNodes.end(), extraNodes.begin(), extraNodes.end());
+
+        auto table = std::make_shared<DistanceTable>();
+        table->build(graph, keyNodes);
+        distanceTable = table;
+        qCDebug(lcPlanner) << "Built distance table for" << table->keyCount() << "key nodes";
+        return distanceTable;
+    }
+
+    for (int node : extraNodes) {
+        if (!distanceTable->containsNode(node)) {
+            auto table = std::make_shared<DistanceTable>(*distanceTable);
+            table->addKeys(graph, extraNodes);
+            distanceTable = table;
+            qCDebug(lcPlanner) << "Extended distance table to" << table->keyCount() << "key nodes";
+            break;
+        }
+    }
+
+    return distanceTable;
+}
+
+void PlannerGraph::setKeyDistances(std::shared_ptr<const DistanceTable> table)
+{
+    QMutexLocker locker(&distanceMutex);
+    distanceTable = std::move(table);
+}
+
+std::vector<int> PlannerGraph::defaultKeyNodes() const
+{
+    std::vector<int> keyNodes;
+    for (int node = 0; node < graph.nodeCount(); ++node) {
+        NodeKind kind = graph.kind[node];
+        if (kind == NodeKind::StartA || kind == NodeKind::StartB ||
+            kind == NodeKind::Release || isCollectibleKind(kind)) {
+            keyNodes.push_back(node);
+        }
+    }
+    return keyNodes;
+}
+
+std::shared_ptr<const Landmarks> PlannerGraph::landmarks() const
+{
+    QMutexLocker locker(&landmarkMutex);
+
+    if (!landmarkTable) {
+        auto table = std::make_shared<Landmarks>();
+        table->build(graph, LandmarkCount);
+        landmarkTable = table;
+        qCDebug(lcPlanner) << "Built" << table->count() << "landmarks for" << graph.nodeCount() << "nodes";
+    }
+    return landmarkTable;
+}
+
+std::shared_ptr<const Landmarks> PlannerGraph::builtLandmarks() const
+{
+    QMutexLocker locker(&landmarkMutex);
+    return landmarkTable;
+}
+
+void PlannerGraph::setLandmarks(std::shared_ptr<const Landmarks> table)
+{
+    QMutexLocker locker(&landmarkMutex);
+    landmarkTable = std::move(table);
+}
+
+std::shared_ptr<const ContractionHierarchy> PlannerGraph::hierarchy(const std::atomic<bool>* cancelled) const
+{
+    QMutexLocker buildLocker(&hierarchyBuildMutex);
+    std::shared_ptr<const ContractionHierarchy> table = builtHierarchy();
+    if (table) {
+        return table;
+    }
+
+    auto built = std::make_shared<ContractionHierarchy>();
+    if (!built->build(graph, cancelled)) {
+        return nullptr;
+    }
+    qCDebug(lcPlanner) << "Built hierarchy with" << built->shortcutCount() << "shortcuts for" << graph.nodeCount() << "nodes";
+    QMutexLocker locker(&hierarchyMutex);
+    hierarchyTable = built;
+    return built;
+}
+
+std::shared_ptr<const ContractionHierarchy> PlannerGraph::builtHierarchy() const
+{
+    QMutexLocker locker(&hierarchyMutex);
+    return hierarchyTable;
+}
+
+void PlannerGraph::setHierarchy(std::shared_ptr<const ContractionHierarchy> table)
+{
+    QMutexLocker locker(&hierarchyMutex);
+    hierarchyTable = std::move(table);
+}
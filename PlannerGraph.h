@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "NavGraph.h"
+#include "DistanceTable.h"
+#include "Landmarks.h"
+#include "ContractionHierarchy.h"
+#include "SpatialGrid.h"
+
+// How buildNearestNeighbours prices an edge
+enum class EdgeCostModel {
+    Distance,   // Plain straight-line distance
+    Elevation   // Distance * (1 + height difference / 50), as the QML map used
+};
+
+// Graph snapshot shared between PathfindingEngine and its planner jobs.
+// Once published it is never modified: setNodes/setConnections build a new
+// snapshot, so a job still running on a worker thread keeps planning on
+// the graph it started with while the map is replaced underneath it.
+class PlannerGraph
+{
+public:
+    NavGraph graph;
+    std::vector<QString> nodeIds;
+    std::vector<QString> nodeTypes;
+    std::unordered_map<QString, int> nodeIndex;
+    SpatialGrid spatialIndex;   // Node positions, for hit tests and k-NN
+    // Nodes taken out at run time (PathfindingEngine::removeNode); they
+    // keep their index and their edges are blocked. Empty until the first
+    // removal.
+    std::vector<char> removedNodes;
+
+    // Construction, only used before the snapshot is shared
+    void loadNodes(const QVariantList& nodeList);
+    void copyNodesFrom(const PlannerGraph& other);
+    void copyFrom(const PlannerGraph& other); // Nodes, edges and removals, not the distance table
+    void loadConnections(const QVariantMap& connectionMap);
+    // Connects every node to its k nearest nodes, replacing all edges
+    void buildNearestNeighbours(int neighbours, EdgeCostModel costModel);
+
+    int indexOf(const QString& nodeId) const;
+    bool isRemoved(int node) const { return node < static_cast<int>(removedNodes.size()) && removedNodes[node]; }
+    QVariantMap nodeToVariantMap(int node) const;
+    QVariantList toVariantList(const std::vector<int>& path) const;
+
+    // Key-node distance table, built on first use. Thread-safe: asking for
+    // nodes that are not covered yet publishes an extended copy, so tables
+    // already handed out stay valid.
+    std::shared_ptr<const DistanceTable> keyDistances(const std::vector<int>& extraNodes = std::vector<int>()) const;
+    // A table computed earlier for this graph, e.g. stored in an arena file
+    void setKeyDistances(std::shared_ptr<const DistanceTable> table);
+    // Which nodes keyDistances() covers by default
+    std::vector<int> defaultKeyNodes() const;
+
+    // Landmark distances for ALT search, built on first use. Thread-safe;
+    // a caller arriving while another thread builds them waits for it.
+    std::shared_ptr<const Landmarks> landmarks() const;
+    // The table if it has been built or set, without building it
+    std::shared_ptr<const Landmarks> builtLandmarks() const;
+    // Landmarks computed earlier, e.g. stored in an arena file or taken
+    // over from the snapshot this one was copied from
+    void setLandmarks(std::shared_ptr<const Landmarks> table);
+    // 32 halve the expansions of 16 on large arenas, for 0.5 KB per node
+    static constexpr int LandmarkCount = 32;
+
+    // Contraction hierarchy, built on first use. That takes seconds on
+    // large arenas, so it belongs on a worker thread; queries go through
+    // builtHierarchy(), which never waits for a build. Null if cancelled
+    // was set before the build finished.
+    std::shared_ptr<const ContractionHierarchy> hierarchy(const std::atomic<bool>* cancelled = nullptr) const;
+    std::shared_ptr<const ContractionHierarchy> builtHierarchy() const;
+    void setHierarchy(std::shared_ptr<const ContractionHierarchy> table);
+
+private:
+    mutable QMutex distanceMutex;
+    mutable std::shared_ptr<const DistanceTable> distanceTable;
+    mutable QMutex landmarkMutex;
+    mutable std::shared_ptr<const Landmarks> landmarkTable;
+    mutable QMutex hierarchyBuildMutex;    // Held for a whole build
+    mutable QMutex hierarchyMutex;         // Held only to read or swap the pointer
+    mutable std::shared_ptr<const ContractionHierarchy> hierarchyTable;
+};
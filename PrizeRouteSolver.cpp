@@ -0,0 +1,353 @@
+#include "PrizeRouteSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+PrizeRouteSolver::PrizeRouteSolver(const PrizeRouteSettings& settings)
+    : settings(settings)
+    , costMatrix(nullptr)
+    , ballPoints(nullptr)
+    , ballCount(0)
+    , stride(0)
+    , capacity(0)
+{}
+
+std::vector<int> PrizeRouteSolver::solve(const std::vector<double>& costs,
+                                         const std::vector<int>& points,
+                                         int ballCount,
+                                         int capacity,
+                                         unsigned int seed,
+                                         const PlannerControl& control,
+                                         const ImprovedCallback& improved)
+{
+    best = Solution();
+    if (ballCount <= 0 || capacity <= 0) {
+        return std::vector<int>();
+    }
+
+    costMatrix = costs.data();
+    ballPoints = points.data();
+    this->ballCount = ballCount;
+    this->capacity = capacity;
+    stride = ballCount + 2;
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point started = Clock::now();
+    const bool timed = settings.timeBudgetMs > 0;
+    const double budgetMs = std::max(1, settings.timeBudgetMs);
+    const int maxIterations = std::max(1, settings.maxIterations);
+
+    std::mt19937 rng(seed);
+
+    // Greedy start: local search from the empty route only ever adds balls
+    Solution current;
+    std::vector<char> selected(ballCount, 0);
+    improve(current, selected);
+
+    best = current;
+    std::vector<char> bestSelected = selected;
+    if (improved && best.value() > 0.0) {
+        improved(stops(best), best.value());
+    }
+
+    for (int iteration = 0; iteration < maxIterations; ++iteration) {
+        if (control.isCancelled()) {
+            return std::vector<int>();
+        }
+
+        const double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        if (timed && elapsedMs >= budgetMs) {
+            break;
+        }
+
+        if (iteration % 16 == 0) {
+            // Whichever limit is closer decides how far along we are
+            int step = static_cast<int>(std::max(1000.0 * iteration / maxIterations,
+                                                 timed ? 1000.0 * elapsedMs / budgetMs : 0.0));
+            control.reportProgress(std::min(step, 999), 1000, best.value());
+        }
+
+        Solution candidate = current;
+        std::vector<char> candidateSelected = selected;
+        perturb(candidate, candidateSelected, rng);
+        improve(candidate, candidateSelected);
+
+        if (isBetter(candidate.points, candidate.cost, best)) {
+            best = candidate;
+            bestSelected = candidateSelected;
+            if (improved) {
+                improved(stops(best), best.value());
+            }
+        }
+
+        // Keep walking from an improvement, otherwise restart from the best
+        if (isBetter(candidate.points, candidate.cost, current)) {
+            current = candidate;
+            selected = candidateSelected;
+        } else {
+            current = best;
+            selected = bestSelected;
+        }
+    }
+
+    control.reportProgress(1000, 1000, best.value());
+
+    if (best.value() <= 0.0) {
+        return std::vector<int>();
+    }
+
+    return stops(best);
+}
+
+void PrizeRouteSolver::evaluate(Solution& solution) const
+{
+    solution.points = 0;
+    solution.cost = 0.0;
+
+    for (int t = 0; t < static_cast<int>(solution.trips.size()); ++t) {
+        int previous = tripOrigin(t);
+        for (int ball : solution.trips[t]) {
+            solution.points += ballPoints[ball];
+            solution.cost += cost(previous, ball);
+            previous = ball;
+        }
+        solution.cost += cost(previous, releaseStop());
+    }
+}
+
+bool PrizeRouteSolver::isBetter(int points, double cost, const Solution& than) const
+{
+    if (!(cost > 0.0) || !std::isfinite(cost)) {
+        return false;
+    }
+
+    return points / cost > than.value() + 1e-12;
+}
+
+bool PrizeRouteSolver::cheapestInsertion(const Solution& solution, int ball, int& trip, int& position, double& delta) const
+{
+    delta = std::numeric_limits<double>::infinity();
+    const int tripCount = static_cast<int>(solution.trips.size());
+
+    for (int t = 0; t < tripCount; ++t) {
+        const std::vector<int>& stops = solution.trips[t];
+        if (static_cast<int>(stops.size()) >= capacity) {
+            continue;
+        }
+
+        for (int p = 0; p <= static_cast<int>(stops.size()); ++p) {
+            int before = p == 0 ? tripOrigin(t) : stops[p - 1];
+            int after = p == static_cast<int>(stops.size()) ? releaseStop() : stops[p];
+            double d = cost(before, ball) + cost(ball, after) - cost(before, after);
+            if (std::isfinite(d) && d < delta) {
+                delta = d;
+                trip = t;
+                position = p;
+            }
+        }
+    }
+
+    // Or a new trip at the end
+    int origin = tripCount == 0 ? startStop() : releaseStop();
+    double d = cost(origin, ball) + cost(ball, releaseStop());
+    if (std::isfinite(d) && d < delta) {
+        delta = d;
+        trip = tripCount;
+        position = 0;
+    }
+
+    return std::isfinite(delta);
+}
+
+void PrizeRouteSolver::insertBall(Solution& solution, int ball, int trip, int position) const
+{
+    if (trip == static_cast<int>(solution.trips.size())) {
+        solution.trips.emplace_back();
+    }
+
+    std::vector<int>& stops = solution.trips[trip];
+    stops.insert(stops.begin() + position, ball);
+    evaluate(solution);
+}
+
+void PrizeRouteSolver::removeBall(Solution& solution, int trip, int position) const
+{
+    std::vector<int>& stops = solution.trips[trip];
+    stops.erase(stops.begin() + position);
+    if (stops.empty()) {
+        solution.trips.erase(solution.trips.begin() + trip);
+    }
+    evaluate(solution);
+}
+
+bool PrizeRouteSolver::tryAdd(Solution& solution, std::vector<char>& selected) const
+{
+    for (int ball = 0; ball < ballCount; ++ball) {
+        if (selected[ball] || ballPoints[ball] <= 0) {
+            continue;
+        }
+
+        int trip = 0;
+        int position = 0;
+        double delta = 0.0;
+        if (cheapestInsertion(solution, ball, trip, position, delta) &&
+            isBetter(solution.points + ballPoints[ball], solution.cost + delta, solution)) {
+            insertBall(solution, ball, trip, position);
+            selected[ball] = 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PrizeRouteSolver::tryRemove(Solution& solution, std::vector<char>& selected) const
+{
+    for (int t = 0; t < static_cast<int>(solution.trips.size()); ++t) {
+        for (int p = 0; p < static_cast<int>(solution.trips[t].size()); ++p) {
+            Solution candidate = solution;
+            removeBall(candidate, t, p);
+
+            if (isBetter(candidate.points, candidate.cost, solution)) {
+                selected[solution.trips[t][p]] = 0;
+                solution = candidate;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool PrizeRouteSolver::trySwap(Solution& solution, std::vector<char>& selected) const
+{
+    for (int t = 0; t < static_cast<int>(solution.trips.size()); ++t) {
+        std::vector<int>& stops = solution.trips[t];
+
+        for (int p = 0; p < static_cast<int>(stops.size()); ++p) {
+            const int current = stops[p];
+            int before = p == 0 ? tripOrigin(t) : stops[p - 1];
+            int after = p + 1 == static_cast<int>(stops.size()) ? releaseStop() : stops[p + 1];
+            const double removed = cost(before, current) + cost(current, after);
+
+            for (int ball = 0; ball < ballCount; ++ball) {
+                if (selected[ball] || ballPoints[ball] <= 0) {
+                    continue;
+                }
+
+                double delta = cost(before, ball) + cost(ball, after) - removed;
+                if (std::isfinite(delta) &&
+                    isBetter(solution.points - ballPoints[current] + ballPoints[ball], solution.cost + delta, solution)) {
+                    stops[p] = ball;
+                    selected[current] = 0;
+                    selected[ball] = 1;
+                    evaluate(solution);
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+bool PrizeRouteSolver::tryRelocate(Solution& solution) const
+{
+    for (int t = 0; t < static_cast<int>(solution.trips.size()); ++t) {
+        for (int p = 0; p < static_cast<int>(solution.trips[t].size()); ++p) {
+            const int ball = solution.trips[t][p];
+
+            Solution candidate = solution;
+            removeBall(candidate, t, p);
+
+            int trip = 0;
+            int position = 0;
+            double delta = 0.0;
+            if (cheapestInsertion(candidate, ball, trip, position, delta) &&
+                candidate.cost + delta < solution.cost - 1e-9) {
+                insertBall(candidate, ball, trip, position);
+                solution = candidate;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool PrizeRouteSolver::tryReverse(Solution& solution) const
+{
+    // 2-opt inside a trip; costs need not be symmetric, so re-evaluate
+    for (int t = 0; t < static_cast<int>(solution.trips.size()); ++t) {
+        const int size = static_cast<int>(solution.trips[t].size());
+
+        for (int i = 0; i + 1 < size; ++i) {
+            for (int j = i + 1; j < size; ++j) {
+                Solution candidate = solution;
+                std::vector<int>& stops = candidate.trips[t];
+                std::reverse(stops.begin() + i, stops.begin() + j + 1);
+                evaluate(candidate);
+
+                if (candidate.cost < solution.cost - 1e-9) {
+                    solution = candidate;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void PrizeRouteSolver::improve(Solution& solution, std::vector<char>& selected) const
+{
+    // Every move strictly improves the ratio, so this terminates
+    while (tryRelocate(solution) ||
+           tryReverse(solution) ||
+           trySwap(solution, selected) ||
+           tryAdd(solution, selected) ||
+           tryRemove(solution, selected)) {
+    }
+}
+
+void PrizeRouteSolver::perturb(Solution& solution, std::vector<char>& selected, std::mt19937& rng) const
+{
+    const int strength = 1 + static_cast<int>(rng() % 3);
+
+    // Drop a few random balls...
+    for (int i = 0; i < strength && !solution.trips.empty(); ++i) {
+        int t = rng() % solution.trips.size();
+        int p = rng() % solution.trips[t].size();
+        selected[solution.trips[t][p]] = 0;
+        removeBall(solution, t, p);
+    }
+
+    // ...and force in a few random ones, even if they make the route worse
+    for (int i = 0; i < strength; ++i) {
+        int ball = rng() % ballCount;
+        if (selected[ball] || ballPoints[ball] <= 0) {
+            continue;
+        }
+
+        int trip = 0;
+        int position = 0;
+        double delta = 0.0;
+        if (cheapestInsertion(solution, ball, trip, position, delta)) {
+            insertBall(solution, ball, trip, position);
+            selected[ball] = 1;
+        }
+    }
+}
+
+std::vector<int> PrizeRouteSolver::stops(const Solution& solution) const
+{
+    std::vector<int> result;
+
+    for (const std::vector<int>& trip : solution.trips) {
+        result.insert(result.end(), trip.begin(), trip.end());
+        result.push_back(releaseStop());
+    }
+
+    return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <functional>
+#include <random>
+#include <vector>
+#include "PlannerControl.h"
+
+// Search limits for findOptimalBallCollectionRoute. The search stops at
+// whichever comes first; with a fixed seed it is repeatable as long as the
+// iteration limit is what ends it. A time budget of 0 leaves only the
+// iteration limit.
+struct PrizeRouteSettings {
+    int timeBudgetMs = 200;
+    int maxIterations = 20000;
+};
+
+// Capacitated prize-collecting route search: picks which balls to collect,
+// splits them into trips of at most capacity balls that each end at the
+// release area, and orders every trip, maximising points per path cost.
+//
+// Iterated local search: starting from an empty route it adds, removes,
+// swaps and reorders balls while that improves the ratio, then perturbs
+// the best route found so far and repeats. The best route is always
+// available, so the search can stop at any time.
+//
+// Costs are (ballCount + 2)^2, row-major: the balls, then the start, then
+// the release area.
+class PrizeRouteSolver
+{
+public:
+    // Called with the stops of the new best route whenever it improves
+    using ImprovedCallback = std::function<void(const std::vector<int>& stops, double value)>;
+
+    explicit PrizeRouteSolver(const PrizeRouteSettings& settings);
+
+    // Returns the stops of the best route, ball indices with releaseStop()
+    // after every trip, or an empty vector if nothing is worth collecting
+    // or the search was cancelled.
+    std::vector<int> solve(const std::vector<double>& costs,
+                           const std::vector<int>& points,
+                           int ballCount,
+                           int capacity,
+                           unsigned int seed,
+                           const PlannerControl& control = PlannerControl(),
+                           const ImprovedCallback& improved = ImprovedCallback());
+
+    int releaseStop() const { return ballCount + 1; }
+    double bestValue() const { return best.value(); }
+
+private:
+    struct Solution {
+        std::vector<std::vector<int>> trips;
+        int points = 0;
+        double cost = 0.0;
+
+        double value() const { return cost > 0.0 ? points / cost : 0.0; }
+    };
+
+    PrizeRouteSettings settings;
+    const double* costMatrix;
+    const int* ballPoints;
+    int ballCount;
+    int stride;
+    int capacity;
+    Solution best;
+
+    double cost(int from, int to) const { return costMatrix[from * stride + to]; }
+    int startStop() const { return ballCount; }
+    int tripOrigin(int trip) const { return trip == 0 ? startStop() : releaseStop(); }
+    void evaluate(Solution& solution) const;
+
+    bool isBetter(int points, double cost, const Solution& than) const;
+    bool cheapestInsertion(const Solution& solution, int ball, int& trip, int& position, double& delta) const;
+    void insertBall(Solution& solution, int ball, int trip, int position) const;
+    void removeBall(Solution& solution, int trip, int position) const;
+
+    // Local search moves, each applies the first improving change it finds
+    bool tryAdd(Solution& solution, std::vector<char>& selected) const;
+    bool tryRemove(Solution& solution, std::vector<char>& selected) const;
+    bool trySwap(Solution& solution, std::vector<char>& selected) const;
+    bool tryRelocate(Solution& solution) const;
+    bool tryReverse(Solution& solution) const;
+    void improve(Solution& solution, std::vector<char>& selected) const;
+    void perturb(Solution& solution, std::vector<char>& selected, std::mt19937& rng) const;
+
+    std::vector<int> stops(const Solution& solution) const;
+};
@@ -0,0 +1,115 @@
+#include "RouteModel.h"
+#include <algorithm>
+
+RouteModel::RouteModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int RouteModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant RouteModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= count()) {
+        return QVariant();
+    }
+
+    const int node = route[index.row()];
+    switch (role) {
+    case ElementIdRole:
+    case Qt::DisplayRole:
+        return graph->nodeIds[node];
+    case XRole:
+        return graph->graph.x[node];
+    case YRole:
+        return graph->graph.y[node];
+    case ElevationRole:
+        return graph->graph.elevation[node];
+    case TypeRole:
+        return graph->nodeTypes[node];
+    case PointsRole:
+        return graph->graph.points[node];
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> RouteModel::roleNames() const
+{
+    return {
+        {ElementIdRole, "elementId"},
+        {XRole, "x"},
+        {YRole, "y"},
+        {ElevationRole, "elevation"},
+        {TypeRole, "type"},
+        {PointsRole, "points"}
+    };
+}
+
+int RouteModel::totalPoints() const
+{
+    int total = 0;
+    for (int node : route) {
+        total += graph->graph.points[node];
+    }
+    return total;
+}
+
+void RouteModel::setRoute(std::shared_ptr<const PlannerGraph> snapshot, std::vector<int> nodes)
+{
+    beginResetModel();
+    graph = std::move(snapshot);
+    route = std::move(nodes);
+    endResetModel();
+    emit routeChanged();
+}
+
+void RouteModel::clear()
+{
+    if (route.empty()) {
+        return;
+    }
+
+    beginResetModel();
+    route.clear();
+    endResetModel();
+    emit routeChanged();
+}
+
+bool RouteModel::appendNode(const QString& elementId)
+{
+    const int node = graph ? graph->indexOf(elementId) : -1;
+    if (node < 0) {
+        return false;
+    }
+
+    beginInsertRows(QModelIndex(), count(), count());
+    route.push_back(node);
+    endInsertRows();
+    emit routeChanged();
+    return true;
+}
+
+bool RouteModel::containsNode(const QString& elementId) const
+{
+    const int node = graph ? graph->indexOf(elementId) : -1;
+    return node >= 0 && std::find(route.begin(), route.end(), node) != route.end();
+}
+
+QString RouteModel::elementIdAt(int row) const
+{
+    return row >= 0 && row < count() ? graph->nodeIds[route[row]] : QString();
+}
+
+QVariantList RouteModel::polyline() const
+{
+    QVariantList coordinates;
+    coordinates.reserve(route.size() * 2);
+    for (int node : route) {
+        coordinates << graph->graph.x[node] << graph->graph.y[node];
+    }
+    return coordinates;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QVariantList>
+#include <memory>
+#include <vector>
+#include "PlannerGraph.h"
+
+// A planned route as a list model: the node indices a planner returned plus
+// the graph snapshot they index into. Node data is read from the snapshot
+// on demand, so publishing a route copies no per-node maps or strings.
+class RouteModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int count READ count NOTIFY routeChanged)
+    Q_PROPERTY(int totalPoints READ totalPoints NOTIFY routeChanged)
+
+public:
+    enum Role {
+        ElementIdRole = Qt::UserRole + 1,
+        XRole,
+        YRole,
+        ElevationRole,
+        TypeRole,
+        PointsRole
+    };
+
+    explicit RouteModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const { return static_cast<int>(route.size()); }
+    int totalPoints() const;
+
+    const std::vector<int>& nodes() const { return route; }
+    const std::shared_ptr<const PlannerGraph>& snapshot() const { return graph; }
+    void setRoute(std::shared_ptr<const PlannerGraph> snapshot, std::vector<int> nodes);
+
+    Q_INVOKABLE void clear();
+    // Appends a node of the route's graph, e.g. the release area after a
+    // collection route. False if the id is unknown.
+    Q_INVOKABLE bool appendNode(const QString& elementId);
+    Q_INVOKABLE bool containsNode(const QString& elementId) const;
+    Q_INVOKABLE QString elementIdAt(int row) const;
+    // Node positions as a flat x1, y1, x2, y2, ... list for drawing
+    Q_INVOKABLE QVariantList polyline() const;
+
+signals:
+    void routeChanged();
+
+private:
+    std::shared_ptr<const PlannerGraph> graph;
+    std::vector<int> route;
+};
@@ -0,0 +1,435 @@
+#include "RoutePlanner.h"
+#include "Logging.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+RoutePlanner::RoutePlanner(std::shared_ptr<const PlannerGraph> snapshot, unsigned int seed)
+    : snapshot(std::move(snapshot)), graph(this->snapshot->graph), seed(seed), routeProvenOptimal(false), expansions(0)
+{}
+
+std::vector<int> RoutePlanner::findPath(int startNode, int endNode, PathSearch search)
+{
+    if (!scratch) {
+        scratch = std::make_shared<SearchScratch>();
+    }
+
+    if (search != PathSearch::AStar && search != PathSearch::Landmarks && !reverseScratch) {
+        reverseScratch = std::make_shared<SearchScratch>();
+    }
+
+    if (search == PathSearch::Hierarchy) {
+        hierarchy = snapshot->builtHierarchy();
+        if (hierarchy) {
+            return hierarchy->findPath(startNode, endNode, *scratch, *reverseScratch, expansions);
+        }
+        search = PathSearch::AStar;
+    }
+
+    if (search != PathSearch::AStar) {
+        landmarks = snapshot->builtLandmarks();
+        if (!landmarks) {
+            search = PathSearch::AStar;
+        }
+    }
+
+    if (search == PathSearch::AStar) {
+        return aStar(startNode, endNode, [this, endNode](int node) { return graph.heuristic(node, endNode); });
+    }
+
+    if (search == PathSearch::Bidirectional) {
+        return bidirectionalSearch(startNode, endNode, *landmarks);
+    }
+
+    const Landmarks& table = *landmarks;
+    return aStar(startNode, endNode, [&table, endNode](int node) { return table.lowerBound(node, endNode); });
+}
+
+template<typename Heuristic>
+std::vector<int> RoutePlanner::aStar(int startNode, int endNode, Heuristic heuristic)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    SearchScratch& search = *scratch;
+
+    // Initialize
+    search.begin(graph.nodeCount());
+    expansions = 0;
+    search.setScore(startNode, 0.0, -1);
+    search.open.pushOrDecrease(startNode, heuristic(startNode));
+
+    // Every node is queued at most once; a cheaper way to a queued node
+    // lowers its key in place instead of queueing it again
+    while (!search.open.isEmpty()) {
+        int current = search.open.pop();
+
+        if (current == endNode) {
+            // Path found
+            return reconstructPath(endNode);
+        }
+
+        search.close(current);
+        ++expansions;
+
+        // Check all neighbors
+        const double currentGScore = search.gScore(current);
+        for (int e = graph.edgeBegin(current); e < graph.edgeEnd(current); ++e) {
+            int neighbor = graph.edgeTargets[e];
+            if (search.isClosed(neighbor)) {
+                continue;
+            }
+
+            double tentativeGScore = currentGScore + graph.edgeCosts[e];
+
+            if (tentativeGScore < search.gScore(neighbor)) {
+                // An infinite bound proves the goal unreachable from there
+                const double estimate = heuristic(neighbor);
+                if (estimate == infinity) {
+                    continue;
+                }
+                search.setScore(neighbor, tentativeGScore, current);
+                search.open.pushOrDecrease(neighbor, tentativeGScore + estimate);
+            }
+        }
+    }
+
+    return std::vector<int>();
+}
+
+std::vector<int> RoutePlanner::bidirectionalSearch(int startNode, int endNode, const Landmarks& table)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    SearchScratch& forward = *scratch;
+    SearchScratch& backward = *reverseScratch;
+    const ReverseIndex& incoming = table.incomingEdges();
+
+    forward.begin(graph.nodeCount());
+    backward.begin(graph.nodeCount());
+    expansions = 0;
+    if (startNode == endNode) {
+        return std::vector<int>(1, startNode);
+    }
+
+    // Both sides share one potential, the forward one averaged with the
+    // negated backward one, and use it with opposite signs. That keeps
+    // both searches consistent, so once the two smallest keys add up to
+    // the best meeting found no cheaper path is left. Nodes either bound
+    // proves to be off every path are never queued.
+    auto potential = [&table, startNode, endNode, infinity](int node) {
+        const double toEnd = table.lowerBound(node, endNode);
+        const double fromStart = table.lowerBound(startNode, node);
+        return toEnd == infinity || fromStart == infinity ? infinity : (toEnd - fromStart) / 2;
+    };
+
+    const double startPotential = potential(startNode);
+    if (startPotential == infinity) {
+        return std::vector<int>();
+    }
+    forward.setScore(startNode, 0.0, -1);
+    forward.open.pushOrDecrease(startNode, startPotential);
+    backward.setScore(endNode, 0.0, -1);
+    backward.open.pushOrDecrease(endNode, -potential(endNode));
+
+    double best = infinity;
+    int meeting = -1;
+    while (!forward.open.isEmpty() && !backward.open.isEmpty()) {
+        if (forward.open.topKey() + backward.open.topKey() >= best) {
+            break;
+        }
+
+        // Grow the smaller frontier
+        const bool forwardStep = forward.open.size() <= backward.open.size();
+        SearchScratch& side = forwardStep ? forward : backward;
+        const SearchScratch& other = forwardStep ? backward : forward;
+
+        const int current = side.open.pop();
+        side.close(current);
+        ++expansions;
+
+        const double currentGScore = side.gScore(current);
+        const int begin = forwardStep ? graph.edgeBegin(current) : incoming.offsets[current];
+        const int end = forwardStep ? graph.edgeEnd(current) : incoming.offsets[current + 1];
+        for (int i = begin; i < end; ++i) {
+            const int e = forwardStep ? i : incoming.edges[i];
+            const int neighbor = forwardStep ? graph.edgeTargets[e] : incoming.sources[i];
+            if (side.isClosed(neighbor)) {
+                continue;
+            }
+
+            const double tentativeGScore = currentGScore + graph.edgeCosts[e];
+            if (tentativeGScore < side.gScore(neighbor)) {
+                const double p = potential(neighbor);
+                if (p == infinity) {
+                    continue;
+                }
+                side.setScore(neighbor, tentativeGScore, current);
+                side.open.pushOrDecrease(neighbor, tentativeGScore + (forwardStep ? p : -p));
+
+                const double through = tentativeGScore + other.gScore(neighbor);
+                if (through < best) {
+                    best = through;
+                    meeting = neighbor;
+                }
+            }
+        }
+    }
+
+    if (meeting < 0) {
+        return std::vector<int>();
+    }
+
+    // Start to meeting node along forward parents, then on to the end
+    // along backward parents, which point towards the end
+    int length = 0;
+    for (int node = meeting; node >= 0; node = forward.parent(node)) {
+        ++length;
+    }
+    int position = length;
+    for (int node = backward.parent(meeting); node >= 0; node = backward.parent(node)) {
+        ++length;
+    }
+
+    std::vector<int> path(length);
+    for (int node = meeting, i = position; node >= 0; node = forward.parent(node)) {
+        path[--i] = node;
+    }
+    for (int node = backward.parent(meeting); node >= 0; node = backward.parent(node)) {
+        path[position++] = node;
+    }
+    return path;
+}
+
+std::vector<int> RoutePlanner::findOptimalCollectionRoute(int startNode,
+                                                          const std::vector<int>& targets,
+                                                          const PlannerControl& control)
+{
+    routeProvenOptimal = false;
+    if (targets.empty()) {
+        return std::vector<int>();
+    }
+
+    // Make sure every waypoint has a row in the distance table
+    std::vector<int> waypoints = targets;
+    waypoints.push_back(startNode);
+    const DistanceTable& table = keyDistances(waypoints);
+
+    // Targets cut off by removed nodes or blocked edges can't be part of
+    // any route; plan through the rest
+    std::vector<int> reachableTargets;
+    reachableTargets.reserve(targets.size());
+    for (int target : targets) {
+        if (table.cost(startNode, target) < std::numeric_limits<double>::infinity()) {
+            reachableTargets.push_back(target);
+        } else {
+            qCWarning(lcPlanner) << "Skipping unreachable target" << target;
+        }
+    }
+    if (reachableTargets.empty()) {
+        return std::vector<int>();
+    }
+    return solveCollectionRoute(startNode, reachableTargets, table, control);
+}
+
+std::vector<int> RoutePlanner::solveCollectionRoute(int startNode,
+                                                    const std::vector<int>& targets,
+                                                    const DistanceTable& table,
+                                                    const PlannerControl& control)
+{
+    // Dense costs between the targets, with the start in the last row, so
+    // the solvers never have to look up node indices
+    const int targetCount = static_cast<int>(targets.size());
+    const int stride = targetCount + 1;
+    std::vector<double> costs(static_cast<size_t>(stride) * stride);
+    for (int a = 0; a < stride; ++a) {
+        const int from = a < targetCount ? targets[a] : startNode;
+        for (int b = 0; b < stride; ++b) {
+            const int to = b < targetCount ? targets[b] : startNode;
+            costs[a * stride + b] = table.cost(from, to);
+        }
+    }
+
+    // Small target sets are solved exactly, larger ones with the GA
+    std::vector<int> order;
+    double fitness = 0.0;
+
+    if (targetCount <= ExactRouteSolver::heldKarpLimit) {
+        ExactRouteSolver exact;
+        order = exact.solveHeldKarp(costs, targetCount, control);
+        fitness = exact.bestCost();
+        routeProvenOptimal = !order.empty();
+    } else {
+        // Use an island-model Genetic Algorithm to solve TSP
+        GeneticRouteSolver solver(settings);
+        order = solver.solve(costs, targetCount, seed, control,
+                             [&](const std::vector<int>& bestOrder, double) {
+            if (control.bestRoute) {
+                control.reportBestRoute(expandCollectionRoute(startNode, targets, bestOrder, table));
+            }
+        });
+        fitness = solver.bestCost();
+
+        // A few targets too many for Held-Karp: try to prove (or improve)
+        // the GA route with branch and bound
+        if (!order.empty() && targetCount <= ExactRouteSolver::branchAndBoundLimit) {
+            ExactRouteSolver exact;
+            order = exact.solveBranchAndBound(costs, targetCount, order, control);
+            fitness = exact.bestCost();
+            routeProvenOptimal = exact.provenOptimal();
+        }
+    }
+
+    if (order.empty()) {
+        routeProvenOptimal = false;
+        return std::vector<int>();
+    }
+
+    qCInfo(lcPlanner) << "Optimal route found with fitness:" << fitness
+                      << (routeProvenOptimal ? "(proven optimal)" : "");
+
+    return expandCollectionRoute(startNode, targets, order, table);
+}
+
+std::vector<int> RoutePlanner::expandCollectionRoute(int startNode,
+                                                     const std::vector<int>& targets,
+                                                     const std::vector<int>& order,
+                                                     const DistanceTable& table) const
+{
+    // Expand to the full path by walking the next-hop table between waypoints
+    std::vector<int> fullPath;
+    fullPath.push_back(startNode);
+
+    int current = startNode;
+    for (int target : order) {
+        int next = targets[target];
+        if (!table.appendPath(graph, current, next, fullPath)) {
+            // Unreachable waypoint: keep it in the route without a connecting segment
+            fullPath.push_back(next);
+        }
+        current = next;
+    }
+
+    return fullPath;
+}
+
+std::vector<int> RoutePlanner::reconstructPath(int current) const
+{
+    // Measure first, so the path is allocated once at its final size
+    int length = 0;
+    for (int node = current; node >= 0; node = scratch->parent(node)) {
+        ++length;
+    }
+
+    std::vector<int> path(length);
+    for (int node = current; node >= 0; node = scratch->parent(node)) {
+        path[--length] = node;
+    }
+    return path;
+}
+
+const DistanceTable& RoutePlanner::keyDistances(const std::vector<int>& extraNodes)
+{
+    // Keep our own reference so the table stays alive for this planner
+    distanceTable = snapshot->keyDistances(extraNodes);
+    return *distanceTable;
+}
+
+std::vector<int> RoutePlanner::findOptimalBallCollectionRoute(int startNode,
+                                                              int releaseNode,
+                                                              int carryCapacity,
+                                                              const PlannerControl& control)
+{
+    routeProvenOptimal = false;
+
+    std::vector<int> allBalls = getCollectibleBallNodes();
+    if (allBalls.empty()) {
+        qCInfo(lcPlanner) << "No collectible balls found";
+        return std::vector<int>();
+    }
+
+    const DistanceTable& table = keyDistances({startNode, releaseNode});
+
+    qCDebug(lcPlanner) << "Found" << allBalls.size() << "balls, capacity:" << carryCapacity;
+
+    // Dense costs between the balls, then the start, then the release area
+    const int ballCount = static_cast<int>(allBalls.size());
+    const int stride = ballCount + 2;
+    std::vector<double> costs(static_cast<size_t>(stride) * stride);
+    std::vector<int> points(ballCount);
+    for (int a = 0; a < stride; ++a) {
+        const int from = a < ballCount ? allBalls[a] : (a == ballCount ? startNode : releaseNode);
+        for (int b = 0; b < stride; ++b) {
+            const int to = b < ballCount ? allBalls[b] : (b == ballCount ? startNode : releaseNode);
+            costs[a * stride + b] = table.cost(from, to);
+        }
+        if (a < ballCount) {
+            points[a] = graph.points[from];
+        }
+    }
+
+    PrizeRouteSolver solver(prizeSettings);
+    auto toRoute = [&](const std::vector<int>& stops) {
+        std::vector<int> route;
+        route.reserve(stops.size() + 1);
+        route.push_back(startNode);
+        for (int stop : stops) {
+            route.push_back(stop < ballCount ? allBalls[stop] : releaseNode);
+        }
+        return route;
+    };
+
+    std::vector<int> stops = solver.solve(costs, points, ballCount, carryCapacity, seed, control,
+                                          [&](const std::vector<int>& bestStops, double) {
+        if (control.bestRoute) {
+            control.reportBestRoute(toRoute(bestStops));
+        }
+    });
+
+    if (stops.empty()) {
+        qCInfo(lcPlanner) << "No valid route found";
+        return std::vector<int>();
+    }
+
+    std::vector<int> route = toRoute(stops);
+    qCInfo(lcPlanner) << "Final route generated with" << route.size() << "nodes, value:" << solver.bestValue();
+    return route;
+}
+
+std::vector<int> RoutePlanner::getCollectibleBallNodes() const
+{
+    std::vector<int> balls;
+
+    for (int node = 0; node < graph.nodeCount(); ++node) {
+        if (isCollectibleKind(graph.kind[node])) {
+            balls.push_back(node);
+        }
+    }
+
+    return balls;
+}
+
+double RoutePlanner::calculateRouteValue(const std::vector<int>& route, int releaseNode)
+{
+    if (route.size() < 2) {
+        return 0.0;
+    }
+
+    // Calculate total points
+    int totalPoints = 0;
+    for (int node : route) {
+        if (node != releaseNode) {
+            totalPoints += graph.points[node];
+        }
+    }
+
+    // Calculate total distance
+    const DistanceTable& table = keyDistances(route);
+    double totalDistance = 0.0;
+    for (size_t i = 0; i + 1 < route.size(); ++i) {
+        totalDistance += table.cost(route[i], route[i + 1]);
+    }
+
+    if (totalDistance == 0.0) {
+        return 0.0;
+    }
+
+    return totalPoints / totalDistance; // Points per distance unit
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "PlannerGraph.h"
+#include "PlannerControl.h"
+#include "GeneticRouteSolver.h"
+#include "ExactRouteSolver.h"
+#include "PrizeRouteSolver.h"
+#include "SearchScratch.h"
+
+// How findPath() searches
+enum class PathSearch {
+    AStar,          // Straight-line heuristic, no preprocessing
+    Landmarks,      // A* on landmark bounds (ALT), returns shortest paths
+    Bidirectional,  // ALT from both ends at once, meeting in the middle
+    Hierarchy       // Contraction hierarchy once built, plain A* until then
+};
+
+// The search algorithms behind PathfindingEngine, working on node indices
+// of one PlannerGraph snapshot. A planner is cheap to create and owns its
+// random state, so each job (or each synchronous call) gets its own.
+class RoutePlanner
+{
+public:
+    RoutePlanner(std::shared_ptr<const PlannerGraph> snapshot, unsigned int seed);
+
+    void setGeneticSettings(const GeneticSettings& geneticSettings) { settings = geneticSettings; }
+    void setPrizeRouteSettings(const PrizeRouteSettings& prizeRouteSettings) { prizeSettings = prizeRouteSettings; }
+    // Search buffers to reuse across planners, e.g. one pair per engine for
+    // its synchronous calls; backward is only used by the two-ended searches.
+    // Without them the planner makes its own on the first findPath() and
+    // reuses them for later calls.
+    void setSearchScratch(std::shared_ptr<SearchScratch> forward, std::shared_ptr<SearchScratch> backward = nullptr)
+    {
+        scratch = std::move(forward);
+        reverseScratch = std::move(backward);
+    }
+
+    // The landmark and hierarchy searches never build their tables, they
+    // use plain A* until someone else has
+    std::vector<int> findPath(int startNode, int endNode, PathSearch search = PathSearch::AStar);
+    std::vector<int> findOptimalCollectionRoute(int startNode,
+                                                const std::vector<int>& targets,
+                                                const PlannerControl& control = PlannerControl());
+    std::vector<int> findOptimalBallCollectionRoute(int startNode,
+                                                    int releaseNode,
+                                                    int carryCapacity,
+                                                    const PlannerControl& control = PlannerControl());
+    double calculateRouteValue(const std::vector<int>& route, int releaseNode);
+
+    // True if the last route returned by findOptimalCollectionRoute is
+    // proven to be the cheapest visiting order
+    bool lastRouteProvenOptimal() const { return routeProvenOptimal; }
+
+    // Nodes expanded by the last findPath(), for profiling
+    int lastExpansions() const { return expansions; }
+
+private:
+    std::shared_ptr<const PlannerGraph> snapshot;
+    const NavGraph& graph;
+    std::shared_ptr<const DistanceTable> distanceTable;
+    std::shared_ptr<const Landmarks> landmarks;
+    std::shared_ptr<const ContractionHierarchy> hierarchy;
+    unsigned int seed;
+    GeneticSettings settings;
+    PrizeRouteSettings prizeSettings;
+    bool routeProvenOptimal;
+    int expansions;
+    std::shared_ptr<SearchScratch> scratch;
+    std::shared_ptr<SearchScratch> reverseScratch;
+
+    // A* Algorithm methods
+    template<typename Heuristic>
+    std::vector<int> aStar(int startNode, int endNode, Heuristic heuristic);
+    std::vector<int> bidirectionalSearch(int startNode, int endNode, const Landmarks& table);
+    std::vector<int> reconstructPath(int current) const;
+
+    // Genetic Algorithm helpers
+    std::vector<int> solveCollectionRoute(int startNode,
+                                          const std::vector<int>& targets,
+                                          const DistanceTable& table,
+                                          const PlannerControl& control);
+    std::vector<int> expandCollectionRoute(int startNode,
+                                           const std::vector<int>& targets,
+                                           const std::vector<int>& order,
+                                           const DistanceTable& table) const;
+
+    // Helper methods
+    const DistanceTable& keyDistances(const std::vector<int>& extraNodes);
+    std::vector<int> getCollectibleBallNodes() const;
+};
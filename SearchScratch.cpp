@@ -0,0 +1,34 @@
+#include "SearchScratch.h"
+#include <algorithm>
+
+void IndexedHeap::reset(int nodeCount)
+{
+    // Only nodes still queued by an abandoned search need clearing
+    for (const Entry& entry : entries) {
+        position[entry.node] = -1;
+    }
+    entries.clear();
+    if (static_cast<int>(position.size()) != nodeCount) {
+        position.assign(nodeCount, -1);
+    }
+}
+
+void SearchScratch::begin(int nodeCount)
+{
+    open.reset(nodeCount);
+
+    if (static_cast<int>(seen.size()) != nodeCount) {
+        seen.assign(nodeCount, 0);
+        closed.assign(nodeCount, 0);
+        g.resize(nodeCount);
+        parents.resize(nodeCount);
+        generation = 0;
+    }
+
+    // Stamps from 2^32 queries ago would look current after a wrap
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        generation = 1;
+    }
+}
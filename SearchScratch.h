@@ -0,0 +1,143 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+// Min-heap of node indices with decrease-key. Four children per entry keep
+// the tree shallow and a node's children on one cache line; position[]
+// maps each node to its entry, -1 when it is not queued. Equal keys pop
+// the lower node index first, as the std::priority_queue it replaces did.
+class IndexedHeap
+{
+public:
+    // Makes room for node indices below nodeCount and empties the heap
+    void reset(int nodeCount);
+
+    bool isEmpty() const { return entries.empty(); }
+    int size() const { return static_cast<int>(entries.size()); }
+    bool contains(int node) const { return position[node] >= 0; }
+
+    // Queues node, or lowers its key if it is queued with a higher one
+    void pushOrDecrease(int node, double key)
+    {
+        int index = position[node];
+        if (index < 0) {
+            index = static_cast<int>(entries.size());
+            entries.push_back({key, node});
+        } else if (key < entries[index].key) {
+            entries[index].key = key;
+        } else {
+            return;
+        }
+        siftUp(index);
+    }
+
+    int top() const { return entries.front().node; }
+    double topKey() const { return entries.front().key; }
+
+    int pop()
+    {
+        const int node = entries.front().node;
+        position[node] = -1;
+        const Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            entries.front() = last;
+            siftDown(0);
+        }
+        return node;
+    }
+
+private:
+    struct Entry {
+        double key;
+        int node;
+
+        bool operator<(const Entry& other) const
+        {
+            return key < other.key || (key == other.key && node < other.node);
+        }
+    };
+
+    std::vector<Entry> entries;
+    std::vector<int> position;
+
+    void siftUp(int index)
+    {
+        const Entry entry = entries[index];
+        while (index > 0) {
+            const int parent = (index - 1) / 4;
+            if (!(entry < entries[parent])) {
+                break;
+            }
+            entries[index] = entries[parent];
+            position[entries[index].node] = index;
+            index = parent;
+        }
+        entries[index] = entry;
+        position[entry.node] = index;
+    }
+
+    void siftDown(int index)
+    {
+        const Entry entry = entries[index];
+        const int count = static_cast<int>(entries.size());
+        while (true) {
+            const int first = index * 4 + 1;
+            if (first >= count) {
+                break;
+            }
+            int best = first;
+            const int end = first + 4 < count ? first + 4 : count;
+            for (int child = first + 1; child < end; ++child) {
+                if (entries[child] < entries[best]) {
+                    best = child;
+                }
+            }
+            if (!(entries[best] < entry)) {
+                break;
+            }
+            entries[index] = entries[best];
+            position[entries[index].node] = index;
+            index = best;
+        }
+        entries[index] = entry;
+        position[entry.node] = index;
+    }
+};
+
+// Per-node state of a graph search (g-score, parent, closed flag) that is
+// reused from one query to the next. Starting a query bumps a generation
+// counter instead of clearing the arrays, so back-to-back searches cost
+// only the nodes they touch and allocate nothing once the buffers have
+// grown to the graph. Not thread-safe: one scratch per thread of searches.
+class SearchScratch
+{
+public:
+    // Starts a query on a graph of nodeCount nodes
+    void begin(int nodeCount);
+
+    double gScore(int node) const
+    {
+        return seen[node] == generation ? g[node] : std::numeric_limits<double>::infinity();
+    }
+    int parent(int node) const { return seen[node] == generation ? parents[node] : -1; }
+    void setScore(int node, double score, int parentNode)
+    {
+        seen[node] = generation;
+        g[node] = score;
+        parents[node] = parentNode;
+    }
+
+    bool isClosed(int node) const { return closed[node] == generation; }
+    void close(int node) { closed[node] = generation; }
+
+    IndexedHeap open;
+
+private:
+    unsigned int generation = 0;
+    std::vector<unsigned int> seen;     // g and parents are valid where seen == generation
+    std::vector<unsigned int> closed;
+    std::vector<double> g;
+    std::vector<int> parents;
+};
@@ -0,0 +1,284 @@
+#include "SerialFrameParser.h"
+#include <cstring>
+
+namespace {
+
+constexpr quint32 ringMask = SerialFrameParser::Capacity - 1;
+static_assert((SerialFrameParser::Capacity & ringMask) == 0, "Capacity must be a power of two");
+
+// Keys in the order the firmware prints them; the last one is the button
+const char* const keys[] = { "X1=", "Y1=", "X2=", "Y2=", "BTN=" };
+constexpr int keyLengths[] = { 3, 3, 3, 3, 4 };
+constexpr int buttonField = 4;
+constexpr int maxDigits = 5;
+
+bool isBlank(quint8 byte)
+{
+    return byte == ' ' || byte == '\t' || byte == '\r';
+}
+
+bool isDigit(quint8 byte)
+{
+    return byte >= '0' && byte <= '9';
+}
+
+bool isWordChar(quint8 byte)
+{
+    return isDigit(byte) || (byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z') || byte == '_';
+}
+
+}
+
+char* SerialFrameParser::writeBuffer(qsizetype& space)
+{
+    const quint32 offset = head & ringMask;
+    const quint32 free = Capacity - (head - tail);
+    space = qMin<quint32>(free, Capacity - offset);
+    return ring + offset;
+}
+
+void SerialFrameParser::commit(qsizetype count)
+{
+    head += quint32(count);
+}
+
+void SerialFrameParser::append(const char* data, qsizetype size)
+{
+    while (size > 0) {
+        qsizetype space = 0;
+        char* target = writeBuffer(space);
+        if (space == 0) {
+            overruns += size;
+            return;
+        }
+
+        const qsizetype count = qMin(space, size);
+        std::memcpy(target, data, count);
+        commit(count);
+        data += count;
+        size -= count;
+    }
+}
+
+bool SerialFrameParser::next(ThumbstickSample& sample)
+{
+    while (tail != head) {
+        const quint8 byte = quint8(ring[tail & ringMask]);
+        ++tail;
+        if (consume(byte, sample)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SerialFrameParser::reset()
+{
+    head = tail = 0;
+    state = State::LineStart;
+    lineLengthSoFar = lastLineLength = 0;
+    payloadSize = 0;
+    frames = malformed = checksumErrors = overruns = 0;
+}
+
+void SerialFrameParser::startLine()
+{
+    field = 0;
+    keyPos = 0;
+    lineLengthSoFar = 0;
+}
+
+void SerialFrameParser::fail()
+{
+    ++malformed;
+    state = State::Skip;
+}
+
+bool SerialFrameParser::consume(quint8 byte, ThumbstickSample& sample)
+{
+    if (state == State::BinarySync) {
+        if (byte == SyncSecond) {
+            state = State::BinaryPayload;
+            payloadSize = 0;
+            return false;
+        }
+        ++malformed;
+        state = State::LineStart; // The byte may start a text line
+    } else if (state == State::BinaryPayload) {
+        payload[payloadSize++] = byte;
+        if (payloadSize < BinaryPayloadSize) {
+            return false;
+        }
+        state = State::LineStart;
+        return finishBinary(sample);
+    }
+
+    if (byte == SyncFirst) {
+        if (state != State::LineStart && state != State::Skip) {
+            ++malformed; // Text line cut short by a binary frame
+        }
+        state = State::BinarySync;
+        return false;
+    }
+
+    return consumeText(byte, sample);
+}
+
+bool SerialFrameParser::finishBinary(ThumbstickSample& sample)
+{
+    quint8 sum = 0;
+    for (int i = 0; i < BinaryPayloadSize - 1; ++i) {
+        sum += payload[i];
+    }
+    if (sum != payload[BinaryPayloadSize - 1]) {
+        ++checksumErrors;
+        ++malformed;
+        return false;
+    }
+
+    sample.motorX = payload[0] | (payload[1] << 8);
+    sample.motorY = payload[2] | (payload[3] << 8);
+    sample.armX = payload[4] | (payload[5] << 8);
+    sample.armY = payload[6] | (payload[7] << 8);
+    const char* name = (payload[8] & 0x1) ? "CLOSE" : "OPEN";
+    sample.buttonLength = int(std::strlen(name));
+    std::memcpy(sample.button, name, sample.buttonLength + 1);
+    sample.binary = true;
+
+    lastLineLength = 0;
+    ++frames;
+    return true;
+}
+
+bool SerialFrameParser::consumeText(quint8 byte, ThumbstickSample& sample)
+{
+    if (byte == '\n') {
+        switch (state) {
+        case State::LineStart:
+            return false;
+        case State::Skip:
+            state = State::LineStart;
+            return false;
+        case State::Button:
+            if (buttonLength == 0) {
+                break;
+            }
+            Q_FALLTHROUGH();
+        case State::LineEnd: {
+            sample.motorX = values[0];
+            sample.motorY = values[1];
+            sample.armX = values[2];
+            sample.armY = values[3];
+            std::memcpy(sample.button, button, buttonLength);
+            sample.button[buttonLength] = '\0';
+            sample.buttonLength = buttonLength;
+            sample.binary = false;
+
+            while (lineLengthSoFar > 0 && isBlank(quint8(line[lineLengthSoFar - 1]))) {
+                --lineLengthSoFar;
+            }
+            line[lineLengthSoFar] = '\0';
+            lastLineLength = lineLengthSoFar;
+
+            ++frames;
+            state = State::LineStart;
+            return true;
+        }
+        default:
+            break;
+        }
+
+        // Line ended before the button
+        ++malformed;
+        state = State::LineStart;
+        return false;
+    }
+
+    if (state == State::Skip) {
+        return false;
+    }
+
+    if (state == State::LineStart) {
+        if (isBlank(byte)) {
+            return false;
+        }
+        startLine();
+        state = State::SearchKey;
+    }
+
+    if (lineLengthSoFar == MaxLineLength) {
+        fail();
+        return false;
+    }
+    line[lineLengthSoFar++] = char(byte);
+
+    switch (state) {
+    case State::SearchKey:
+        // Garbage before the first key is allowed; 'X' occurs only once in
+        // "X1=" so a mismatch can restart the match at this byte
+        if (byte == quint8(keys[0][keyPos])) {
+            if (++keyPos == keyLengths[0]) {
+                state = State::Digits;
+                value = digits = 0;
+            }
+        } else {
+            keyPos = byte == quint8(keys[0][0]) ? 1 : 0;
+        }
+        return false;
+
+    case State::Separator:
+        if (isBlank(byte)) {
+            return false;
+        }
+        ++field;
+        keyPos = 0;
+        state = State::Key;
+        Q_FALLTHROUGH();
+
+    case State::Key:
+        if (byte != quint8(keys[field][keyPos])) {
+            fail();
+        } else if (++keyPos == keyLengths[field]) {
+            if (field == buttonField) {
+                state = State::Button;
+                buttonLength = 0;
+            } else {
+                state = State::Digits;
+                value = digits = 0;
+            }
+        }
+        return false;
+
+    case State::Digits:
+        if (isDigit(byte)) {
+            value = value * 10 + (byte - '0');
+            if (++digits > maxDigits) {
+                fail();
+            }
+        } else if (digits > 0 && byte == ',') {
+            values[field] = value;
+            state = State::Separator;
+        } else {
+            fail();
+        }
+        return false;
+
+    case State::Button:
+        if (isWordChar(byte)) {
+            if (buttonLength == ThumbstickSample::MaxButtonLength) {
+                fail();
+            } else {
+                button[buttonLength++] = char(byte);
+            }
+        } else if (buttonLength > 0) {
+            state = State::LineEnd;
+        } else {
+            fail();
+        }
+        return false;
+
+    default:
+        // LineEnd: whatever follows the button word is ignored
+        return false;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QtGlobal>
+
+// One reading of both thumbsticks and the gripper button
+struct ThumbstickSample
+{
+    static constexpr int MaxButtonLength = 15;
+
+    int motorX = 0;
+    int motorY = 0;
+    int armX = 0;
+    int armY = 0;
+    char button[MaxButtonLength + 1] = {};
+    int buttonLength = 0;
+    bool binary = false;    // Came as a binary frame rather than a text line
+};
+
+// Streaming parser for the thumbstick Arduino's serial output.
+//
+// Text lines, as the firmware has always sent them:
+//     X1=123, Y1=456, X2=512, Y2=512, BTN=OPEN\n
+// Anything before "X1=" and after the button word is ignored, every other
+// deviation discards the line up to the next newline.
+//
+// Binary frames, which the firmware may send instead:
+//     0xA5 0x5A  X1 Y1 X2 Y2 (u16 little-endian)  buttons (u8, bit 0 closed)
+//     checksum (u8, sum of the 9 bytes after the sync pair)
+// 0xA5 never occurs in the text format, so both can share a port.
+//
+// Bytes are read straight into a fixed ring and consumed by a byte-at-a-time
+// state machine, so partial frames carry over between reads and nothing is
+// allocated per line.
+class SerialFrameParser
+{
+public:
+    static constexpr int Capacity = 1024;       // Ring size, power of two
+    static constexpr int MaxLineLength = 128;   // Longer text lines are malformed
+
+    // Contiguous free space to read into, then commit() what was read
+    char* writeBuffer(qsizetype& space);
+    void commit(qsizetype count);
+    // Copying alternative to writeBuffer()/commit()
+    void append(const char* data, qsizetype size);
+
+    // Parses up to the next complete frame; false once the ring is empty
+    bool next(ThumbstickSample& sample);
+
+    // The text line behind the last sample, valid until the next call
+    const char* lineData() const { return line; }
+    int lineLength() const { return lastLineLength; }
+
+    quint64 frameCount() const { return frames; }
+    quint64 malformedCount() const { return malformed; }
+    quint64 checksumErrorCount() const { return checksumErrors; }
+    quint64 overrunCount() const { return overruns; } // Bytes lost to a full ring
+
+    void reset();
+
+private:
+    enum class State {
+        LineStart,      // Skipping blank space before a line
+        SearchKey,      // Looking for "X1=" in the line
+        Key,            // Matching the key of the current field
+        Digits,
+        Separator,      // ',' and blank space after a number
+        Button,
+        LineEnd,        // Rest of a complete line
+        Skip,           // Rest of a malformed line
+        BinarySync,     // Seen 0xA5, expecting 0x5A
+        BinaryPayload
+    };
+
+    static constexpr quint8 SyncFirst = 0xA5;
+    static constexpr quint8 SyncSecond = 0x5A;
+    static constexpr int BinaryPayloadSize = 10;    // 9 data bytes + checksum
+
+    char ring[Capacity];
+    quint32 head = 0;   // Free-running write and read counters
+    quint32 tail = 0;
+
+    State state = State::LineStart;
+    int field = 0;
+    int keyPos = 0;
+    int value = 0;
+    int digits = 0;
+    int values[4] = {};
+    char button[ThumbstickSample::MaxButtonLength + 1] = {};
+    int buttonLength = 0;
+
+    char line[MaxLineLength + 1] = {};
+    int lineLengthSoFar = 0;
+    int lastLineLength = 0;
+
+    quint8 payload[BinaryPayloadSize] = {};
+    int payloadSize = 0;
+
+    quint64 frames = 0;
+    quint64 malformed = 0;
+    quint64 checksumErrors = 0;
+    quint64 overruns = 0;
+
+    // True when the byte completes a sample
+    bool consume(quint8 byte, ThumbstickSample& sample);
+    bool consumeText(quint8 byte, ThumbstickSample& sample);
+    bool finishBinary(ThumbstickSample& sample);
+    void startLine();
+    void fail();
+};
@@ -0,0 +1,195 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void SpatialGrid::build(const std::vector<double>& x, const std::vector<double>& y, double pointsPerCell)
+{
+    const int count = static_cast<int>(x.size());
+
+    minX = minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    if (count > 0) {
+        auto [lowX, highX] = std::minmax_element(x.begin(), x.end());
+        auto [lowY, highY] = std::minmax_element(y.begin(), y.end());
+        minX = *lowX;
+        maxX = *highX;
+        minY = *lowY;
+        maxY = *highY;
+    }
+
+    // Cells of about pointsPerCell points for evenly spread maps. Points on
+    // a line get square cells along it instead of a degenerate area.
+    const double width = maxX - minX;
+    const double height = maxY - minY;
+    const double cellArea = width * height / std::max(1, count) * std::max(0.1, pointsPerCell);
+    cellSize = std::sqrt(cellArea);
+    if (!(cellSize > 0.0)) {
+        cellSize = std::max(width, height) / std::max(1, count) * std::max(0.1, pointsPerCell);
+    }
+    if (!(cellSize > 0.0)) {
+        cellSize = 1.0;
+    }
+    // A nearly flat or far-flung set of points would otherwise ask for more
+    // cells along one axis than there are points (or than an int holds)
+    const double maxCellsPerAxis = 4.0 * std::max(1, count);
+    cellSize = std::max({cellSize, width / maxCellsPerAxis, height / maxCellsPerAxis});
+
+    columns = static_cast<int>(width / cellSize) + 1;
+    rows = static_cast<int>(height / cellSize) + 1;
+
+    // Counting pass, then prefix sum into cellStart
+    std::vector<int> cellOfPoint(count);
+    cellStart.assign(static_cast<size_t>(columns) * rows + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        cellOfPoint[i] = rowOf(y[i]) * columns + columnOf(x[i]);
+        cellStart[cellOfPoint[i] + 1]++;
+    }
+    for (size_t cell = 0; cell + 1 < cellStart.size(); ++cell) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+
+    pointIndex.resize(count);
+    pointX.resize(count);
+    pointY.resize(count);
+
+    std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        int slot = cursor[cellOfPoint[i]]++;
+        pointIndex[slot] = i;
+        pointX[slot] = x[i];
+        pointY[slot] = y[i];
+    }
+}
+
+int SpatialGrid::columnOf(double px) const
+{
+    return std::clamp(static_cast<int>(std::floor((px - minX) / cellSize)), 0, columns - 1);
+}
+
+int SpatialGrid::rowOf(double py) const
+{
+    return std::clamp(static_cast<int>(std::floor((py - minY) / cellSize)), 0, rows - 1);
+}
+
+void SpatialGrid::nearest(double px, double py, int k, int skipIndex, std::vector<Neighbour>& result) const
+{
+    result.clear();
+    if (k <= 0 || pointIndex.empty()) {
+        return;
+    }
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    const int cx = columnOf(px);
+    const int cy = rowOf(py);
+
+    auto scanCell = [&](int column, int row) {
+        const int cell = row * columns + column;
+        for (int slot = cellStart[cell]; slot < cellStart[cell + 1]; ++slot) {
+            if (pointIndex[slot] != skipIndex) {
+                double dx = px - pointX[slot];
+                double dy = py - pointY[slot];
+                result.emplace_back(std::sqrt(dx * dx + dy * dy), pointIndex[slot]);
+            }
+        }
+    };
+
+    for (int ring = 0; ; ++ring) {
+        const int left = cx - ring;
+        const int right = cx + ring;
+        const int top = cy - ring;
+        const int bottom = cy + ring;
+
+        // Only the cells on the border of the ring are new
+        for (int column = std::max(0, left); column <= std::min(columns - 1, right); ++column) {
+            if (top >= 0) {
+                scanCell(column, top);
+            }
+            if (ring > 0 && bottom < rows) {
+                scanCell(column, bottom);
+            }
+        }
+        for (int row = std::max(0, top + 1); row <= std::min(rows - 1, bottom - 1); ++row) {
+            if (left >= 0) {
+                scanCell(left, row);
+            }
+            if (ring > 0 && right < columns) {
+                scanCell(right, row);
+            }
+        }
+
+        // Anything not scanned yet lies outside the ring's square; sides at
+        // the edge of the grid have nothing beyond them
+        double outside = infinity;
+        if (left > 0) outside = std::min(outside, px - (minX + left * cellSize));
+        if (right < columns - 1) outside = std::min(outside, minX + (right + 1) * cellSize - px);
+        if (top > 0) outside = std::min(outside, py - (minY + top * cellSize));
+        if (bottom < rows - 1) outside = std::min(outside, minY + (bottom + 1) * cellSize - py);
+
+        if (outside == infinity) {
+            break;
+        }
+        if (static_cast<int>(result.size()) >= k) {
+            std::nth_element(result.begin(), result.begin() + (k - 1), result.end());
+            if (result[k - 1].first < outside) {
+                break;
+            }
+        }
+    }
+
+    const int found = std::min<int>(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + found, result.end());
+    result.resize(found);
+}
+
+void SpatialGrid::withinRadius(double px, double py, double radius, std::vector<Neighbour>& result) const
+{
+    result.clear();
+    if (pointIndex.empty() || radius < 0) {
+        return;
+    }
+
+    const int firstColumn = columnOf(px - radius);
+    const int lastColumn = columnOf(px + radius);
+    const int firstRow = rowOf(py - radius);
+    const int lastRow = rowOf(py + radius);
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const int cell = row * columns + column;
+            for (int slot = cellStart[cell]; slot < cellStart[cell + 1]; ++slot) {
+                double dx = px - pointX[slot];
+                double dy = py - pointY[slot];
+                double distance = std::sqrt(dx * dx + dy * dy);
+                if (distance <= radius) {
+                    result.emplace_back(distance, pointIndex[slot]);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+}
+
+void SpatialGrid::inRect(double left, double top, double right, double bottom, std::vector<int>& result) const
+{
+    result.clear();
+    if (pointIndex.empty() || left > right || top > bottom) {
+        return;
+    }
+
+    for (int row = rowOf(top); row <= rowOf(bottom); ++row) {
+        for (int column = columnOf(left); column <= columnOf(right); ++column) {
+            const int cell = row * columns + column;
+            for (int slot = cellStart[cell]; slot < cellStart[cell + 1]; ++slot) {
+                if (pointX[slot] >= left && pointX[slot] <= right &&
+                    pointY[slot] >= top && pointY[slot] <= bottom) {
+                    result.push_back(pointIndex[slot]);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+// Uniform grid over a fixed point set for nearest-neighbour queries.
+// Points are bucketed by cell into one flat array (cellStart works like the
+// CSR offsets of NavGraph), so a query only reads the cells of a growing
+// ring around the query point.
+class SpatialGrid
+{
+public:
+    using Neighbour = std::pair<double, int>; // Distance, point index
+
+    // pointsPerCell trades cells scanned per ring against points per cell
+    void build(const std::vector<double>& x, const std::vector<double>& y, double pointsPerCell = 2.0);
+
+    int pointCount() const { return static_cast<int>(pointIndex.size()); }
+
+    // The k points closest to (px, py), nearest first, ties broken by lower
+    // index. skipIndex (e.g. the query point itself) is left out.
+    void nearest(double px, double py, int k, int skipIndex, std::vector<Neighbour>& result) const;
+
+    // All points within radius of (px, py), nearest first
+    void withinRadius(double px, double py, double radius, std::vector<Neighbour>& result) const;
+
+    // Indices of all points inside the rectangle, edges included, ascending
+    void inRect(double left, double top, double right, double bottom, std::vector<int>& result) const;
+
+private:
+    double minX = 0.0;
+    double minY = 0.0;
+    double cellSize = 1.0;
+    int columns = 0;
+    int rows = 0;
+
+    std::vector<int> cellStart;     // columns * rows + 1 entries
+    std::vector<int> pointIndex;    // Original index of each bucketed point
+    std::vector<double> pointX;     // Coordinates in bucketed order
+    std::vector<double> pointY;
+
+    int columnOf(double px) const;
+    int rowOf(double py) const;
+};
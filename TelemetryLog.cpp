@@ -0,0 +1,207 @@
+#include "TelemetryLog.h"
+#include <QDateTime>
+#include <QtEndian>
+#include <cstring>
+
+using namespace TelemetryLog;
+
+namespace {
+
+const char magic[6] = {'R', 'C', 'T', 'L', 'M', '\0'};
+
+} // namespace
+
+TelemetryWriter::~TelemetryWriter()
+{
+    close();
+}
+
+bool TelemetryWriter::open(const QString& path, qint64 time)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+
+    chunkOffset = -ChunkSize;
+    written = 0;
+    startTime = time;
+    if (!mapNextChunk()) {
+        file.close();
+        return false;
+    }
+
+    char header[HeaderSize];
+    memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint16>(Version, header + 6);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+    write(header, sizeof(header));
+    return true;
+}
+
+void TelemetryWriter::close()
+{
+    if (chunk) {
+        file.unmap(chunk);
+        chunk = nullptr;
+    }
+    if (file.isOpen()) {
+        file.resize(written);
+        file.close();
+    }
+}
+
+void TelemetryWriter::appendSerial(const char* data, qint64 size, qint64 time)
+{
+    while (size > 0) {
+        const int part = static_cast<int>(qMin<qint64>(size, MaxPayload));
+        appendRecord(Serial, data, part, time);
+        data += part;
+        size -= part;
+    }
+}
+
+void TelemetryWriter::appendCommand(quint8 endpoint, quint8 source, const QString& command, int speed, qint64 time)
+{
+    char payload[64];
+    payload[0] = static_cast<char>(endpoint);
+    payload[1] = static_cast<char>(source);
+    payload[2] = static_cast<char>(qBound(0, speed, 255));
+    const QByteArray name = command.toLatin1().left(sizeof(payload) - 3);
+    memcpy(payload + 3, name.constData(), name.size());
+    appendRecord(Command, payload, 3 + name.size(), time);
+}
+
+void TelemetryWriter::appendState(const char* state, int size, qint64 time)
+{
+    appendRecord(State, state, size, time);
+}
+
+void TelemetryWriter::appendRecord(Kind kind, const char* payload, int size, qint64 time)
+{
+    if (!chunk) {
+        return;
+    }
+
+    char header[RecordHeaderSize];
+    qToLittleEndian<qint64>(time - startTime, header);
+    qToLittleEndian<quint16>(static_cast<quint16>(size), header + 8);
+    // The kind byte goes in last, so a record is only visible to a reader
+    // of a crashed log once its payload is there
+    header[10] = End;
+    header[11] = 0;
+    const qint64 recordStart = written;
+    if (!write(header, sizeof(header)) || !write(payload, size)) {
+        return;
+    }
+    const qint64 kindOffset = recordStart + 10 - chunkOffset;
+    if (kindOffset >= 0) {
+        chunk[kindOffset] = kind;
+    } else {
+        // The header was in the previous chunk, which is already unmapped
+        file.seek(recordStart + 10);
+        file.write(reinterpret_cast<const char*>(&kind), 1);
+    }
+}
+
+bool TelemetryWriter::write(const char* data, qint64 size)
+{
+    while (size > 0) {
+        qint64 room = chunkOffset + ChunkSize - written;
+        if (room == 0) {
+            if (!mapNextChunk()) {
+                return false;
+            }
+            room = ChunkSize;
+        }
+        const qint64 part = qMin(size, room);
+        memcpy(chunk + (written - chunkOffset), data, part);
+        written += part;
+        data += part;
+        size -= part;
+    }
+    return true;
+}
+
+bool TelemetryWriter::mapNextChunk()
+{
+    if (chunk) {
+        file.unmap(chunk);
+        chunk = nullptr;
+    }
+
+    const qint64 offset = chunkOffset + ChunkSize;
+    if (!file.resize(offset + ChunkSize)) {
+        return false;
+    }
+    chunk = file.map(offset, ChunkSize);
+    if (!chunk) {
+        return false;
+    }
+    chunkOffset = offset;
+    return true;
+}
+
+TelemetryReader::~TelemetryReader()
+{
+    close();
+}
+
+bool TelemetryReader::open(const QString& path)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    size = file.size();
+    data = size >= HeaderSize ? file.map(0, size) : nullptr;
+    if (!data || memcmp(data, magic, sizeof(magic)) != 0
+        || qFromLittleEndian<quint16>(data + 6) != Version) {
+        error = data ? QStringLiteral("Not a telemetry log") : file.errorString();
+        close();
+        return false;
+    }
+
+    startMs = qFromLittleEndian<qint64>(data + 8);
+    offset = HeaderSize;
+    error.clear();
+    return true;
+}
+
+void TelemetryReader::close()
+{
+    if (data) {
+        file.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+    }
+    file.close();
+    size = 0;
+    offset = 0;
+}
+
+bool TelemetryReader::next(Record& record)
+{
+    if (!data || offset + RecordHeaderSize > size) {
+        return false;
+    }
+
+    const uchar* header = data + offset;
+    const int payloadSize = qFromLittleEndian<quint16>(header + 8);
+    const quint8 kind = header[10];
+    if (kind == End || kind > State || offset + RecordHeaderSize + payloadSize > size) {
+        return false;
+    }
+
+    record.time = qFromLittleEndian<qint64>(header);
+    record.kind = static_cast<Kind>(kind);
+    record.data = reinterpret_cast<const char*>(header + RecordHeaderSize);
+    record.size = payloadSize;
+    offset += RecordHeaderSize + payloadSize;
+    return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+// Append-only binary log of the thumbstick pipeline: the serial bytes as
+// they were read and the commands that came out, for replaying field
+// sessions without the hardware. All fields are little-endian:
+//
+//   header   "RCTLM\0"  u16 version  i64 start (ms since epoch)     16 bytes
+//   record   i64 time (ns since start)  u16 length  u8 kind  u8 0   12 bytes
+//            then length payload bytes
+//
+// Serial    the bytes of one serial read
+// Command   u8 endpoint code, u8 source, u8 speed, the command name (Latin-1)
+// State     what decides the next command when recording starts or the
+//           thumbstick is switched: u8 enabled, then motor direction,
+//           speed, last direction, last speed, arm command, last arm
+//           command, button closed, last button closed, one byte each,
+//           directions as ControlFrame command codes
+//
+// The writer maps the file chunk by chunk and copies records into the
+// mapping, so appending costs a memcpy and no system call. Unwritten space
+// is zero, and a record of kind zero ends the log, which keeps a log cut
+// short by a crash readable up to its last complete record.
+namespace TelemetryLog {
+
+enum Kind : quint8 {
+    End = 0,
+    Serial = 1,
+    Command = 2,
+    State = 3
+};
+
+// Where a logged command came from. Commands decided from serial samples
+// are the expected output of a replay; the others are inputs.
+enum Source : quint8 {
+    FromSerial = 0,
+    FromUser = 1
+};
+
+constexpr int HeaderSize = 16;
+constexpr int RecordHeaderSize = 12;
+constexpr quint16 Version = 1;
+constexpr int MaxPayload = 0xFFFF;
+
+} // namespace TelemetryLog
+
+class TelemetryWriter
+{
+public:
+    ~TelemetryWriter();
+
+    // Truncates path. The clock is LatencyMonitor::now().
+    bool open(const QString& path, qint64 startTime);
+    // Cuts the file to what was written
+    void close();
+    // False after close() or once a write failed (disk full)
+    bool isOpen() const { return chunk != nullptr; }
+    QString fileName() const { return file.fileName(); }
+    QString errorString() const { return file.errorString(); }
+    qint64 bytesWritten() const { return written; }
+
+    // Reads longer than MaxPayload are split
+    void appendSerial(const char* data, qint64 size, qint64 time);
+    void appendCommand(quint8 endpoint, quint8 source, const QString& command, int speed, qint64 time);
+    void appendState(const char* state, int size, qint64 time);
+
+private:
+    static constexpr qint64 ChunkSize = 1 << 20; // Multiple of the page size
+
+    QFile file;
+    uchar* chunk = nullptr;
+    qint64 chunkOffset = 0;     // File offset of the mapped chunk
+    qint64 written = 0;         // Bytes in the log, header included
+    qint64 startTime = 0;
+
+    void appendRecord(TelemetryLog::Kind kind, const char* payload, int size, qint64 time);
+    bool write(const char* data, qint64 size);
+    bool mapNextChunk();
+};
+
+class TelemetryReader
+{
+public:
+    struct Record {
+        qint64 time = 0;        // ns since the log started
+        TelemetryLog::Kind kind = TelemetryLog::End;
+        const char* data = nullptr;
+        int size = 0;
+    };
+
+    ~TelemetryReader();
+
+    // Maps the whole file read-only
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    QString errorString() const { return error; }
+    qint64 startedAt() const { return startMs; } // ms since epoch
+
+    // False at the end of the log or at a damaged record
+    bool next(Record& record);
+    void rewind() { offset = TelemetryLog::HeaderSize; }
+
+private:
+    QFile file;
+    const uchar* data = nullptr;
+    qint64 size = 0;
+    qint64 offset = 0;
+    qint64 startMs = 0;
+    QString error;
+};
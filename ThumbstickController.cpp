@@ -2,53 +2,60 @@
 
 ThumbstickController::ThumbstickController(QObject *parent)
     : QObject(parent)
-    , m_serialPort(new QSerialPort(this))
-    , m_serialPortName("/dev/serial0")
+    , m_worker(new ThumbstickWorker)
+    , m_latency(new LatencyMonitor(this))
     , m_isConnected(false)
+    , m_serialPortName("/dev/serial0")
     , m_thumbstickEnabled(false)
-    , m_networkManager(new QNetworkAccessManager(this))
     , m_carUrl("http://192.168.4.1") // Base URL without endpoint
-    , m_armRawX(512)
-    , m_armRawY(512)
-    , m_armCommand("stop")
-    , m_motorRawX(512)
-    , m_motorRawY(512)
-    , m_motorDirection("stop")
-    , m_motorSpeed(0)
-    , m_lastArmCommand("stop")
-    , m_lastMotorDirection("stop")
-    , m_lastMotorSpeed(0)
-    , m_lastButtonState("OPEN")
-    , m_buttonState("OPEN")
-    , m_centerX(512)
-    , m_centerY(512)
-    , m_deadzone(100)
-    , m_significantSpeedChange(20) // Only send HTTP request if speed changes by 20 or more
-{
-    // Setup serial port connections - CHANGED FOR QT6
-    connect(m_serialPort, &QSerialPort::readyRead,
-            this, &ThumbstickController::onSerialDataReady);
-
-    // Qt6 change: errorOccurred signal instead of QOverload syntax
-    connect(m_serialPort, &QSerialPort::errorOccurred,
-            this, &ThumbstickController::onSerialError);
-
-    // Setup network manager
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &ThumbstickController::onHttpRequestFinished);
+    , m_replayUrl("http://127.0.0.1:8080") // tools/car_stub_server
+    , m_recording(false)
+    , m_replaying(false)
+{
+    m_worker->setLatencyMonitor(m_latency);
+    m_worker->moveToThread(&m_inputThread);
+    connect(&m_inputThread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    // Worker signals arrive queued on the GUI thread
+    connect(m_worker, &ThumbstickWorker::stateChanged,
+            this, &ThumbstickController::onStateChanged);
+    connect(m_worker, &ThumbstickWorker::connectionChanged,
+            this, &ThumbstickController::onConnectionChanged);
+    connect(m_worker, &ThumbstickWorker::serialDataReceived,
+            this, &ThumbstickController::serialDataReceived);
+    connect(m_worker, &ThumbstickWorker::armControlReceived,
+            this, &ThumbstickController::armControlReceived);
+    connect(m_worker, &ThumbstickWorker::motorControlReceived,
+            this, &ThumbstickController::motorControlReceived);
+    connect(m_worker, &ThumbstickWorker::gripperControlReceived,
+            this, &ThumbstickController::gripperControlReceived);
+    connect(m_worker, &ThumbstickWorker::httpRequestSent,
+            this, &ThumbstickController::httpRequestSent);
+    connect(m_worker, &ThumbstickWorker::httpRequestFailed,
+            this, &ThumbstickController::httpRequestFailed);
+    connect(m_worker, &ThumbstickWorker::recordingChanged,
+            this, &ThumbstickController::onRecordingChanged);
+    connect(m_worker, &ThumbstickWorker::replayingChanged,
+            this, &ThumbstickController::onReplayingChanged);
+    connect(m_worker, &ThumbstickWorker::replayFinished,
+            this, &ThumbstickController::replayFinished);
+
+    m_inputThread.setObjectName("ThumbstickInput");
+    m_inputThread.start(QThread::HighPriority);
 }
 
 ThumbstickController::~ThumbstickController()
 {
-    if (m_serialPort->isOpen()) {
-        m_serialPort->close();
-    }
+    QMetaObject::invokeMethod(m_worker, &ThumbstickWorker::shutdown, Qt::BlockingQueuedConnection);
+    m_inputThread.quit();
+    m_inputThread.wait();
 }
 
 void ThumbstickController::setSerialPort(const QString& portName)
 {
     if (m_serialPortName != portName) {
         m_serialPortName = portName;
+        post([worker = m_worker, portName]() { worker->setSerialPort(portName); });
         emit serialPortChanged();
     }
 }
@@ -57,78 +64,67 @@ void ThumbstickController::setCarUrl(const QString& url)
 {
     if (m_carUrl != url) {
         m_carUrl = url;
+        post([worker = m_worker, url]() { worker->setCarUrl(url); });
         emit carUrlChanged();
     }
 }
 
+void ThumbstickController::setReplayUrl(const QString& url)
+{
+    if (m_replayUrl != url) {
+        m_replayUrl = url;
+        post([worker = m_worker, url]() { worker->setReplayUrl(url); });
+        emit replayUrlChanged();
+    }
+}
+
 void ThumbstickController::setThumbstickEnabled(bool enabled)
 {
     if (m_thumbstickEnabled != enabled) {
         m_thumbstickEnabled = enabled;
+        post([worker = m_worker, enabled]() { worker->setThumbstickEnabled(enabled); });
         emit thumbstickEnabledChanged();
-
-        // Send stop commands when disabled
-        if (!enabled) {
-            if (m_armCommand != "stop") {
-                sendHttpRequest("/arm", "stop", 0);
-                m_armCommand = "stop";
-                m_lastArmCommand = "stop";
-                emit armControlReceived(m_armCommand);
-            }
-            if (m_motorDirection != "stop") {
-                sendHttpRequest("/control", "stop", 0);
-                m_motorDirection = "stop";
-                m_motorSpeed = 0;
-                m_lastMotorDirection = "stop";
-                m_lastMotorSpeed = 0;
-                emit motorControlReceived(m_motorDirection, m_motorSpeed);
-            }
-        }
     }
 }
 
 void ThumbstickController::connectSerial()
 {
-    if (m_serialPort->isOpen()) {
-        m_serialPort->close();
-    }
+    post([worker = m_worker]() { worker->connectSerial(); });
+}
 
-    m_serialPort->setPortName(m_serialPortName);
-    m_serialPort->setBaudRate(QSerialPort::Baud115200);
-    m_serialPort->setDataBits(QSerialPort::Data8);
-    m_serialPort->setParity(QSerialPort::NoParity);
-    m_serialPort->setStopBits(QSerialPort::OneStop);
-    m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
+void ThumbstickController::disconnectSerial()
+{
+    post([worker = m_worker]() { worker->disconnectSerial(); });
+}
 
-    if (m_serialPort->open(QIODevice::ReadWrite)) {
-        m_isConnected = true;
-        qDebug() << "Thumbstick serial port connected:" << m_serialPortName;
-        emit connectionChanged();
-    } else {
-        m_isConnected = false;
-        qDebug() << "Failed to connect to thumbstick serial port:" << m_serialPort->errorString();
-        emit connectionChanged();
-    }
+void ThumbstickController::sendGripperCommand(const QString& command)
+{
+    post([worker = m_worker, command]() { worker->sendGripperCommand(command); });
 }
 
-void ThumbstickController::sendGripperCommand(const QString& command) {
-    sendHttpRequest("/arm", command, 0);
-    emit gripperControlReceived(command.toUpper());
+void ThumbstickController::sendDumperCommand(const QString& command)
+{
+    post([worker = m_worker, command]() { worker->sendDumperCommand(command); });
 }
 
-void ThumbstickController::disconnectSerial()
+void ThumbstickController::startRecording(const QString& path)
 {
-    if (m_serialPort->isOpen()) {
-        m_serialPort->close();
-    }
-    m_isConnected = false;
-    emit connectionChanged();
-    qDebug() << "Thumbstick serial port disconnected";
+    post([worker = m_worker, path]() { worker->startRecording(path); });
 }
 
-void ThumbstickController::sendDumperCommand(const QString& command) {
-    sendHttpRequest("/dumper", command, 0);
-    emit gripperControlReceived("DUMPER_" + command.toUpper());
+void ThumbstickController::stopRecording()
+{
+    post([worker = m_worker]() { worker->stopRecording(); });
+}
+
+void ThumbstickController::startReplay(const QString& path, double speed)
+{
+    post([worker = m_worker, path, speed]() { worker->startReplay(path, speed); });
+}
+
+void ThumbstickController::stopReplay()
+{
+    post([worker = m_worker]() { worker->stopReplay(); });
 }
 
 QStringList ThumbstickController::getAvailableSerialPorts()
@@ -141,248 +137,63 @@ QStringList ThumbstickController::getAvailableSerialPorts()
     return portNames;
 }
 
-void ThumbstickController::onSerialDataReady()
+void ThumbstickController::connectNotify(const QMetaMethod& signal)
 {
-    QByteArray data = m_serialPort->readAll();
-    m_serialBuffer.append(data);
-
-    // Process complete lines
-    while (m_serialBuffer.contains('\n')) {
-        int index = m_serialBuffer.indexOf('\n');
-        QByteArray line = m_serialBuffer.left(index);
-        m_serialBuffer.remove(0, index + 1);
-
-        QString lineStr = QString::fromUtf8(line).trimmed();
-        if (!lineStr.isEmpty()) {
-            parseArduinoData(lineStr);
-            emit serialDataReceived(lineStr);
-        }
+    // The worker only formats the serial echo while someone listens
+    if (signal == QMetaMethod::fromSignal(&ThumbstickController::serialDataReceived)) {
+        m_worker->setEchoEnabled(true);
     }
 }
 
-void ThumbstickController::parseArduinoData(const QString& data)
+void ThumbstickController::disconnectNotify(const QMetaMethod& signal)
 {
-    if (!m_thumbstickEnabled) {
-        return;
-    }
-
-    // Parse format: "X1=123, Y1=123, X2=123, Y2=123, BTN=OPEN"
-    QRegularExpression regex(R"(X1=(\d+),\s*Y1=(\d+),\s*X2=(\d+),\s*Y2=(\d+),\s*BTN=(\w+))");
-    QRegularExpressionMatch match = regex.match(data);
-
-    if (match.hasMatch()) {
-        // Motor data (X1, Y1)
-        int motorX = match.captured(1).toInt();
-        int motorY = match.captured(2).toInt();
-
-        // Arm data (X2, Y2)
-        int armX = match.captured(3).toInt();
-        int armY = match.captured(4).toInt();
-
-        // Button state
-        QString buttonState = match.captured(5);
-
-        // Process motor data
-        processMotorData(motorX, motorY);
-
-        // Process arm data
-        processArmData(armX, armY);
-
-        // Process button state for gripper
-        if (m_buttonState != buttonState) {
-            m_buttonState = buttonState;
-            emit buttonStateChanged();
-
-            // Send HTTP request for gripper control
-            QString gripperCommand = (buttonState == "CLOSE") ? "close" : "open";
-            if (m_lastButtonState != buttonState) {
-                sendHttpRequest("/arm", gripperCommand, 0);
-                m_lastButtonState = buttonState;
-                emit gripperControlReceived(buttonState);
-            }
-        }
+    if (signal == QMetaMethod::fromSignal(&ThumbstickController::serialDataReceived)) {
+        m_worker->setEchoEnabled(isSignalConnected(signal));
     }
 }
 
-void ThumbstickController::onSerialError(QSerialPort::SerialPortError error)
+void ThumbstickController::onConnectionChanged(bool connected)
 {
-    if (error != QSerialPort::NoError) {
-        qDebug() << "Thumbstick serial port error:" << m_serialPort->errorString();
-        m_isConnected = false;
-        emit connectionChanged();
-    }
+    m_isConnected = connected;
+    emit connectionChanged();
 }
 
-void ThumbstickController::processMotorData(int x, int y)
+void ThumbstickController::onRecordingChanged(bool recording, const QString& path)
 {
-    bool dataChanged = false;
-
-    if (m_motorRawX != x) {
-        m_motorRawX = x;
-        dataChanged = true;
-    }
-
-    if (m_motorRawY != y) {
-        m_motorRawY = y;
-        dataChanged = true;
-    }
-
-    // Calculate direction and speed
-    QString newDirection = calculateDirection(x, y, m_centerX, m_centerY, m_deadzone);
-    int newSpeed = calculateSpeed(x, y, m_centerX, m_centerY, m_deadzone);
-
-    bool commandChanged = false;
-    if (m_motorDirection != newDirection) {
-        m_motorDirection = newDirection;
-        commandChanged = true;
-        dataChanged = true;
-    }
-
-    if (m_motorSpeed != newSpeed) {
-        m_motorSpeed = newSpeed;
-        commandChanged = true;
-        dataChanged = true;
-    }
-
-    // Send HTTP request only if there's a significant change
-    if (commandChanged &&
-        (m_lastMotorDirection != newDirection ||
-         abs(m_lastMotorSpeed - newSpeed) >= m_significantSpeedChange ||
-         (newDirection == "stop" && m_lastMotorDirection != "stop"))) {
-
-        sendHttpRequest("/control", newDirection, newSpeed);
-        m_lastMotorDirection = newDirection;
-        m_lastMotorSpeed = newSpeed;
-        emit motorControlReceived(newDirection, newSpeed);
-    }
-
-    if (dataChanged) {
-        emit motorDataChanged();
+    m_recording = recording;
+    if (!path.isEmpty()) {
+        m_recordingPath = path;
     }
+    emit recordingChanged();
 }
 
-void ThumbstickController::processArmData(int x, int y)
+void ThumbstickController::onReplayingChanged(bool replaying)
 {
-    bool dataChanged = false;
-
-    if (m_armRawX != x) {
-        m_armRawX = x;
-        dataChanged = true;
-    }
-
-    if (m_armRawY != y) {
-        m_armRawY = y;
-        dataChanged = true;
-    }
-
-    // Calculate arm command (direction only, no speed for arm movement)
-    QString newCommand = calculateDirection(x, y, m_centerX, m_centerY, m_deadzone);
-
-    if (m_armCommand != newCommand) {
-        m_armCommand = newCommand;
-        dataChanged = true;
-
-        // Send HTTP request only when command actually changes
-        if (m_lastArmCommand != newCommand) {
-            // For arm control, we'll use a fixed speed or 0 for stop
-            int armSpeed = (newCommand == "stop") ? 0 : 200; // Fixed speed for arm movements
-            sendHttpRequest("/arm", newCommand, armSpeed);
-            m_lastArmCommand = newCommand;
-            emit armControlReceived(newCommand);
-        }
-    }
-
-    if (dataChanged) {
-        emit armDataChanged();
-    }
+    m_replaying = replaying;
+    emit replayingChanged();
 }
 
-QString ThumbstickController::calculateDirection(int x, int y, int centerX, int centerY, int deadzone)
+void ThumbstickController::onStateChanged(const ThumbstickState& state)
 {
-    int xDev = x - centerX;
-    int yDev = y - centerY;
+    const ThumbstickState previous = m_state;
+    m_state = state;
 
-    // Check deadzone
-    if (abs(xDev) <= deadzone && abs(yDev) <= deadzone) {
-        return "stop";
+    if (state.armRawX != previous.armRawX || state.armRawY != previous.armRawY
+        || state.armCommand != previous.armCommand) {
+        emit armDataChanged();
     }
-
-    // Determine dominant axis
-    if (abs(yDev) > abs(xDev) + 10) {  // Y dominant with some hysteresis
-        if (yDev > deadzone) {
-            return "forward";
-        } else if (yDev < -deadzone) {
-            return "backward";
-        }
-    } else {  // X dominant
-        if (xDev > deadzone) {
-            return "left";
-        } else if (xDev < -deadzone) {
-            return "right";
-        }
+    if (state.motorRawX != previous.motorRawX || state.motorRawY != previous.motorRawY
+        || state.motorDirection != previous.motorDirection || state.motorSpeed != previous.motorSpeed) {
+        emit motorDataChanged();
     }
-
-    return "stop";
-}
-
-int ThumbstickController::calculateSpeed(int x, int y, int centerX, int centerY, int deadzone)
-{
-    int xDev = x - centerX;
-    int yDev = y - centerY;
-
-    // Find the larger deviation
-    int maxDev = qMax(abs(xDev), abs(yDev));
-
-    if (maxDev <= deadzone) {
-        return 0;
+    if (state.buttonState != previous.buttonState) {
+        emit buttonStateChanged();
     }
-
-    // Calculate effective deviation after deadzone
-    int effectiveDev = maxDev - deadzone;
-    int maxRange = (1023 - qMax(centerX, centerY)) - deadzone;
-
-    // Map to 0-255 range
-    int speed = static_cast<int>((static_cast<float>(effectiveDev) / maxRange) * 255);
-
-    return qBound(0, speed, 255);
-}
-
-void ThumbstickController::sendHttpRequest(const QString& endpoint, const QString& direction, int speed)
-{
-    QJsonObject jsonData;
-    jsonData["direction"] = direction;
-    jsonData["speed"] = speed;
-
-    QJsonDocument doc(jsonData);
-    QByteArray data = doc.toJson();
-
-    QString fullUrl = m_carUrl + endpoint;
-    QNetworkRequest request{QUrl(fullUrl)};
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QNetworkReply* reply = m_networkManager->post(request, data);
-
-    // Store endpoint info in the reply for identification in the response handler
-    reply->setProperty("endpoint", endpoint);
-    reply->setProperty("direction", direction);
-    reply->setProperty("speed", speed);
-
-    emit httpRequestSent(endpoint, direction, speed);
-    qDebug() << "Sent HTTP request to" << fullUrl << ":" << data;
-}
-
-void ThumbstickController::onHttpRequestFinished(QNetworkReply* reply)
-{
-    QString endpoint = reply->property("endpoint").toString();
-    QString direction = reply->property("direction").toString();
-    int speed = reply->property("speed").toInt();
-
-    if (reply->error() == QNetworkReply::NoError) {
-        qDebug() << "HTTP request successful for" << endpoint << "- Direction:" << direction << "Speed:" << speed;
-    } else {
-        qDebug() << "HTTP request failed for" << endpoint << ":" << reply->errorString();
-        emit httpRequestFailed(endpoint, reply->errorString());
+    if (state.serialFrames != previous.serialFrames || state.malformedFrames != previous.malformedFrames) {
+        emit serialStatsChanged();
+    }
+    if (state.commandsSent != previous.commandsSent || state.commandsCoalesced != previous.commandsCoalesced
+        || state.commandsDropped != previous.commandsDropped) {
+        emit commandStatsChanged();
     }
-
-    reply->deleteLater();
 }
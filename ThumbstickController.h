@@ -1,17 +1,15 @@
 #pragma once
 
 #include <QObject>
-#include <QtSerialPort/QSerialPort>
+#include <QThread>
 #include <QtSerialPort/QSerialPortInfo>
-#include <QTimer>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QDebug>
-#include <QRegularExpression> // Explicitly include this for Qt6
+#include <QMetaMethod>
+#include "ThumbstickWorker.h"
 
+// QML face of the thumbstick input. The serial port, parsing and the
+// commands to the car run in a ThumbstickWorker on a dedicated input
+// thread; this object keeps the last state it published for the bindings
+// and forwards calls to it.
 class ThumbstickController : public QObject
 {
     Q_OBJECT
@@ -33,6 +31,25 @@ class ThumbstickController : public QObject
 
     Q_PROPERTY(QString buttonState READ buttonState NOTIFY buttonStateChanged)
     Q_PROPERTY(QString carUrl READ carUrl WRITE setCarUrl NOTIFY carUrlChanged)
+    // Where replayed commands go instead of the car, see ThumbstickWorker
+    Q_PROPERTY(QString replayUrl READ replayUrl WRITE setReplayUrl NOTIFY replayUrlChanged)
+
+    // Serial frames parsed and rejected since the port was opened
+    Q_PROPERTY(int serialFrames READ serialFrames NOTIFY serialStatsChanged)
+    Q_PROPERTY(int malformedFrames READ malformedFrames NOTIFY serialStatsChanged)
+
+    // Command scheduler counters, see CommandScheduler
+    Q_PROPERTY(int commandsSent READ commandsSent NOTIFY commandStatsChanged)
+    Q_PROPERTY(int commandsCoalesced READ commandsCoalesced NOTIFY commandStatsChanged)
+    Q_PROPERTY(int commandsDropped READ commandsDropped NOTIFY commandStatsChanged)
+
+    // Serial-to-reply latency per stage and endpoint
+    Q_PROPERTY(LatencyMonitor* latency READ latency CONSTANT)
+
+    // Telemetry recording and replay, see ThumbstickWorker
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(QString recordingPath READ recordingPath NOTIFY recordingChanged)
+    Q_PROPERTY(bool replaying READ replaying NOTIFY replayingChanged)
 
 public:
     explicit ThumbstickController(QObject *parent = nullptr);
@@ -43,22 +60,33 @@ public:
     QString serialPort() const { return m_serialPortName; }
     bool thumbstickEnabled() const { return m_thumbstickEnabled; }
 
-    int armRawX() const { return m_armRawX; }
-    int armRawY() const { return m_armRawY; }
-    QString armCommand() const { return m_armCommand; }
+    int armRawX() const { return m_state.armRawX; }
+    int armRawY() const { return m_state.armRawY; }
+    QString armCommand() const { return m_state.armCommand; }
 
-    int motorRawX() const { return m_motorRawX; }
-    int motorRawY() const { return m_motorRawY; }
-    QString motorDirection() const { return m_motorDirection; }
-    int motorSpeed() const { return m_motorSpeed; }
+    int motorRawX() const { return m_state.motorRawX; }
+    int motorRawY() const { return m_state.motorRawY; }
+    QString motorDirection() const { return m_state.motorDirection; }
+    int motorSpeed() const { return m_state.motorSpeed; }
 
-    QString buttonState() const { return m_buttonState; }
+    QString buttonState() const { return m_state.buttonState; }
     QString carUrl() const { return m_carUrl; }
+    QString replayUrl() const { return m_replayUrl; }
+    int serialFrames() const { return m_state.serialFrames; }
+    int malformedFrames() const { return m_state.malformedFrames; }
+    int commandsSent() const { return m_state.commandsSent; }
+    int commandsCoalesced() const { return m_state.commandsCoalesced; }
+    int commandsDropped() const { return m_state.commandsDropped; }
+    LatencyMonitor* latency() const { return m_latency; }
+    bool recording() const { return m_recording; }
+    QString recordingPath() const { return m_recordingPath; }
+    bool replaying() const { return m_replaying; }
 
     // Property setters
     void setSerialPort(const QString& portName);
     void setThumbstickEnabled(bool enabled);
     void setCarUrl(const QString& url);
+    void setReplayUrl(const QString& url);
 
 public slots:
     void connectSerial();
@@ -67,6 +95,13 @@ public slots:
     void sendGripperCommand(const QString& command);
     void sendDumperCommand(const QString& command);
 
+    // An empty path records to the app data directory
+    void startRecording(const QString& path = QString());
+    void stopRecording();
+    // Speed 1 is real time, 0 as fast as possible
+    void startReplay(const QString& path, double speed = 1.0);
+    void stopReplay();
+
 signals:
     void connectionChanged();
     void serialPortChanged();
@@ -79,53 +114,41 @@ signals:
     void buttonStateChanged();
     void gripperControlReceived(const QString& state);
     void carUrlChanged();
+    void replayUrlChanged();
     void httpRequestSent(const QString& endpoint, const QString& direction, int speed);
     void httpRequestFailed(const QString& endpoint, const QString& error);
+    void serialStatsChanged();
+    void commandStatsChanged();
+    void recordingChanged();
+    void replayingChanged();
+    void replayFinished(const QVariantMap& stats);
+
+protected:
+    void connectNotify(const QMetaMethod& signal) override;
+    void disconnectNotify(const QMetaMethod& signal) override;
 
 private slots:
-    void onSerialDataReady();
-    void onSerialError(QSerialPort::SerialPortError error);
-    void onHttpRequestFinished(QNetworkReply* reply);
+    void onStateChanged(const ThumbstickState& state);
+    void onConnectionChanged(bool connected);
+    void onRecordingChanged(bool recording, const QString& path);
+    void onReplayingChanged(bool replaying);
 
 private:
-    void processArmData(int x, int y);
-    void processMotorData(int x, int y);
-    void parseArduinoData(const QString& data);
-    QString calculateDirection(int x, int y, int centerX, int centerY, int deadzone);
-    int calculateSpeed(int x, int y, int centerX, int centerY, int deadzone);
-    void sendHttpRequest(const QString& endpoint, const QString& direction, int speed);
-
-    // Serial communication
-    QSerialPort* m_serialPort;
-    QString m_serialPortName;
+    // Runs f on the input thread
+    template<typename F>
+    void post(F&& f) { QMetaObject::invokeMethod(m_worker, std::forward<F>(f), Qt::QueuedConnection); }
+
+    QThread m_inputThread;
+    ThumbstickWorker* m_worker;
+    LatencyMonitor* m_latency;
+
     bool m_isConnected;
-    QByteArray m_serialBuffer;
+    QString m_serialPortName;
     bool m_thumbstickEnabled;
-
-    // HTTP communication
-    QNetworkAccessManager* m_networkManager;
     QString m_carUrl;
-
-    // Arm control data
-    int m_armRawX;
-    int m_armRawY;
-    QString m_armCommand;
-
-    // Motor control data
-    int m_motorRawX;
-    int m_motorRawY;
-    QString m_motorDirection;
-    int m_motorSpeed;
-
-    // Last values for change detection and rate limiting
-    QString m_lastArmCommand;
-    QString m_lastMotorDirection;
-    int m_lastMotorSpeed;
-    QString m_lastButtonState;
-
-    QString m_buttonState;
-    int m_centerX;
-    int m_centerY;
-    int m_deadzone;
-    int m_significantSpeedChange; // Minimum speed difference to trigger HTTP request
+    QString m_replayUrl;
+    bool m_recording;
+    QString m_recordingPath;
+    bool m_replaying;
+    ThumbstickState m_state;
 };
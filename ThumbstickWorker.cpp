@@ -0,0 +1,767 @@
+#include "ThumbstickWorker.h"
+#include "ControlFrame.h"
+#include "Logging.h"
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+
+// Records replayed per event loop turn at full speed, so replies from the
+// car are still handled
+constexpr int replayBatch = 256;
+
+quint8 directionCode(const QString& direction)
+{
+    return ControlFrame::commandCode(direction);
+}
+
+QString directionName(quint8 code)
+{
+    const QString name = ControlFrame::commandName(code);
+    return name.isEmpty() ? QStringLiteral("stop") : name;
+}
+
+// Compares replayed commands with recorded ones
+QString commandKey(const QString& endpoint, const QString& command, int speed)
+{
+    return endpoint + " " + command + " " + QString::number(speed);
+}
+
+} // namespace
+
+ThumbstickWorker::ThumbstickWorker(QObject *parent)
+    : QObject(parent)
+    , m_serialPort(new QSerialPort(this))
+    , m_serialPortName("/dev/serial0")
+    , m_thumbstickEnabled(false)
+    , m_networkManager(new QNetworkAccessManager(this))
+    , m_scheduler(new CommandScheduler(m_networkManager, this))
+    , m_carUrl("http://192.168.4.1") // Base URL without endpoint
+    , m_replayUrl("http://127.0.0.1:8080") // tools/car_stub_server
+    , m_armRawX(512)
+    , m_armRawY(512)
+    , m_armCommand("stop")
+    , m_motorRawX(512)
+    , m_motorRawY(512)
+    , m_motorDirection("stop")
+    , m_motorSpeed(0)
+    , m_lastArmCommand("stop")
+    , m_lastMotorDirection("stop")
+    , m_lastMotorSpeed(0)
+    , m_lastButtonState("OPEN")
+    , m_buttonState("OPEN")
+    , m_centerX(512)
+    , m_centerY(512)
+    , m_deadzone(100)
+    , m_significantSpeedChange(20) // Only send HTTP request if speed changes by 20 or more
+    , m_publishTimer(new QTimer(this))
+    , m_echoEnabled(false)
+    , m_latency(nullptr)
+    , m_sampleOrigin(0)
+    , m_replayTimer(new QTimer(this))
+    , m_replaying(false)
+    , m_replaySpeed(1.0)
+    , m_replayStartedAt(0)
+    , m_stateBeforeReplay()
+    , m_replayRecordPending(false)
+{
+    // Setup serial port connections - CHANGED FOR QT6
+    connect(m_serialPort, &QSerialPort::readyRead,
+            this, &ThumbstickWorker::onSerialDataReady);
+
+    // Qt6 change: errorOccurred signal instead of QOverload syntax
+    connect(m_serialPort, &QSerialPort::errorOccurred,
+            this, &ThumbstickWorker::onSerialError);
+
+    // Commands to the car, one in flight per endpoint
+    m_scheduler->setBaseUrl(m_carUrl);
+    connect(m_scheduler, &CommandScheduler::commandSent,
+            this, &ThumbstickWorker::httpRequestSent);
+    connect(m_scheduler, &CommandScheduler::commandFinished,
+            this, &ThumbstickWorker::onCommandFinished);
+    connect(m_scheduler, &CommandScheduler::commandFailed,
+            this, &ThumbstickWorker::onCommandFailed);
+    connect(m_scheduler, &CommandScheduler::statsChanged,
+            this, &ThumbstickWorker::markDirty);
+
+    // The UI gets at most one state update per interval however fast the
+    // serial data comes in
+    m_publishTimer->setSingleShot(true);
+    m_publishTimer->setInterval(33);
+    connect(m_publishTimer, &QTimer::timeout,
+            this, &ThumbstickWorker::publishState);
+
+    m_replayTimer->setSingleShot(true);
+    m_replayTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_replayTimer, &QTimer::timeout,
+            this, &ThumbstickWorker::replayNext);
+}
+
+void ThumbstickWorker::setLatencyMonitor(LatencyMonitor* monitor)
+{
+    m_latency = monitor;
+    m_scheduler->setLatencyMonitor(monitor);
+}
+
+void ThumbstickWorker::shutdown()
+{
+    m_publishTimer->stop();
+    m_replayTimer->stop();
+    stopRecording();
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+}
+
+void ThumbstickWorker::setSerialPort(const QString& portName)
+{
+    m_serialPortName = portName;
+}
+
+void ThumbstickWorker::setCarUrl(const QString& url)
+{
+    m_carUrl = url;
+    if (!m_replaying) {
+        m_scheduler->setBaseUrl(url);
+    }
+}
+
+void ThumbstickWorker::setReplayUrl(const QString& url)
+{
+    m_replayUrl = url;
+    if (m_replaying) {
+        m_scheduler->setBaseUrl(url);
+    }
+}
+
+void ThumbstickWorker::setThumbstickEnabled(bool enabled)
+{
+    if (m_thumbstickEnabled != enabled) {
+        m_thumbstickEnabled = enabled;
+
+        // Send stop commands when disabled
+        if (!enabled) {
+            if (m_armCommand != "stop") {
+                sendHttpRequest("/arm", "stop", 0);
+                m_armCommand = "stop";
+                m_lastArmCommand = "stop";
+                emit armControlReceived(m_armCommand);
+            }
+            if (m_motorDirection != "stop") {
+                sendHttpRequest("/control", "stop", 0);
+                m_motorDirection = "stop";
+                m_motorSpeed = 0;
+                m_lastMotorDirection = "stop";
+                m_lastMotorSpeed = 0;
+                emit motorControlReceived(m_motorDirection, m_motorSpeed);
+            }
+            markDirty();
+        }
+
+        if (m_recorder.isOpen()) {
+            recordState();
+        }
+    }
+}
+
+void ThumbstickWorker::connectSerial()
+{
+    stopReplay();
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+
+    m_serialPort->setPortName(m_serialPortName);
+    m_serialPort->setBaudRate(QSerialPort::Baud115200);
+    m_serialPort->setDataBits(QSerialPort::Data8);
+    m_serialPort->setParity(QSerialPort::NoParity);
+    m_serialPort->setStopBits(QSerialPort::OneStop);
+    m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
+
+    m_parser.reset();
+    markDirty();
+
+    if (m_serialPort->open(QIODevice::ReadWrite)) {
+        qCInfo(lcThumbstick) << "Thumbstick serial port connected:" << m_serialPortName;
+        emit connectionChanged(true);
+    } else {
+        qCWarning(lcThumbstick) << "Failed to connect to thumbstick serial port:" << m_serialPort->errorString();
+        emit connectionChanged(false);
+    }
+}
+
+void ThumbstickWorker::sendGripperCommand(const QString& command) {
+    sendHttpRequest("/arm", command, 0);
+    emit gripperControlReceived(command.toUpper());
+}
+
+void ThumbstickWorker::disconnectSerial()
+{
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+    emit connectionChanged(false);
+    qCInfo(lcThumbstick) << "Thumbstick serial port disconnected";
+}
+
+void ThumbstickWorker::sendDumperCommand(const QString& command) {
+    sendHttpRequest("/dumper", command, 0);
+    emit gripperControlReceived("DUMPER_" + command.toUpper());
+}
+
+void ThumbstickWorker::onSerialDataReady()
+{
+    // Read straight into the parser's ring and drain it after every read,
+    // so the ring always has room for the next one
+    for (;;) {
+        qsizetype space = 0;
+        char* target = m_parser.writeBuffer(space);
+        const qint64 count = m_serialPort->read(target, space);
+        if (count <= 0) {
+            break;
+        }
+        const qint64 readAt = LatencyMonitor::now();
+        if (m_recorder.isOpen()) {
+            m_recorder.appendSerial(target, count, readAt);
+            if (!m_recorder.isOpen()) {
+                qCWarning(lcThumbstick) << "Telemetry recording failed:" << m_recorder.errorString();
+                m_recorder.close();
+                emit recordingChanged(false, m_recorder.fileName());
+            }
+        }
+        m_parser.commit(count);
+        parseAvailable(readAt);
+    }
+}
+
+void ThumbstickWorker::feedSerial(const char* data, qint64 size, qint64 readAt)
+{
+    while (size > 0) {
+        qsizetype space = 0;
+        char* target = m_parser.writeBuffer(space);
+        const qsizetype count = qMin<qint64>(size, space);
+        if (count <= 0) {
+            break;
+        }
+        memcpy(target, data, count);
+        m_parser.commit(count);
+        parseAvailable(readAt);
+        data += count;
+        size -= count;
+    }
+}
+
+void ThumbstickWorker::parseAvailable(qint64 readAt)
+{
+    const quint64 malformedBefore = m_parser.malformedCount();
+    const quint64 framesBefore = m_parser.frameCount();
+    const bool echo = m_echoEnabled.load(std::memory_order_relaxed);
+
+    ThumbstickSample sample;
+    while (m_parser.next(sample)) {
+        if (m_latency) {
+            m_latency->recordParse(LatencyMonitor::now() - readAt);
+        }
+        qCDebug(lcSerial, "%s X1=%d Y1=%d X2=%d Y2=%d BTN=%s", sample.binary ? "bin" : "txt",
+                sample.motorX, sample.motorY, sample.armX, sample.armY, sample.button);
+        m_sampleOrigin = readAt;
+        processSample(sample);
+        m_sampleOrigin = 0;
+
+        // The debug echo is the only per-line allocation, skip it when
+        // nobody is listening
+        if (echo) {
+            emit serialDataReceived(sample.binary
+                ? QString::asprintf("X1=%d, Y1=%d, X2=%d, Y2=%d, BTN=%s", sample.motorX, sample.motorY,
+                                    sample.armX, sample.armY, sample.button)
+                : QString::fromLatin1(m_parser.lineData(), m_parser.lineLength()));
+        }
+    }
+
+    if (m_parser.malformedCount() != malformedBefore || m_parser.frameCount() != framesBefore) {
+        markDirty();
+    }
+}
+
+void ThumbstickWorker::processSample(const ThumbstickSample& sample)
+{
+    if (!m_thumbstickEnabled) {
+        return;
+    }
+
+    // Motor data (X1, Y1)
+    processMotorData(sample.motorX, sample.motorY);
+
+    // Arm data (X2, Y2)
+    processArmData(sample.armX, sample.armY);
+
+    // Process button state for gripper, only allocating when it changes
+    const QLatin1String buttonState(sample.button, sample.buttonLength);
+    if (m_buttonState != buttonState) {
+        m_buttonState = buttonState;
+        markDirty();
+
+        // Send HTTP request for gripper control
+        QString gripperCommand = (buttonState == QLatin1String("CLOSE")) ? "close" : "open";
+        if (m_lastButtonState != buttonState) {
+            sendHttpRequest("/arm", gripperCommand, 0);
+            m_lastButtonState = buttonState;
+            emit gripperControlReceived(buttonState);
+        }
+    }
+}
+
+void ThumbstickWorker::onSerialError(QSerialPort::SerialPortError error)
+{
+    if (error != QSerialPort::NoError) {
+        qCWarning(lcThumbstick) << "Thumbstick serial port error:" << m_serialPort->errorString();
+        emit connectionChanged(false);
+    }
+}
+
+void ThumbstickWorker::processMotorData(int x, int y)
+{
+    bool dataChanged = false;
+
+    if (m_motorRawX != x) {
+        m_motorRawX = x;
+        dataChanged = true;
+    }
+
+    if (m_motorRawY != y) {
+        m_motorRawY = y;
+        dataChanged = true;
+    }
+
+    // Calculate direction and speed
+    QString newDirection = calculateDirection(x, y, m_centerX, m_centerY, m_deadzone);
+    int newSpeed = calculateSpeed(x, y, m_centerX, m_centerY, m_deadzone);
+
+    bool commandChanged = false;
+    if (m_motorDirection != newDirection) {
+        m_motorDirection = newDirection;
+        commandChanged = true;
+        dataChanged = true;
+    }
+
+    if (m_motorSpeed != newSpeed) {
+        m_motorSpeed = newSpeed;
+        commandChanged = true;
+        dataChanged = true;
+    }
+
+    // Send HTTP request only if there's a significant change
+    if (commandChanged &&
+        (m_lastMotorDirection != newDirection ||
+         abs(m_lastMotorSpeed - newSpeed) >= m_significantSpeedChange ||
+         (newDirection == "stop" && m_lastMotorDirection != "stop"))) {
+
+        sendHttpRequest("/control", newDirection, newSpeed);
+        m_lastMotorDirection = newDirection;
+        m_lastMotorSpeed = newSpeed;
+        emit motorControlReceived(newDirection, newSpeed);
+    }
+
+    if (dataChanged) {
+        markDirty();
+    }
+}
+
+void ThumbstickWorker::processArmData(int x, int y)
+{
+    bool dataChanged = false;
+
+    if (m_armRawX != x) {
+        m_armRawX = x;
+        dataChanged = true;
+    }
+
+    if (m_armRawY != y) {
+        m_armRawY = y;
+        dataChanged = true;
+    }
+
+    // Calculate arm command (direction only, no speed for arm movement)
+    QString newCommand = calculateDirection(x, y, m_centerX, m_centerY, m_deadzone);
+
+    if (m_armCommand != newCommand) {
+        m_armCommand = newCommand;
+        dataChanged = true;
+
+        // Send HTTP request only when command actually changes
+        if (m_lastArmCommand != newCommand) {
+            // For arm control, we'll use a fixed speed or 0 for stop
+            int armSpeed = (newCommand == "stop") ? 0 : 200; // Fixed speed for arm movements
+            sendHttpRequest("/arm", newCommand, armSpeed);
+            m_lastArmCommand = newCommand;
+            emit armControlReceived(newCommand);
+        }
+    }
+
+    if (dataChanged) {
+        markDirty();
+    }
+}
+
+QString ThumbstickWorker::calculateDirection(int x, int y, int centerX, int centerY, int deadzone)
+{
+    int xDev = x - centerX;
+    int yDev = y - centerY;
+
+    // Check deadzone
+    if (abs(xDev) <= deadzone && abs(yDev) <= deadzone) {
+        return "stop";
+    }
+
+    // Determine dominant axis
+    if (abs(yDev) > abs(xDev) + 10) {  // Y dominant with some hysteresis
+        if (yDev > deadzone) {
+            return "forward";
+        } else if (yDev < -deadzone) {
+            return "backward";
+        }
+    } else {  // X dominant
+        if (xDev > deadzone) {
+            return "left";
+        } else if (xDev < -deadzone) {
+            return "right";
+        }
+    }
+
+    return "stop";
+}
+
+int ThumbstickWorker::calculateSpeed(int x, int y, int centerX, int centerY, int deadzone)
+{
+    int xDev = x - centerX;
+    int yDev = y - centerY;
+
+    // Find the larger deviation
+    int maxDev = qMax(abs(xDev), abs(yDev));
+
+    if (maxDev <= deadzone) {
+        return 0;
+    }
+
+    // Calculate effective deviation after deadzone
+    int effectiveDev = maxDev - deadzone;
+    int maxRange = (1023 - qMax(centerX, centerY)) - deadzone;
+
+    // Map to 0-255 range
+    int speed = static_cast<int>((static_cast<float>(effectiveDev) / maxRange) * 255);
+
+    return qBound(0, speed, 255);
+}
+
+void ThumbstickWorker::sendHttpRequest(const QString& endpoint, const QString& direction, int speed)
+{
+    // Replaces whatever is still waiting for this endpoint; httpRequestSent
+    // is emitted when the scheduler actually sends it
+    m_scheduler->submit(endpoint, direction, speed, m_sampleOrigin);
+
+    // Commands decided while a sample is processed are the pipeline's
+    // output; the rest (UI buttons, switching the thumbstick off) are input
+    const TelemetryLog::Source source = m_sampleOrigin ? TelemetryLog::FromSerial : TelemetryLog::FromUser;
+    if (m_recorder.isOpen()) {
+        m_recorder.appendCommand(ControlFrame::endpointCode(endpoint), source, direction, speed,
+                                 m_sampleOrigin ? m_sampleOrigin : LatencyMonitor::now());
+    }
+    if (m_replaying && source == TelemetryLog::FromSerial) {
+        m_replayDecided.push_back(commandKey(endpoint, direction, speed));
+        ++m_replayStats.commandsReplayed;
+    }
+    qCDebug(lcThumbstickCommand) << "Queued request to" << m_carUrl + endpoint << ":" << direction << speed;
+}
+
+void ThumbstickWorker::onCommandFinished(const QString& endpoint, const QString& direction, double roundTripMs)
+{
+    qCDebug(lcThumbstickCommand) << "HTTP request successful for" << endpoint << "- Direction:" << direction << "in" << roundTripMs << "ms";
+}
+
+void ThumbstickWorker::onCommandFailed(const QString& endpoint, const QString& error)
+{
+    qCWarning(lcThumbstick) << "HTTP request failed for" << endpoint << ":" << error;
+    emit httpRequestFailed(endpoint, error);
+}
+
+void ThumbstickWorker::markDirty()
+{
+    if (!m_publishTimer->isActive()) {
+        m_publishTimer->start();
+    }
+}
+
+void ThumbstickWorker::publishState()
+{
+    ThumbstickState state;
+    state.armRawX = m_armRawX;
+    state.armRawY = m_armRawY;
+    state.armCommand = m_armCommand;
+    state.motorRawX = m_motorRawX;
+    state.motorRawY = m_motorRawY;
+    state.motorDirection = m_motorDirection;
+    state.motorSpeed = m_motorSpeed;
+    state.buttonState = m_buttonState;
+    state.serialFrames = int(m_parser.frameCount());
+    state.malformedFrames = int(m_parser.malformedCount());
+    state.commandsSent = m_scheduler->sentCount();
+    state.commandsCoalesced = m_scheduler->coalescedCount();
+    state.commandsDropped = m_scheduler->droppedCount();
+    emit stateChanged(state);
+}
+
+void ThumbstickWorker::startRecording(const QString& path)
+{
+    stopRecording();
+    if (m_replaying) {
+        qCWarning(lcThumbstick) << "Cannot record telemetry during a replay";
+        emit recordingChanged(false, QString());
+        return;
+    }
+
+    QString target = path;
+    if (target.isEmpty()) {
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(directory);
+        target = directory + "/telemetry-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".rctl";
+    }
+
+    if (!m_recorder.open(target, LatencyMonitor::now())) {
+        qCWarning(lcThumbstick) << "Cannot record telemetry to" << target << ":" << m_recorder.errorString();
+        emit recordingChanged(false, QString());
+        return;
+    }
+
+    recordState();
+    qCInfo(lcThumbstick) << "Recording telemetry to" << target;
+    emit recordingChanged(true, target);
+}
+
+void ThumbstickWorker::stopRecording()
+{
+    if (!m_recorder.isOpen()) {
+        return;
+    }
+
+    const QString path = m_recorder.fileName();
+    const qint64 size = m_recorder.bytesWritten();
+    m_recorder.close();
+    qCInfo(lcThumbstick) << "Recorded" << size << "bytes of telemetry to" << path;
+    emit recordingChanged(false, path);
+}
+
+void ThumbstickWorker::sendStops()
+{
+    // Stops skip the scheduler's queue, so they go out before the base URL
+    // can change under them
+    sendHttpRequest("/control", "stop", 0);
+    sendHttpRequest("/arm", "stop", 0);
+    m_motorDirection = "stop";
+    m_motorSpeed = 0;
+    m_lastMotorDirection = "stop";
+    m_lastMotorSpeed = 0;
+    m_armCommand = "stop";
+    m_lastArmCommand = "stop";
+    emit motorControlReceived(m_motorDirection, m_motorSpeed);
+    emit armControlReceived(m_armCommand);
+    markDirty();
+}
+
+void ThumbstickWorker::saveState(char* state) const
+{
+    state[0] = char(m_thumbstickEnabled);
+    state[1] = char(directionCode(m_motorDirection));
+    state[2] = char(m_motorSpeed);
+    state[3] = char(directionCode(m_lastMotorDirection));
+    state[4] = char(m_lastMotorSpeed);
+    state[5] = char(directionCode(m_armCommand));
+    state[6] = char(directionCode(m_lastArmCommand));
+    state[7] = char(m_buttonState == "CLOSE");
+    state[8] = char(m_lastButtonState == "CLOSE");
+}
+
+void ThumbstickWorker::recordState()
+{
+    char state[stateSize];
+    saveState(state);
+    m_recorder.appendState(state, stateSize, LatencyMonitor::now());
+}
+
+void ThumbstickWorker::restoreState(const char* state, int size)
+{
+    if (size < stateSize) {
+        return;
+    }
+
+    const auto byte = [state](int i) { return quint8(state[i]); };
+    m_thumbstickEnabled = byte(0) != 0;
+    m_motorDirection = directionName(byte(1));
+    m_motorSpeed = byte(2);
+    m_lastMotorDirection = directionName(byte(3));
+    m_lastMotorSpeed = byte(4);
+    m_armCommand = directionName(byte(5));
+    m_lastArmCommand = directionName(byte(6));
+    m_buttonState = byte(7) ? "CLOSE" : "OPEN";
+    m_lastButtonState = byte(8) ? "CLOSE" : "OPEN";
+    markDirty();
+}
+
+void ThumbstickWorker::startReplay(const QString& path, double speed)
+{
+    stopReplay();
+
+    if (!m_replay.open(path)) {
+        qCWarning(lcThumbstick) << "Cannot replay" << path << ":" << m_replay.errorString();
+        emit replayFinished({{"completed", false}, {"error", m_replay.errorString()}});
+        return;
+    }
+
+    // Replays never come from or go into the hardware. The car loses its
+    // input with the serial port, so it is stopped before the commands
+    // switch over to the stub.
+    stopRecording();
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+        emit connectionChanged(false);
+    }
+    sendStops();
+    saveState(m_stateBeforeReplay);
+    m_scheduler->setBaseUrl(m_replayUrl);
+
+    m_parser.reset();
+    m_replayStats = ReplayStats();
+    m_replayStats.framesBefore = m_parser.frameCount();
+    m_replayStats.malformedBefore = m_parser.malformedCount();
+    m_replayDecided.clear();
+    m_replayRecordPending = false;
+    m_replaySpeed = speed;
+    m_replayStartedAt = LatencyMonitor::now();
+    m_replaying = true;
+
+    qCInfo(lcThumbstick) << "Replaying" << path << "to" << m_replayUrl << (speed > 0.0 ? QString::number(speed) + "x" : QString("at full speed"));
+    emit replayingChanged(true);
+    replayNext();
+}
+
+void ThumbstickWorker::stopReplay()
+{
+    if (m_replaying) {
+        finishReplay(false);
+    }
+}
+
+void ThumbstickWorker::replayNext()
+{
+    if (!m_replaying) {
+        return;
+    }
+
+    const bool paced = m_replaySpeed > 0.0;
+    const qint64 elapsed = LatencyMonitor::now() - m_replayStartedAt;
+    for (int replayed = 0;; ++replayed) {
+        if (!m_replayRecordPending) {
+            if (!m_replay.next(m_replayRecord)) {
+                finishReplay(true);
+                return;
+            }
+            m_replayRecordPending = true;
+        }
+
+        if (paced) {
+            const qint64 due = qint64(m_replayRecord.time / m_replaySpeed);
+            if (due > elapsed) {
+                m_replayTimer->start(int((due - elapsed) / 1000000));
+                return;
+            }
+        } else if (replayed == replayBatch) {
+            m_replayTimer->start(0);
+            return;
+        }
+
+        m_replayRecordPending = false;
+        replayRecord(m_replayRecord);
+    }
+}
+
+void ThumbstickWorker::replayRecord(const TelemetryReader::Record& record)
+{
+    ++m_replayStats.records;
+
+    switch (record.kind) {
+    case TelemetryLog::Serial:
+        m_replayStats.serialBytes += record.size;
+        feedSerial(record.data, record.size, LatencyMonitor::now());
+        break;
+    case TelemetryLog::Command: {
+        if (record.size < 3) {
+            break;
+        }
+        const QString endpoint = ControlFrame::endpointPath(quint8(record.data[0]));
+        const QString command = QString::fromLatin1(record.data + 3, record.size - 3);
+        const int speed = quint8(record.data[2]);
+        if (quint8(record.data[1]) != TelemetryLog::FromSerial) {
+            sendHttpRequest(endpoint, command, speed);
+            break;
+        }
+
+        // The replay has already decided this one from the same bytes
+        ++m_replayStats.commandsRecorded;
+        const QString expected = commandKey(endpoint, command, speed);
+        if (!m_replayDecided.empty() && m_replayDecided.front() == expected) {
+            m_replayDecided.pop_front();
+        } else {
+            qCDebug(lcThumbstick) << "Replay diverged: recorded" << expected << "decided"
+                                  << (m_replayDecided.empty() ? QString("nothing") : m_replayDecided.front());
+            ++m_replayStats.mismatches;
+            if (!m_replayDecided.empty()) {
+                m_replayDecided.pop_front();
+            }
+        }
+        break;
+    }
+    case TelemetryLog::State:
+        restoreState(record.data, record.size);
+        break;
+    default:
+        break;
+    }
+}
+
+void ThumbstickWorker::finishReplay(bool completed)
+{
+    m_replayTimer->stop();
+    m_replaying = false;
+
+    const qint64 elapsed = LatencyMonitor::now() - m_replayStartedAt;
+    const quint64 frames = m_parser.frameCount() - m_replayStats.framesBefore;
+    // Decisions the recording did not have
+    m_replayStats.mismatches += int(m_replayDecided.size());
+    m_replayDecided.clear();
+    m_replay.close();
+
+    // Whatever the log left moving is stopped where it was sent, then the
+    // car gets its URL and the input its state from before the replay back
+    sendStops();
+    m_scheduler->setBaseUrl(m_carUrl);
+    restoreState(m_stateBeforeReplay, stateSize);
+
+    QVariantMap stats;
+    stats["completed"] = completed;
+    stats["records"] = m_replayStats.records;
+    stats["serialBytes"] = m_replayStats.serialBytes;
+    stats["frames"] = frames;
+    stats["malformed"] = m_parser.malformedCount() - m_replayStats.malformedBefore;
+    stats["commandsRecorded"] = m_replayStats.commandsRecorded;
+    stats["commandsReplayed"] = m_replayStats.commandsReplayed;
+    stats["mismatches"] = m_replayStats.mismatches;
+    stats["elapsedMs"] = elapsed / 1e6;
+    stats["framesPerSecond"] = elapsed > 0 ? frames * 1e9 / elapsed : 0.0;
+
+    qCInfo(lcThumbstick) << "Replay" << (completed ? "finished:" : "stopped:") << frames << "frames in"
+                         << elapsed / 1e6 << "ms," << m_replayStats.mismatches << "mismatched commands";
+    markDirty();
+    emit replayingChanged(false);
+    emit replayFinished(stats);
+}
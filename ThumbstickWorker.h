@@ -0,0 +1,195 @@
+#pragma once
+
+#include <QObject>
+#include <QMetaType>
+#include <QtSerialPort/QSerialPort>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include <QVariantMap>
+#include <atomic>
+#include <deque>
+#include "CommandScheduler.h"
+#include "SerialFrameParser.h"
+#include "TelemetryLog.h"
+
+// What the UI shows of the thumbsticks, published by ThumbstickWorker
+struct ThumbstickState
+{
+    int armRawX = 512;
+    int armRawY = 512;
+    QString armCommand = "stop";
+
+    int motorRawX = 512;
+    int motorRawY = 512;
+    QString motorDirection = "stop";
+    int motorSpeed = 0;
+
+    QString buttonState = "OPEN";
+
+    int serialFrames = 0;
+    int malformedFrames = 0;
+
+    int commandsSent = 0;
+    int commandsCoalesced = 0;
+    int commandsDropped = 0;
+};
+
+Q_DECLARE_METATYPE(ThumbstickState)
+
+// Serial ingestion and command generation behind ThumbstickController.
+// Lives on the controller's input thread with its own serial port, network
+// manager and scheduler, so joystick-to-car latency does not depend on
+// what the GUI thread is doing. The UI only gets throttled state snapshots
+// and the discrete command events.
+//
+// The serial bytes and the commands can be recorded to a TelemetryLog and
+// replayed later through the same parser and processing, paced as recorded,
+// N times faster, or as fast as possible. Commands decided during a replay
+// are checked against the recorded ones and go to the replay URL, never the
+// car: by default tools/car_stub_server on this machine.
+class ThumbstickWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbstickWorker(QObject *parent = nullptr);
+
+    // Called from the GUI thread when serialDataReceived gains or loses
+    // its last listener
+    void setEchoEnabled(bool enabled) { m_echoEnabled.store(enabled, std::memory_order_relaxed); }
+    // Set before the worker moves to its thread
+    void setLatencyMonitor(LatencyMonitor* monitor);
+
+public slots:
+    void setSerialPort(const QString& portName);
+    void setThumbstickEnabled(bool enabled);
+    void setCarUrl(const QString& url);
+    void setReplayUrl(const QString& url);
+    void connectSerial();
+    void disconnectSerial();
+    void sendGripperCommand(const QString& command);
+    void sendDumperCommand(const QString& command);
+    // Closes the port before the thread stops
+    void shutdown();
+
+    // An empty path records to a new file in the app data directory
+    void startRecording(const QString& path);
+    void stopRecording();
+    // Speed 1 replays in recorded time, 0 as fast as possible. The car is
+    // stopped and the serial port closed while replaying; when the replay
+    // ends the stub is stopped too and the input state is put back.
+    void startReplay(const QString& path, double speed);
+    void stopReplay();
+
+signals:
+    void stateChanged(const ThumbstickState& state);
+    void connectionChanged(bool connected);
+    void serialDataReceived(const QString& data);
+    void armControlReceived(const QString& command);
+    void motorControlReceived(const QString& direction, int speed);
+    void gripperControlReceived(const QString& state);
+    void httpRequestSent(const QString& endpoint, const QString& direction, int speed);
+    void httpRequestFailed(const QString& endpoint, const QString& error);
+    void recordingChanged(bool recording, const QString& path);
+    void replayingChanged(bool replaying);
+    // records, serialBytes, frames, malformed, commandsRecorded,
+    // commandsReplayed, mismatches, elapsedMs, framesPerSecond, completed
+    void replayFinished(const QVariantMap& stats);
+
+private slots:
+    void onSerialDataReady();
+    void replayNext();
+    void onSerialError(QSerialPort::SerialPortError error);
+    void onCommandFinished(const QString& endpoint, const QString& direction, double roundTripMs);
+    void onCommandFailed(const QString& endpoint, const QString& error);
+    void markDirty();
+    void publishState();
+
+private:
+    void processArmData(int x, int y);
+    void processMotorData(int x, int y);
+    void processSample(const ThumbstickSample& sample);
+    // Runs the parser over what is in its ring
+    void parseAvailable(qint64 readAt);
+    // Copies bytes into the parser's ring and parses them, for replays
+    void feedSerial(const char* data, qint64 size, qint64 readAt);
+    QString calculateDirection(int x, int y, int centerX, int centerY, int deadzone);
+    int calculateSpeed(int x, int y, int centerX, int centerY, int deadzone);
+    void sendHttpRequest(const QString& endpoint, const QString& direction, int speed);
+
+    // Stops the motors and the arm wherever commands currently go
+    void sendStops();
+    // Enabled flag, last commands and button state, as in TelemetryLog::State
+    static constexpr int stateSize = 9;
+    void saveState(char* state) const;
+    void recordState();
+    void restoreState(const char* state, int size);
+    void replayRecord(const TelemetryReader::Record& record);
+    void finishReplay(bool completed);
+
+    // Serial communication
+    QSerialPort* m_serialPort;
+    QString m_serialPortName;
+    SerialFrameParser m_parser;
+    bool m_thumbstickEnabled;
+
+    // HTTP communication
+    QNetworkAccessManager* m_networkManager;
+    CommandScheduler* m_scheduler;
+    QString m_carUrl;
+    QString m_replayUrl;
+
+    // Arm control data
+    int m_armRawX;
+    int m_armRawY;
+    QString m_armCommand;
+
+    // Motor control data
+    int m_motorRawX;
+    int m_motorRawY;
+    QString m_motorDirection;
+    int m_motorSpeed;
+
+    // Last values for change detection and rate limiting
+    QString m_lastArmCommand;
+    QString m_lastMotorDirection;
+    int m_lastMotorSpeed;
+    QString m_lastButtonState;
+
+    QString m_buttonState;
+    int m_centerX;
+    int m_centerY;
+    int m_deadzone;
+    int m_significantSpeedChange; // Minimum speed difference to trigger HTTP request
+
+    // UI updates
+    QTimer* m_publishTimer;
+    std::atomic<bool> m_echoEnabled;
+
+    // Latency instrumentation; commands decided while a sample is being
+    // processed carry the time its bytes were read
+    LatencyMonitor* m_latency;
+    qint64 m_sampleOrigin;
+
+    // Telemetry
+    TelemetryWriter m_recorder;
+    TelemetryReader m_replay;
+    QTimer* m_replayTimer;
+    bool m_replaying;
+    double m_replaySpeed;
+    qint64 m_replayStartedAt;
+    char m_stateBeforeReplay[stateSize];
+    TelemetryReader::Record m_replayRecord;
+    bool m_replayRecordPending;
+    // Commands the replay decided that no recorded command has matched yet
+    std::deque<QString> m_replayDecided;
+    struct ReplayStats {
+        qint64 records = 0;
+        qint64 serialBytes = 0;
+        quint64 framesBefore = 0;
+        quint64 malformedBefore = 0;
+        int commandsRecorded = 0;
+        int commandsReplayed = 0;
+        int mismatches = 0;
+    } m_replayStats;
+};
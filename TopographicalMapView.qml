@@ -1,17 +1,18 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import PathfindingEngine 1.0
 
 Item {
     id: root
     width: 800
     height: 600
 
-    property real scaleX: width / 500
-    property real scaleY: height / 420
+    property var engine: null      // PathfindingEngine the map shows the graph of
     property point robotPosition: Qt.point(50,50)
-    property var optimalPath: []
+    property var optimalPath: null // RouteModel from the pathfinding engine
     property bool showConnections: true
     property bool showOptimalPath: false
+    property alias interactive: terrainMap.interactive
 
     property string hoveredNodeData: ""
     property point tooltipPosition: Qt.point(0, 0)
@@ -79,12 +80,6 @@ Item {
 
     }
 
-    property var nodeConnections: ({})
-
-    Component.onCompleted: {
-        calculateNodeConnections()
-    }
-
     // function getNodeByElementId(elementId) {
     //     for (let i = 0; i < nodeModel.count; i++) {
     //         let node = nodeModel.get(i)
@@ -102,306 +97,61 @@ Item {
     //     return null
     // }
 
-    function calculateNodeConnections() {
-        let connections = {}
-
-        for (let i = 0; i < nodeModel.count; i++) {
-            let node = nodeModel.get(i)
-            let nodeConnections = []
-
-            // Calculate distances to all other nodes
-            let distances = []
-            for (let j = 0; j < nodeModel.count; j++) {
-                if (i === j) continue
-
-                let otherNode = nodeModel.get(j)
-                let distance = Math.sqrt(
-                    Math.pow(node.x - otherNode.x, 2) +
-                    Math.pow(node.y - otherNode.y, 2)
-                )
-
-                distances.push({
-                    index: j,
-                    distance: distance,
-                    node: otherNode
-                })
-            }
-
-            // Sort by distance and take closest 6
-            distances.sort(function(a, b) { return a.distance - b.distance })
-
-            for (let k = 0; k < Math.min(6, distances.length); k++) {
-                nodeConnections.push({
-                    targetIndex: distances[k].index,
-                    distance: distances[k].distance,
-                    cost: calculatePathCost(node, distances[k].node, distances[k].distance)
-                })
-            }
-
-            connections[node.elementId] = nodeConnections
-        }
-
-        nodeConnections = connections
-        // console.log(JSON.stringify(nodeConnections, null, 2))
-    }
-
-    function calculatePathCost(node1, node2, distance) {
-        // Calculate cost based on distance and height difference
-        let heightDiff = Math.abs(node1.elevation - node2.elevation)
-        let terrainMultiplier = 1 + (heightDiff / 50) // Adjust as needed
-        return distance * terrainMultiplier
-    }
-
     function checkNodeHover(mouseX, mouseY) {
-        for (let i = 0; i < nodeModel.count; i++) {
-            let node = nodeModel.get(i)
-            let nodeX = node.x * scaleX
-            let nodeY = node.y * scaleY
-            let radius = node.type === "keystone" ? 7 : node.type === "comm_tow" || node.type === "star_ball" ? 8 : 6
+        if (!engine) {
+            showTooltip = false
+            return
+        }
 
-            let distance = Math.sqrt(Math.pow(mouseX - nodeX, 2) + Math.pow(mouseY - nodeY, 2))
+        // Grid lookup in arena units; markers are 6-8 px plus a little tolerance
+        let point = terrainMap.mapToArena(Qt.point(mouseX, mouseY))
+        let nodeId = engine.nodeAt(point.x, point.y, 10 / terrainMap.viewScale)
+        if (nodeId === "") {
+            showTooltip = false
+            return
+        }
 
-            if (distance <= radius + 2) { // Add small tolerance
-                // Show elevation for keystone, start, and release nodes
-                if (node.type === "keystone" || node.type === "start_a" || node.type === "start_b" || node.type === "release") {
-                    hoveredNodeData = "Elevation: " + node.elevation + "cm"
-                }
-                // Show points for ball nodes and communication tower
-                else if (node.type === "green_ball" || node.type === "black_striped_ball" || node.type === "star_ball" || node.type === "comm_tow") {
-                    hoveredNodeData = "Points: " + node.points
-                }
+        let node = engine.nodeData(nodeId)
 
-                tooltipPosition = Qt.point(mouseX + 10, mouseY - 10)
-                showTooltip = true
-                return
-            }
+        // Show elevation for keystone, start, and release nodes
+        if (node.type === "keystone" || node.type === "start_a" || node.type === "start_b" || node.type === "release") {
+            hoveredNodeData = "Elevation: " + node.elevation + "cm"
+        }
+        // Show points for ball nodes and communication tower
+        else if (node.type === "green_ball" || node.type === "black_striped_ball" || node.type === "star_ball" || node.type === "comm_tow") {
+            hoveredNodeData = "Points: " + node.points
         }
 
-        showTooltip = false
+        tooltipPosition = Qt.point(mouseX + 10, mouseY - 10)
+        showTooltip = true
     }
 
     function getNodeByElementId(elementId) {
-        for (let i = 0; i < nodeModel.count; i++) {
-            let node = nodeModel.get(i)
-            if (node.elementId === elementId) {
-                return node
-            }
+        if (!engine) {
+            return null
         }
-        return null
+        let node = engine.nodeData(elementId)
+        return node.elementId !== undefined ? node : null
     }
 
     function refresh() {
-       terrainMap.requestPaint()
+       terrainMap.update()
    }
 
-    Canvas {
+    ArenaMapItem {
         id: terrainMap
         anchors.fill: parent
 
-        onPaint: {
-            let ctx = getContext("2d")
-            ctx.clearRect(0, 0, width, height)
-
-            if(showConnections){
-                drawNodeConnections(ctx)
-            }
-
-            if(showOptimalPath && optimalPath.length > 0){
-                drawOptimalPath(ctx)
-            }
-
-            drawNodes(ctx)
-
-            // drawRobot(ctx)
-        }
-
-        function drawNodes(ctx){
-            for(let i=0; i < nodeModel.count; i++){
-                let node = nodeModel.get(i)
-                let x = node.x * scaleX
-                let y = node.y * scaleY
-
-                ctx.save()
-
-                // Check if this node is in the optimal path
-                let isInPath = false
-                for (let j = 0; j < optimalPath.length; j++) {
-                    if (optimalPath[j].elementId === node.elementId) {
-                        isInPath = true
-                        break
-                    }
-                }
-
-                switch(node.type){
-                    case "keystone":
-                        ctx.fillStyle = isInPath ? "#FF6B35" : "#7B3F00"
-                        ctx.strokeStyle = isInPath ? "#FF0000" : "#CDC1FF"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "start_a":
-                        ctx.fillStyle = isInPath ? "#0066FF" : "blue"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "black"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "start_b":
-                        ctx.fillStyle = isInPath ? "#FF3366" : "red"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "black"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "release":
-                        ctx.fillStyle = isInPath ? "#66D9EF" : "#89A8B2"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "#C1BAA1"
-                        ctx.lineWidth = isInPath ? 3 : 2
-                        break
-                    case "green_ball":
-                        ctx.fillStyle = isInPath ? "#66FF66" : "#41ab5d"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "#238b45"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "black_striped_ball":
-                        ctx.fillStyle = isInPath ? "#666666" : "black"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "#74c476"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "star_ball":
-                        ctx.fillStyle = isInPath ? "#FFD700" : "gold"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "black"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                    case "comm_tow":
-                        ctx.fillStyle = isInPath ? "#FFFF66" : "yellow"
-                        ctx.strokeStyle = isInPath ? "#FFFFFF" : "black"
-                        ctx.lineWidth = isInPath ? 3 : 1
-                        break
-                }
-
-                ctx.beginPath()
-                ctx.arc(x,y, node.type === "keystone" ? 7 : node.type === "comm_tow" || node.type === "star_ball" ? 8 : 6, 0, 2 * Math.PI)
-                ctx.fill()
-                ctx.stroke()
-
-                ctx.restore()
-            }
-        }
-
-        function drawNodeConnections(ctx) {
-           ctx.strokeStyle = "black"
-           ctx.lineWidth = 1
-           ctx.globalAlpha = 0.3
-
-           for (let nodeId in nodeConnections) {
-               let sourceNode = null
-               let sourceIndex = -1
-
-               // Find source node
-               for (let i = 0; i < nodeModel.count; i++) {
-                   if (nodeModel.get(i).elementId === nodeId) {
-                       sourceNode = nodeModel.get(i)
-                       sourceIndex = i
-                       break
-                   }
-               }
-
-               if (!sourceNode) continue
-
-               let connections = nodeConnections[nodeId]
-               for (let j = 0; j < connections.length; j++) {
-                   let targetNode = nodeModel.get(connections[j].targetIndex)
-
-                   ctx.beginPath()
-                   ctx.moveTo(sourceNode.x * scaleX, sourceNode.y * scaleY)
-                   ctx.lineTo(targetNode.x * scaleX, targetNode.y * scaleY)
-                   ctx.stroke()
-               }
-           }
-
-           ctx.globalAlpha = 1.0
-        }
-
-        function drawOptimalPath(ctx) {
-            if (optimalPath.length < 2) return
-
-            ctx.strokeStyle = "#FF0000"
-            ctx.lineWidth = 4
-            ctx.globalAlpha = 0.8
-
-            // Draw path segments
-            for (let k = 0; k < optimalPath.length - 1; k++) {
-                let currentNode = optimalPath[k]
-                let nextNode = optimalPath[k + 1]
-
-                let x1 = currentNode.x * scaleX
-                let y1 = currentNode.y * scaleY
-                let x2 = nextNode.x * scaleX
-                let y2 = nextNode.y * scaleY
-
-                ctx.beginPath()
-                ctx.moveTo(x1, y1)
-                ctx.lineTo(x2, y2)
-                ctx.stroke()
-            }
-
-            // Draw direction arrows
-            ctx.fillStyle = "black"
-            ctx.globalAlpha = 1.0
-
-            for (let l = 0; l < optimalPath.length - 1; l++) {
-                let currentNode = optimalPath[l]
-                let nextNode = optimalPath[l + 1]
-
-                let x1 = currentNode.x * scaleX
-                let y1 = currentNode.y * scaleY
-                let x2 = nextNode.x * scaleX
-                let y2 = nextNode.y * scaleY
-
-                // Calculate arrow position (midpoint)
-                let midX = (x1 + x2) / 2
-                let midY = (y1 + y2) / 2
-
-                // Calculate angle
-                let angle = Math.atan2(y2 - y1, x2 - x1)
-
-                // Draw arrow
-                ctx.save()
-                ctx.translate(midX, midY)
-                ctx.rotate(angle)
-
-                ctx.beginPath()
-                ctx.moveTo(8, 0)
-                ctx.lineTo(-4, -3)
-                ctx.lineTo(-4, 3)
-                ctx.closePath()
-                ctx.fill()
-
-                ctx.restore()
-            }
-
-            // Draw path sequence numbers
-            ctx.fillStyle = "#FFFFFF"
-            ctx.font = "12px Arial"
-            ctx.textAlign = "center"
-            ctx.textBaseline = "middle"
-
-            for (let i = 0; i < optimalPath.length; i++) {
-                let node = optimalPath[i]
-                let x = node.x * scaleX
-                let y = node.y * scaleY
-
-                // Draw background circle for number
-                ctx.fillStyle = "black"
-                ctx.beginPath()
-                ctx.arc(x + 10, y - 10, 8, 0, 2 * Math.PI)
-                ctx.fill()
-
-                // Draw number
-                ctx.fillStyle = "#FFFFFF"
-                ctx.fillText((i + 1).toString(), x + 10, y - 10)
-            }
-        }
+        engine: root.engine
+        route: root.optimalPath
+        showConnections: root.showConnections
+        showOptimalPath: root.showOptimalPath
+        robotPosition: root.robotPosition
 
         MouseArea {
             anchors.fill: parent
             hoverEnabled: true
+            acceptedButtons: Qt.NoButton // Presses pan the map
 
             onPositionChanged: {
                 checkNodeHover(mouseX, mouseY)
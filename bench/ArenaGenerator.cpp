@@ -0,0 +1,159 @@
+#include "ArenaGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+#include "PlannerGraph.h"
+
+namespace {
+
+struct GeneratedNode {
+    QString elementId;
+    QString type;
+    double x;
+    double y;
+    double elevation;
+    int points;
+};
+
+// Node mix of the competition arena, besides the two starts and the release
+const struct {
+    const char* type;
+    const char* prefix;
+    int share;
+    int points;
+} kNodeMix[] = {
+    {"keystone", "k", 14, 0},
+    {"green_ball", "b", 5, 5},
+    {"black_striped_ball", "b", 10, 10},
+    {"star_ball", "b", 2, 40},
+    {"comm_tow", "comm_tow", 1, 60},
+};
+
+} // namespace
+
+SyntheticArena ArenaGenerator::generate(const ArenaSpec& spec)
+{
+    std::mt19937 rng(spec.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    const int nodeCount = std::max(3, spec.nodeCount);
+
+    // Keep the node density of the 500 x 420 competition arena
+    const double scale = std::sqrt(nodeCount / 35.0);
+    const double width = 500 * scale;
+    const double height = 420 * scale;
+
+    // Hills: a few bumps per 35 nodes, clamped and stepped like the arena
+    struct Hill { double x, y, radius, peak; };
+    std::vector<Hill> hills(std::max(1, nodeCount / 35 * 2));
+    for (Hill& hill : hills) {
+        hill = {unit(rng) * width, unit(rng) * height, 30 + unit(rng) * 60, 18 + unit(rng) * 36};
+    }
+    auto elevationAt = [&hills](double x, double y) {
+        double elevation = 0.0;
+        for (const Hill& hill : hills) {
+            double dx = (x - hill.x) / hill.radius;
+            double dy = (y - hill.y) / hill.radius;
+            double d2 = dx * dx + dy * dy;
+            if (d2 < 9.0) {
+                elevation += hill.peak * std::exp(-d2);
+            }
+        }
+        return std::min(45.0, std::round(elevation / 9) * 9);
+    };
+
+    std::vector<GeneratedNode> nodes;
+    nodes.reserve(nodeCount);
+    nodes.push_back({"start_a", "start_a", 0.12 * width, 0.15 * height, 0, 0});
+    nodes.push_back({"start_b", "start_b", 0.88 * width, 0.80 * height, 0, 0});
+    nodes.push_back({"release", "release", 0.80 * width, 0.24 * height, 0, 0});
+
+    const int remaining = nodeCount - 3;
+    int totalShare = 0;
+    for (const auto& mix : kNodeMix) {
+        totalShare += mix.share;
+    }
+
+    // Pick the type of every remaining node by share, keystones fill up
+    // whatever the collectible cap leaves
+    std::vector<int> typeOfNode;
+    typeOfNode.reserve(remaining);
+    int collectibles = 0;
+    int ballNumber = 0;
+    int towerNumber = 0;
+    for (int mixIndex = 1; mixIndex < static_cast<int>(std::size(kNodeMix)); ++mixIndex) {
+        int count = std::max(1, remaining * kNodeMix[mixIndex].share / totalShare);
+        count = std::min(count, spec.maxCollectibles - collectibles);
+        for (int i = 0; i < count; ++i) {
+            typeOfNode.push_back(mixIndex);
+        }
+        collectibles += std::max(0, count);
+    }
+    typeOfNode.resize(remaining, 0);
+    std::shuffle(typeOfNode.begin(), typeOfNode.end(), rng);
+
+    int keystoneNumber = 0;
+    for (int mixIndex : typeOfNode) {
+        const auto& mix = kNodeMix[mixIndex];
+        GeneratedNode node;
+        node.type = mix.type;
+        node.points = mix.points;
+        node.x = unit(rng) * width;
+        node.y = unit(rng) * height;
+
+        if (mixIndex == 0) {
+            node.elementId = QString("k%1").arg(++keystoneNumber);
+        } else if (node.type == "comm_tow") {
+            node.elementId = towerNumber++ == 0 ? QString("comm_tow") : QString("comm_tow%1").arg(towerNumber);
+        } else {
+            node.elementId = QString("b%1").arg(++ballNumber);
+        }
+
+        nodes.push_back(node);
+    }
+
+    for (GeneratedNode& node : nodes) {
+        node.elevation = node.type.startsWith("start") || node.type == "release" ? 0 : elevationAt(node.x, node.y);
+    }
+
+    SyntheticArena arena;
+    for (const GeneratedNode& node : nodes) {
+        QVariantMap nodeMap;
+        nodeMap["elementId"] = node.elementId;
+        nodeMap["x"] = node.x;
+        nodeMap["y"] = node.y;
+        nodeMap["elevation"] = node.elevation;
+        nodeMap["type"] = node.type;
+        nodeMap["points"] = node.points;
+        arena.nodes.append(nodeMap);
+
+        if (node.type.startsWith("start")) {
+            arena.startIds.append(node.elementId);
+        } else if (node.type == "release") {
+            arena.releaseId = node.elementId;
+        } else if (node.points > 0) {
+            arena.collectibleIds.append(node.elementId);
+        }
+    }
+
+    // Same connectivity as PathfindingEngine::buildGraph, exported in the
+    // setConnections() format so both loading paths can be measured
+    PlannerGraph graph;
+    graph.loadNodes(arena.nodes);
+    graph.buildNearestNeighbours(spec.neighbours, EdgeCostModel::Elevation);
+    for (int source = 0; source < graph.graph.nodeCount(); ++source) {
+        QVariantList connectionList;
+        for (int e = graph.graph.edgeBegin(source); e < graph.graph.edgeEnd(source); ++e) {
+            QVariantMap connection;
+            connection["targetId"] = graph.nodeIds[graph.graph.edgeTargets[e]];
+            connection["distance"] = graph.graph.edgeDistances[e];
+            connection["cost"] = graph.graph.edgeCosts[e];
+            connectionList.append(connection);
+        }
+        arena.connections[graph.nodeIds[source]] = connectionList;
+    }
+
+    return arena;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+
+// What to generate. The defaults give an arena that looks like the one in
+// TopographicalMapView.qml: same node-type mix, same node density, hills
+// up to 45 cm in 9 cm steps and 6 nearest-neighbour connections per node.
+struct ArenaSpec {
+    int nodeCount = 35;
+    unsigned int seed = 1;
+    int neighbours = 6;
+    // Real arenas have a few dozen balls at most; bigger arenas get more
+    // keystones instead of more balls
+    int maxCollectibles = 64;
+};
+
+struct SyntheticArena {
+    QVariantList nodes;        // Same fields as the QML node model
+    QVariantMap connections;   // As PathfindingEngine::setConnections() expects
+    QStringList startIds;
+    QString releaseId;
+    QStringList collectibleIds;
+};
+
+// Seeded generator for benchmark arenas, the same spec always gives the
+// same arena.
+class ArenaGenerator
+{
+public:
+    static SyntheticArena generate(const ArenaSpec& spec);
+};
@@ -0,0 +1,429 @@
+// Planner benchmarks on synthetic arenas, without the QML UI.
+//
+//   pathfinding_bench [--sizes 50,1000,10000,100000] [--seed 1]
+//                     [--queries 100] [--routes 10]
+//
+// Micro benchmarks call RoutePlanner directly on a warmed-up snapshot;
+// macro benchmarks go through PathfindingEngine's QML-facing API,
+// including graph loading and the first (cold) call of every planner.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <queue>
+#include <random>
+#include <vector>
+#include "ArenaGenerator.h"
+#include "GeneticRouteSolver.h"
+#include "PathfindingEngine.h"
+#include "RoutePlanner.h"
+
+namespace {
+std::atomic<long long> allocationCount{0};
+}
+
+// Count every heap allocation in the process
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace {
+
+long long allocations()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// Latency samples in microseconds plus whatever the benchmark counts
+struct Samples {
+    std::vector<double> micros;
+    long long allocations = 0;
+    double quality = 0.0;
+    long long expansions = 0;
+
+    void add(double us) { micros.push_back(us); }
+
+    double percentile(double p)
+    {
+        if (micros.empty()) {
+            return 0.0;
+        }
+        std::sort(micros.begin(), micros.end());
+        size_t index = std::min(micros.size() - 1, static_cast<size_t>(p * micros.size()));
+        return micros[index];
+    }
+
+    double total() const
+    {
+        double sum = 0.0;
+        for (double us : micros) {
+            sum += us;
+        }
+        return sum;
+    }
+};
+
+void printLatency(const char* name, Samples& samples)
+{
+    const double count = std::max<size_t>(1, samples.micros.size());
+    std::printf("  %-32s n=%-4zu p50 %9.1f us  p90 %9.1f us  p99 %9.1f us  max %9.1f us  allocs/call %8.1f",
+                name, samples.micros.size(),
+                samples.percentile(0.50), samples.percentile(0.90),
+                samples.percentile(0.99), samples.percentile(1.0),
+                samples.allocations / count);
+}
+
+double pathCost(const NavGraph& graph, const std::vector<int>& path)
+{
+    double cost = 0.0;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        double step = std::numeric_limits<double>::infinity();
+        for (int e = graph.edgeBegin(path[i]); e < graph.edgeEnd(path[i]); ++e) {
+            if (graph.edgeTargets[e] == path[i + 1]) {
+                step = std::min(step, graph.edgeCosts[e]);
+            }
+        }
+        cost += step;
+    }
+    return cost;
+}
+
+// Reference costs for judging route quality
+double dijkstraCost(const NavGraph& graph, int startNode, int endNode)
+{
+    std::vector<double> dist(graph.nodeCount(), std::numeric_limits<double>::infinity());
+    using Entry = std::pair<double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    dist[startNode] = 0.0;
+    open.emplace(0.0, startNode);
+    while (!open.empty()) {
+        auto [d, node] = open.top();
+        open.pop();
+        if (node == endNode) {
+            return d;
+        }
+        if (d > dist[node]) {
+            continue;
+        }
+        for (int e = graph.edgeBegin(node); e < graph.edgeEnd(node); ++e) {
+            double next = d + graph.edgeCosts[e];
+            if (next < dist[graph.edgeTargets[e]]) {
+                dist[graph.edgeTargets[e]] = next;
+                open.emplace(next, graph.edgeTargets[e]);
+            }
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+void benchFindPath(const std::shared_ptr<const PlannerGraph>& snapshot, int queries, std::mt19937& rng)
+{
+    const NavGraph& graph = snapshot->graph;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<double> optimal;
+    for (int i = 0; i < queries; ++i) {
+        int startNode = rng() % graph.nodeCount();
+        int endNode = (startNode + 1 + rng() % (graph.nodeCount() - 1)) % graph.nodeCount();
+        pairs.emplace_back(startNode, endNode);
+        optimal.push_back(dijkstraCost(graph, startNode, endNode));
+    }
+
+    QElapsedTimer buildTimer;
+    buildTimer.start();
+    std::shared_ptr<const Landmarks> landmarks = snapshot->landmarks();
+    std::printf("  %-32s %d landmarks in %.1f ms\n", "landmark build", landmarks->count(), buildTimer.nsecsElapsed() / 1e6);
+    buildTimer.restart();
+    std::shared_ptr<const ContractionHierarchy> hierarchy = snapshot->hierarchy();
+    std::printf("  %-32s %d shortcuts in %.1f ms\n", "hierarchy build", hierarchy->shortcutCount(), buildTimer.nsecsElapsed() / 1e6);
+
+    // Every search answers the same queries, so expansions compare directly
+    struct Mode {
+        const char* name;
+        PathSearch search;
+    };
+    const Mode modes[] = {
+        {"findPath (astar)", PathSearch::AStar},
+        {"findPath (landmarks)", PathSearch::Landmarks},
+        {"findPath (bidirectional)", PathSearch::Bidirectional},
+        {"findPath (hierarchy)", PathSearch::Hierarchy},
+    };
+
+    double baseExpansions = 0.0;
+    for (const Mode& mode : modes) {
+        RoutePlanner planner(snapshot, 1);
+        Samples samples;
+        double ratioSum = 0.0;
+        int found = 0;
+
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            long long allocationsBefore = allocations();
+            QElapsedTimer timer;
+            timer.start();
+            std::vector<int> path = planner.findPath(pairs[i].first, pairs[i].second, mode.search);
+            samples.add(timer.nsecsElapsed() / 1000.0);
+            samples.allocations += allocations() - allocationsBefore;
+            samples.expansions += planner.lastExpansions();
+
+            if (!path.empty()) {
+                ratioSum += pathCost(graph, path) / std::max(1e-9, optimal[i]);
+                ++found;
+            }
+        }
+
+        const double meanExpansions = samples.expansions / std::max<double>(1, pairs.size());
+        if (mode.search == PathSearch::AStar) {
+            baseExpansions = meanExpansions;
+        }
+        printLatency(mode.name, samples);
+        std::printf("  expansions/query %9.1f (%5.1fx fewer)  cost/optimal %.4f\n",
+                    meanExpansions, baseExpansions / std::max(1.0, meanExpansions),
+                    found > 0 ? ratioSum / found : 0.0);
+    }
+}
+
+void benchCollectionRoute(const std::shared_ptr<const PlannerGraph>& snapshot,
+                          const SyntheticArena& arena,
+                          int targetCount,
+                          int runs,
+                          std::mt19937& rng)
+{
+    if (arena.collectibleIds.size() < targetCount) {
+        return;
+    }
+
+    const int startNode = snapshot->indexOf(arena.startIds.first());
+    Samples samples;
+    double costSum = 0.0;
+    int proven = 0;
+
+    for (int run = 0; run < runs; ++run) {
+        QStringList ids = arena.collectibleIds;
+        std::shuffle(ids.begin(), ids.end(), rng);
+        std::vector<int> targets;
+        for (int i = 0; i < targetCount; ++i) {
+            targets.push_back(snapshot->indexOf(ids[i]));
+        }
+
+        RoutePlanner planner(snapshot, rng());
+        long long allocationsBefore = allocations();
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<int> route = planner.findOptimalCollectionRoute(startNode, targets);
+        samples.add(timer.nsecsElapsed() / 1000.0);
+        samples.allocations += allocations() - allocationsBefore;
+
+        costSum += pathCost(snapshot->graph, route);
+        proven += planner.lastRouteProvenOptimal() ? 1 : 0;
+    }
+
+    QByteArray name = QString("collection, %1 targets").arg(targetCount).toUtf8();
+    printLatency(name.constData(), samples);
+    std::printf("  mean cost %9.1f  proven optimal %d/%d\n", costSum / runs, proven, runs);
+}
+
+void benchBallRoute(const std::shared_ptr<const PlannerGraph>& snapshot,
+                    const SyntheticArena& arena,
+                    int carryCapacity,
+                    int runs,
+                    std::mt19937& rng)
+{
+    const int releaseNode = snapshot->indexOf(arena.releaseId);
+    Samples samples;
+    double valueSum = 0.0;
+
+    for (int run = 0; run < runs; ++run) {
+        const int startNode = snapshot->indexOf(arena.startIds[run % arena.startIds.size()]);
+
+        RoutePlanner planner(snapshot, rng());
+        long long allocationsBefore = allocations();
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<int> route = planner.findOptimalBallCollectionRoute(startNode, releaseNode, carryCapacity);
+        samples.add(timer.nsecsElapsed() / 1000.0);
+        samples.allocations += allocations() - allocationsBefore;
+
+        valueSum += planner.calculateRouteValue(route, releaseNode);
+    }
+
+    QByteArray name = QString("ball route, capacity %1").arg(carryCapacity).toUtf8();
+    printLatency(name.constData(), samples);
+    std::printf("  mean points/cost %.4f\n", valueSum / runs);
+}
+
+// The GA sizes all of its buffers before the first generation, so a run
+// must allocate the same amount no matter how many generations it does
+void benchGeneticAllocations(int targetCount, std::mt19937& rng)
+{
+    const int stride = targetCount + 1;
+    std::vector<double> costs(stride * stride);
+    for (double& cost : costs) {
+        cost = 1.0 + rng() % 1000;
+    }
+
+    long long perRun[2];
+    const int generations[2] = {100, 1000};
+    for (int i = 0; i < 2; ++i) {
+        GeneticSettings settings;
+        settings.islandCount = 2;
+        settings.generations = generations[i];
+        GeneticRouteSolver solver(settings);
+
+        long long allocationsBefore = allocations();
+        solver.solve(costs, targetCount, 1);
+        perRun[i] = allocations() - allocationsBefore;
+    }
+
+    std::printf("  %-32s %lld allocations per generation (%lld at %d generations, %lld at %d)\n",
+                "GA steady state",
+                (perRun[1] - perRun[0]) / (generations[1] - generations[0]),
+                perRun[0], generations[0], perRun[1], generations[1]);
+}
+
+void benchEngine(const SyntheticArena& arena)
+{
+    PathfindingEngine engine;
+    engine.setRandomSeed(1);
+
+    QElapsedTimer timer;
+    timer.start();
+    engine.setNodes(arena.nodes);
+    engine.setConnections(arena.connections);
+    std::printf("  %-32s %9.1f ms\n", "load (setNodes+setConnections)", timer.nsecsElapsed() / 1e6);
+
+    {
+        // Fresh engine, setNodes() would re-resolve the connections above
+        PathfindingEngine builtEngine;
+        timer.restart();
+        builtEngine.setNodes(arena.nodes);
+        builtEngine.buildGraph(6, "elevation");
+        std::printf("  %-32s %9.1f ms\n", "load (setNodes+buildGraph)", timer.nsecsElapsed() / 1e6);
+    }
+
+    const QString startId = arena.startIds.first();
+
+    timer.restart();
+    engine.findPath(startId, arena.releaseId);
+    std::printf("  %-32s %9.1f ms\n", "findPath, first call", timer.nsecsElapsed() / 1e6);
+
+    // The same query again, as the start/release buttons send it
+    timer.restart();
+    engine.findPath(startId, arena.releaseId);
+    const QVariantMap cacheStats = engine.pathCacheStats();
+    std::printf("  %-32s %9.3f ms  (hit rate %.2f, %lld bytes cached)\n", "findPath, repeated",
+                timer.nsecsElapsed() / 1e6, cacheStats["hitRate"].toDouble(), static_cast<long long>(cacheStats["bytes"].toLongLong()));
+
+    QVariantList targets;
+    for (int i = 0; i < std::min<int>(3, arena.collectibleIds.size()); ++i) {
+        targets.append(arena.collectibleIds[i]);
+    }
+    timer.restart();
+    engine.findOptimalCollectionRoute(startId, targets);
+    std::printf("  %-32s %9.1f ms  (includes the distance table)\n", "collection, first call", timer.nsecsElapsed() / 1e6);
+
+    timer.restart();
+    engine.findOptimalBallCollectionRoute(startId, arena.releaseId, 8);
+    std::printf("  %-32s %9.1f ms\n", "ball route, first call", timer.nsecsElapsed() / 1e6);
+
+    // The same graph and distance table through a binary arena file
+    const QString arenaPath = QDir::temp().filePath("pathfinding_bench.arena");
+    if (engine.saveArena(arenaPath, true)) {
+        PathfindingEngine arenaEngine;
+        timer.restart();
+        arenaEngine.loadArena(arenaPath);
+        std::printf("  %-32s %9.1f ms\n", "load (loadArena)", timer.nsecsElapsed() / 1e6);
+
+        timer.restart();
+        arenaEngine.findOptimalCollectionRoute(startId, targets);
+        std::printf("  %-32s %9.1f ms  (stored distance table)\n", "collection, after loadArena", timer.nsecsElapsed() / 1e6);
+        QFile::remove(arenaPath);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pathfinding planner benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma-separated arena sizes in nodes.", "list", "50,1000,10000,100000");
+    QCommandLineOption seedOption("seed", "Arena and query seed.", "seed", "1");
+    QCommandLineOption queriesOption("queries", "findPath queries per arena.", "count", "100");
+    QCommandLineOption routesOption("routes", "Route planner runs per arena.", "count", "10");
+    parser.addOption(sizesOption);
+    parser.addOption(seedOption);
+    parser.addOption(queriesOption);
+    parser.addOption(routesOption);
+    parser.process(app);
+
+    // The planners log every route, which would swamp the results
+    QLoggingCategory::setFilterRules("*.debug=false\nrccar.planner.info=false");
+
+    const unsigned int seed = parser.value(seedOption).toUInt();
+    const int queries = parser.value(queriesOption).toInt();
+    const int routes = std::max(1, parser.value(routesOption).toInt());
+
+    for (const QString& sizeText : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+        ArenaSpec spec;
+        spec.nodeCount = sizeText.toInt();
+        spec.seed = seed;
+
+        QElapsedTimer timer;
+        timer.start();
+        SyntheticArena arena = ArenaGenerator::generate(spec);
+        std::printf("== %d nodes, %lld collectibles, seed %u (generated in %.1f ms)\n",
+                    spec.nodeCount, static_cast<long long>(arena.collectibleIds.size()), seed,
+                    timer.nsecsElapsed() / 1e6);
+
+        std::printf(" macro\n");
+        benchEngine(arena);
+
+        auto snapshot = std::make_shared<PlannerGraph>();
+        snapshot->loadNodes(arena.nodes);
+        snapshot->loadConnections(arena.connections);
+        snapshot->keyDistances();
+
+        std::printf(" micro\n");
+        std::mt19937 rng(seed);
+        benchFindPath(snapshot, queries, rng);
+        for (int targetCount : {3, 12, 20}) {
+            benchCollectionRoute(snapshot, arena, targetCount, routes, rng);
+        }
+        for (int carryCapacity : {3, 8}) {
+            benchBallRoute(snapshot, arena, carryCapacity, routes, rng);
+        }
+    }
+
+    std::printf("== allocations\n");
+    std::mt19937 rng(seed);
+    benchGeneticAllocations(30, rng);
+
+    return 0;
+}
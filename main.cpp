@@ -2,6 +2,7 @@
 // #include <QQmlApplicationEngine>
 // #include <QQmlContext>
 // #include "PathfindingEngine.h"
+#include "ArenaMapItem.h"
 // #include "CarController.h"
 // #include <QFile>
 
@@ -67,19 +68,49 @@
 //    return app.exec();
 //}
 
+#include <QCommandLineParser>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include "PathfindingEngine.h"
 #include "CarController.h"
+#include "Logging.h"
 #include "ThumbstickController.h"
 
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
 
+    // Logging: --log-rules "rccar.car.command.debug=true", and
+    // --log-file/--log-format to write records to a file instead of stderr
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption logRulesOption("log-rules", "Logging filter rules, QT_LOGGING_RULES syntax.", "rules");
+    const QCommandLineOption logFileOption("log-file", "Write the log to this file.", "path");
+    const QCommandLineOption logFormatOption("log-format", "Log file format: text or binary.", "format", "text");
+    parser.addOption(logRulesOption);
+    parser.addOption(logFileOption);
+    parser.addOption(logFormatOption);
+    const QCommandLineOption arenaOption("arena", "Arena file to plan on instead of the built-in map.", "file");
+    parser.addOption(arenaOption);
+    parser.process(app);
+
+    if (parser.isSet(logRulesOption)) {
+        Logging::setRules(parser.value(logRulesOption).replace(';', '\n'));
+    }
+    Logging::installAsyncSink(parser.value(logFileOption),
+                              parser.value(logFormatOption) == "binary" ? Logging::Format::Binary
+                                                                         : Logging::Format::Text);
+
     // Register PathfindingEngine type
     qmlRegisterType<PathfindingEngine>("PathfindingEngine", 1, 0, "PathfindingEngine");
+    qmlRegisterUncreatableType<RouteModel>("PathfindingEngine", 1, 0, "RouteModel",
+                                           "Routes come from PathfindingEngine");
+    qmlRegisterType<ArenaMapItem>("PathfindingEngine", 1, 0, "ArenaMapItem");
+    qmlRegisterUncreatableType<CommandScheduler>("PathfindingEngine", 1, 0, "CommandScheduler",
+                                                 "Schedulers belong to the controllers");
+    qmlRegisterUncreatableType<LatencyMonitor>("PathfindingEngine", 1, 0, "LatencyMonitor",
+                                               "Latency monitors belong to the controllers");
 
     QQmlApplicationEngine engine;
 
@@ -116,5 +147,13 @@ int main(int argc, char *argv[])
 
     engine.load(url);
 
-    return app.exec();
+    // After the map view has pushed its own nodes
+    if (parser.isSet(arenaOption)) {
+        pathfindingEngine.loadArena(parser.value(arenaOption));
+        pathfindingEngine.setWatchArenaFile(true);
+    }
+
+    const int result = app.exec();
+    Logging::shutdown();
+    return result;
 }
@@ -0,0 +1,153 @@
+// Converts an arena description into the binary arena format that
+// PathfindingEngine::loadArena (and the app's --arena option) reads.
+//
+//   arena_convert TopographicalMapView.qml practice.arena --tables
+//   arena_convert field.json field.arena --neighbours 8
+//
+// Input is either the ListElement node model of a QML map view, or JSON:
+// an array of nodes as passed to setNodes(), or an object with "nodes" and
+// optionally "connections" as passed to setConnections(). Without
+// connections every node is connected to its nearest neighbours, as
+// buildGraph() does.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include "ArenaFile.h"
+
+namespace {
+
+// Every ListElement { key: value; ... } of the file, outside // comments
+QVariantList readQmlNodes(const QString& source)
+{
+    static const QRegularExpression comment(QStringLiteral("//[^\\n]*"));
+    static const QRegularExpression element(QStringLiteral("ListElement\\s*\\{([^}]*)\\}"));
+    static const QRegularExpression field(QStringLiteral("(\\w+)\\s*:\\s*(\"[^\"]*\"|[-+0-9.eE]+)"));
+
+    QString text = source;
+    text.remove(comment);
+
+    QVariantList nodes;
+    for (auto elements = element.globalMatch(text); elements.hasNext();) {
+        const QString body = elements.next().captured(1);
+        QVariantMap node;
+        for (auto fields = field.globalMatch(body); fields.hasNext();) {
+            const QRegularExpressionMatch match = fields.next();
+            const QString value = match.captured(2);
+            if (value.startsWith('"')) {
+                node.insert(match.captured(1), value.mid(1, value.size() - 2));
+            } else {
+                node.insert(match.captured(1), value.toDouble());
+            }
+        }
+        nodes.append(node);
+    }
+    return nodes;
+}
+
+bool readJson(const QByteArray& source, QVariantList& nodes, QVariantMap& connections, QString& error)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(source, &parseError);
+    if (document.isNull()) {
+        error = parseError.errorString();
+        return false;
+    }
+
+    if (document.isArray()) {
+        nodes = document.toVariant().toList();
+    } else {
+        const QVariantMap root = document.object().toVariantMap();
+        nodes = root["nodes"].toList();
+        connections = root["connections"].toMap();
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts a QML or JSON arena into a binary arena file");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Map view .qml with a ListElement node model, or .json");
+    parser.addPositionalArgument("output", "Arena file to write");
+    const QCommandLineOption neighboursOption("neighbours", "Nearest neighbours per node when the input has no connections", "k", "6");
+    const QCommandLineOption costModelOption("cost-model", "Edge costs of generated connections: elevation or distance", "model", "elevation");
+    const QCommandLineOption tablesOption("tables", "Precompute the key node distance table and the landmark costs");
+    parser.addOptions({neighboursOption, costModelOption, tablesOption});
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QFile input(arguments[0]);
+    if (!input.open(QIODevice::ReadOnly)) {
+        err << arguments[0] << ": " << input.errorString() << Qt::endl;
+        return 1;
+    }
+    const QByteArray source = input.readAll();
+
+    QVariantList nodes;
+    QVariantMap connections;
+    if (arguments[0].endsWith(".qml", Qt::CaseInsensitive)) {
+        nodes = readQmlNodes(QString::fromUtf8(source));
+    } else {
+        QString error;
+        if (!readJson(source, nodes, connections, error)) {
+            err << arguments[0] << ": " << error << Qt::endl;
+            return 1;
+        }
+    }
+    if (nodes.isEmpty()) {
+        err << arguments[0] << ": no nodes found" << Qt::endl;
+        return 1;
+    }
+
+    PlannerGraph graph;
+    ArenaFile::Info info;
+    graph.loadNodes(nodes);
+    if (!connections.isEmpty()) {
+        graph.loadConnections(connections);
+    } else {
+        info.neighbours = qMax(1, parser.value(neighboursOption).toInt());
+        info.costModel = parser.value(costModelOption) == "distance" ? EdgeCostModel::Distance
+                                                                      : EdgeCostModel::Elevation;
+        graph.buildNearestNeighbours(info.neighbours, info.costModel);
+    }
+
+    QString error;
+    if (!ArenaFile::save(arguments[1], graph, info, parser.isSet(tablesOption), &error)) {
+        err << arguments[1] << ": " << error << Qt::endl;
+        return 1;
+    }
+
+    // What loading it costs, which is the point of the format
+    PlannerGraph loaded;
+    QElapsedTimer timer;
+    timer.start();
+    if (!ArenaFile::load(arguments[1], loaded, info, &error)) {
+        err << arguments[1] << ": written but unreadable: " << error << Qt::endl;
+        return 1;
+    }
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+
+    out << arguments[1] << ": " << graph.graph.nodeCount() << " nodes, " << graph.graph.edgeCount()
+        << " connections, " << QFileInfo(arguments[1]).size() << " bytes, loads in " << loadMs << " ms"
+        << Qt::endl;
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Stand-in for the car firmware, for trying the control paths without
+// hardware. Accepts the HTTP API (POST /control, /arm, /dumper with a JSON
+// body) and the binary control channel, and acknowledges everything.
+//
+//   car_stub_server --http-port 8080 --port 5005 --delay 5
+//
+// then point the app at http://127.0.0.1:8080 with channel port 5005.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include "ControlFrame.h"
+
+namespace {
+
+struct Options
+{
+    int delayMs = 0;
+    bool verbose = false;
+};
+
+struct Counters
+{
+    quint64 frames = 0;
+    quint64 badBytes = 0;
+    quint64 httpRequests = 0;
+};
+
+QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+// Sends now or after the simulated processing delay
+void reply(QTcpSocket* socket, const QByteArray& bytes, const Options& options)
+{
+    if (options.delayMs <= 0) {
+        socket->write(bytes);
+        return;
+    }
+
+    QPointer<QTcpSocket> target(socket);
+    QTimer::singleShot(options.delayMs, socket, [target, bytes]() {
+        if (target) {
+            target->write(bytes);
+        }
+    });
+}
+
+void serveBinary(QTcpSocket* socket, QByteArray& buffer, const Options& options, Counters& counters)
+{
+    buffer.append(socket->readAll());
+
+    qsizetype offset = 0;
+    while (buffer.size() - offset >= ControlFrame::Size) {
+        ControlFrame frame;
+        if (!ControlFrame::decode(buffer.constData() + offset, frame)) {
+            ++offset;
+            ++counters.badBytes;
+            continue;
+        }
+        offset += ControlFrame::Size;
+        ++counters.frames;
+
+        if (frame.type == ControlFrame::Ack) {
+            continue;
+        }
+
+        ControlFrame ack = frame;
+        ack.type = ControlFrame::Ack;
+        if (frame.type == ControlFrame::Command) {
+            const QString command = ControlFrame::commandName(frame.command);
+            const QString endpoint = ControlFrame::endpointPath(frame.endpoint);
+            ack.status = command.isEmpty() || endpoint.isEmpty() ? ControlFrame::UnknownCommand : ControlFrame::Ok;
+            if (options.verbose) {
+                out() << "frame " << frame.sequence << " " << endpoint << " " << command
+                      << " " << frame.speed << Qt::endl;
+            }
+        }
+
+        QByteArray bytes(ControlFrame::Size, Qt::Uninitialized);
+        ack.encode(bytes.data());
+        reply(socket, bytes, options);
+    }
+    buffer.remove(0, offset);
+}
+
+// Just enough HTTP/1.1 for QNetworkAccessManager: keep-alive requests with a
+// Content-Length body
+void serveHttp(QTcpSocket* socket, QByteArray& buffer, const Options& options, Counters& counters)
+{
+    buffer.append(socket->readAll());
+
+    for (;;) {
+        const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QByteArray header = buffer.left(headerEnd);
+        qsizetype contentLength = 0;
+        for (const QByteArray& line : header.split('\n')) {
+            const QByteArray trimmed = line.trimmed();
+            if (trimmed.toLower().startsWith("content-length:")) {
+                contentLength = trimmed.mid(15).trimmed().toLongLong();
+            }
+        }
+
+        const qsizetype requestSize = headerEnd + 4 + contentLength;
+        if (buffer.size() < requestSize) {
+            return;
+        }
+
+        ++counters.httpRequests;
+        if (options.verbose) {
+            const QByteArray requestLine = header.left(header.indexOf('\r'));
+            out() << requestLine << " " << buffer.mid(headerEnd + 4, contentLength) << Qt::endl;
+        }
+        buffer.remove(0, requestSize);
+
+        static const QByteArray body = "{\"status\":\"ok\"}";
+        reply(socket,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+              "Connection: keep-alive\r\n\r\n" + body,
+              options);
+    }
+}
+
+using Handler = void (*)(QTcpSocket*, QByteArray&, const Options&, Counters&);
+
+bool listen(QTcpServer* server, quint16 port, Handler handler, const Options& options, Counters& counters)
+{
+    QObject::connect(server, &QTcpServer::newConnection, server, [server, handler, &options, &counters]() {
+        while (QTcpSocket* socket = server->nextPendingConnection()) {
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            auto* buffer = new QByteArray;
+            QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket, buffer, handler, &options, &counters]() {
+                handler(socket, *buffer, options, counters);
+            });
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, [socket, buffer]() {
+                delete buffer;
+                socket->deleteLater();
+            });
+        }
+    });
+
+    if (!server->listen(QHostAddress::Any, port)) {
+        out() << "Cannot listen on port " << port << ": " << server->errorString() << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in car server for the control channels");
+    parser.addHelpOption();
+    const QCommandLineOption httpPortOption("http-port", "HTTP API port", "port", "8080");
+    const QCommandLineOption portOption("port", "Binary control channel port", "port", "5005");
+    const QCommandLineOption delayOption("delay", "Simulated processing time per command", "ms", "0");
+    const QCommandLineOption verboseOption("verbose", "Print every command");
+    parser.addOptions({httpPortOption, portOption, delayOption, verboseOption});
+    parser.process(app);
+
+    Options options;
+    options.delayMs = parser.value(delayOption).toInt();
+    options.verbose = parser.isSet(verboseOption);
+    Counters counters;
+
+    QTcpServer httpServer;
+    QTcpServer binaryServer;
+    if (!listen(&httpServer, parser.value(httpPortOption).toUShort(), serveHttp, options, counters)
+        || !listen(&binaryServer, parser.value(portOption).toUShort(), serveBinary, options, counters)) {
+        return 1;
+    }
+
+    out() << "HTTP on " << httpServer.serverPort() << ", binary channel on " << binaryServer.serverPort() << Qt::endl;
+
+    // One summary line a second while there is traffic
+    QTimer stats;
+    Counters reported;
+    QObject::connect(&stats, &QTimer::timeout, [&counters, &reported]() {
+        if (counters.frames == reported.frames && counters.httpRequests == reported.httpRequests) {
+            return;
+        }
+        out() << "frames " << counters.frames - reported.frames
+              << "/s, http " << counters.httpRequests - reported.httpRequests
+              << "/s, bad bytes " << counters.badBytes << Qt::endl;
+        reported = counters;
+    });
+    stats.start(1000);
+
+    return app.exec();
+}
@@ -0,0 +1,67 @@
+// Replays a thumbstick telemetry log through ThumbstickWorker without the
+// GUI or the hardware, and prints what the input pipeline did with it.
+// At --speed 0 it doubles as a throughput benchmark of parsing and
+// command decisions.
+//
+//   car_stub_server &
+//   thumbstick_replay telemetry-20260101-120000.rctl --speed 0
+//
+// Commands go to --replay-url, the stub server by default.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include "LatencyMonitor.h"
+#include "ThumbstickWorker.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a thumbstick telemetry log");
+    parser.addHelpOption();
+    parser.addPositionalArgument("log", "Telemetry log recorded by the app");
+    const QCommandLineOption speedOption("speed", "Replay speed, 0 for as fast as possible", "factor", "1");
+    const QCommandLineOption replayUrlOption("replay-url", "Where the commands go", "url", "http://127.0.0.1:8080");
+    const QCommandLineOption latencyOption("latency", "Print the latency summary as CSV");
+    parser.addOptions({speedOption, replayUrlOption, latencyOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    LatencyMonitor latency;
+    ThumbstickWorker worker;
+    worker.setLatencyMonitor(&latency);
+    worker.setReplayUrl(parser.value(replayUrlOption));
+
+    const bool printLatency = parser.isSet(latencyOption);
+    QObject::connect(&worker, &ThumbstickWorker::replayFinished,
+                     [&app, &latency, printLatency](const QVariantMap& stats) {
+        QTextStream out(stdout);
+        if (stats.contains("error")) {
+            out << "Replay failed: " << stats["error"].toString() << Qt::endl;
+            app.exit(1);
+            return;
+        }
+        for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+            out << it.key() << ": " << it.value().toString() << Qt::endl;
+        }
+        if (printLatency) {
+            out << latency.toCsv();
+        }
+        out.flush();
+        // Mismatched commands mean the pipeline no longer decides what it
+        // decided when the log was recorded
+        app.exit(stats["mismatches"].toInt() == 0 ? 0 : 2);
+    });
+
+    const QString path = parser.positionalArguments().first();
+    const double speed = parser.value(speedOption).toDouble();
+    QMetaObject::invokeMethod(&worker, [&worker, path, speed]() { worker.startReplay(path, speed); },
+                              Qt::QueuedConnection);
+
+    return app.exec();
+}